@@ -0,0 +1,598 @@
+/**************************************************************************
+*	cycleBench.c
+*
+*	OBJECTIVE:
+*	Scalability benchmark of the Master Controller's main loop. It runs
+*	mainCycle() from time.c, with syncing.c, messaging.c and the rest of
+*	the MC unchanged, on the virtual clock against the simulated radio
+*	and devices in radioSim.c. For each number of rooms and registers
+*	per room it reports:
+*
+*		control cycles run and their period, mean and worst
+*		control cycles that started later than their deadline
+*		sweep: the time it takes to poll every room once
+*		radio frames, MC and devices, per control cycle
+*		host CPU time per control cycle
+*		actuation: the time from a flow decision in adjustReg() to every
+*		register of the room acknowledging it, mean and worst
+*		handoff: with -m, the time from the menu asking for the radio to
+*		the main loop handing it over, mean and worst
+*
+*	Every run starts from a freshly booted MC with the hvac on auto and
+*	every room two degrees off its set temperature, so the hvac runs and
+*	every register is actuated. The readings do not change unless -w is
+*	given, so after the first actuation the registers are only sent their
+*	refreshes. With -w every thermostat steps between 70F and 73F and
+*	rooms keep opening and closing their registers. The
+*	simulated devices answer the original protocol only, the way devices
+*	that reported no capabilities during pairing are driven.
+*
+*	Register addresses are 7 bits and 0x01 is the MC, so a network has
+*	at most simMaxRegs registers in all. Topologies with more are
+*	skipped.
+*
+*	Built on any host from the repository root:
+*
+*		gcc -O2 -Ibench -o cycleBench bench/cycleBench.c bench/radioSim.c bench/simClock.c
+*			time.c syncing.c messaging.c menufunctions.c setups.c -lpthread -lm
+*		cycleBench [-r 1,5,15,30,60,125] [-g 1,2,4,8] [-l 0] [-p 1] [-w 0] [-m 0] [-t seconds]
+*			[-s seed] [-o file.csv]
+*
+*		-r		room counts to run
+*		-g		registers per room to run
+*		-l		% of frames lost to run
+*		-p		msgPriority settings to run, (1) by class (0) in queued order
+*		-w		seconds per 1F step of the readings, (0) fixed
+*		-m		mean ms between the menu's requests for the radio, (0) none.
+*				There is no menu thread on the virtual clock: an event
+*				source asks for the radio the way radioTake() does and
+*				gives it back with radioGive() as soon as it has it, so
+*				the main loop hands over through the same code as on the Pi.
+*		-t		virtual seconds each run lasts
+*		-s		seed for the loss and device timing
+*		-o		also write the results as CSV, one line per run
+*
+*	FUNCTIONS:
+*		parseList()		- reads a comma separated list of numbers
+*		buildNetwork()	- pairs the simulated devices into devices[][]
+*		menuGap()		- random time between the menu's requests
+*		menuNext()		- the time the menu next asks for or gives back the radio
+*		menuFire()		- the menu asks for or gives back the radio
+*		runCycles()		- runs one topology
+*		runBench()		- runs one topology in a child process
+*		LCD and GPIO expander stand-ins
+*		main()
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "wiringPi.h"
+#include "radioSim.h"
+#include "simClock.h"
+#include "../finalHeader.h"
+#include "../messaging.h"
+#include "../clockWait.h"
+
+#define maxList			16		// entries in a -r, -g, -l or -p list
+#define mcAddr			0x01	// address the benchmark's MC uses
+
+// finalMain.c's globals, the benchmark stands in for main()
+int page;
+int line;
+int lcdhdl;
+int set;
+int entry;
+int hour;
+int min;
+int day;
+char dayTime[2];
+int devNumber;
+int dutyMode = 0;
+int beaconInterval = beaconDefault;
+int pollStale = staleDefault;
+
+extern unsigned char myAddr;
+extern int init;
+extern unsigned char devices[rows][columns];
+extern int hvacSetting;
+extern unsigned int nextPoll[126];
+extern unsigned int pollEvery[126];
+extern int pollTemp[126];
+extern int taskRuns[taskCount];
+extern int taskMisses[taskCount];
+extern unsigned int phaseRuns[phaseCount];
+extern unsigned int taskNext[taskCount];
+extern int msgPriority;
+extern unsigned int actCount;
+extern unsigned int actTotal;
+extern unsigned int actMax;
+extern volatile int radioWanted;
+extern volatile int radioHeld;
+extern volatile unsigned int radioAskedAt;
+extern pthread_mutex_t radioMutex;
+extern pthread_cond_t radioCond;
+extern unsigned int handoffRuns;
+extern unsigned int handoffMax;
+extern unsigned long long handoffTotal;
+
+FILE *out;			// the report, the MC's printf() output is discarded
+int menuEvery = 0;	// mean ms between the menu's requests for the radio
+unsigned long long menuAt = clockIdle;	// clockNow() of the next request
+unsigned int menuSeed = 1;	// own random numbers, messaging.c reseeds rand() with the wall clock
+
+struct benchResult
+{
+	int rooms;
+	int regs;			// per room
+	int loss;
+	int prio;			// msgPriority
+	int swing;			// seconds per 1F step of the readings
+	int menu;			// mean ms between the menu's requests for the radio
+	int cycles;			// control task runs
+	int missed;			// control task runs that started after their deadline
+	double periodMs;	// mean ms between control task runs
+	double worstMs;		// longest ms between control task runs
+	double sweepMs;		// ms to poll every room once
+	double frames;		// frames sent by the MC and the devices per control cycle
+	double cpuUs;		// host CPU time per control cycle
+	unsigned int acts;		// flow changes acknowledged
+	double actMs;		// mean ms from a flow decision to its acknowledgement
+	unsigned int actMaxMs;
+	unsigned int handoffs;	// radio handoffs to the menu
+	double handoffMs;	// mean ms from a request to its handoff
+	double handoffMaxMs;
+	unsigned int passes;	// mainCycle() calls
+	unsigned int lost;
+	unsigned int missedFrames;
+};
+
+/**************************************************************************
+*	parseList()
+*
+*	PARAMETERS:
+*		Input:	char pointer to the list, e.g. "1,10,125"
+*				int pointer to the array to fill, maxList entries
+*		Output: integer number of entries
+*
+**************************************************************************/
+int parseList(char *text, int *list)
+{
+	int n = 0;
+	char *item = strtok(text, ",");
+
+	while((item != NULL) && (n < maxList))
+	{
+		list[n++] = atoi(item);
+		item = strtok(NULL, ",");
+	}
+	return n;
+}
+
+/**************************************************************************
+*	buildNetwork()
+*
+*	Fills devices[][] with the simulated thermostats and their registers
+*	in the layout populateArrays() builds from a system sync, then makes
+*	every room due for a poll as populateArrays() does. initMC() and its
+*	pairing are not run: they are the same at any size and would need
+*	the devices' side of the sync.
+*
+*	PARAMETERS:
+*		Input:	int rooms
+*				int registers per room
+*		Output: none
+*
+**************************************************************************/
+void buildNetwork(int rooms, int regs)
+{
+	int i;
+	int j;
+
+	devices[0][0] = rooms;
+	for(i = 1; i <= rooms; i++)
+	{
+		devices[i][0] = simAddr(i - 1);
+		devices[0][i] = regs;
+		for(j = 1; j <= regs; j++)
+		{
+			devices[i][j] = simRegAddr(((i - 1) * regs) + (j - 1));
+		}
+		pushGroup(i);
+		nextPoll[i] = millis();
+		pollEvery[i] = pollPeriod;
+		pollTemp[i] = -999;
+	}
+	markAllRooms();
+	updateRoutes();
+	return;
+}
+
+/**************************************************************************
+*	menuGap()
+*
+*	Returns the us to the menu's next request, from 1 ms to twice
+*	menuEvery at random.
+*
+**************************************************************************/
+unsigned long long menuGap(void)
+{
+	menuSeed ^= menuSeed << 13;
+	menuSeed ^= menuSeed >> 17;
+	menuSeed ^= menuSeed << 5;
+	return ((unsigned long long)(menuSeed % (2 * menuEvery)) + 1) * 1000ULL;
+}
+
+/**************************************************************************
+*	menuNext()
+*
+*	Event source of the menu's requests for the radio, see clockAttach().
+*	Once the main loop has parked, giving the radio back is due at once.
+*
+**************************************************************************/
+unsigned long long menuNext(void)
+{
+	return radioHeld ? clockNow() : menuAt;
+}
+
+/**************************************************************************
+*	menuFire()
+*
+*	Gives the radio back with radioGive() once the main loop has parked.
+*	Otherwise asks for it the way radioTake() does, unless the last
+*	request is still waiting, and picks the time of the next one.
+*	radioTake() itself would wait for the main loop, which only runs
+*	once this event returns.
+*
+**************************************************************************/
+void menuFire(void)
+{
+	if(radioHeld)
+	{
+		radioGive();
+		return;
+	}
+	pthread_mutex_lock(&radioMutex);
+	if(!radioWanted)
+	{
+		radioAskedAt = micros();
+		radioWanted = 1;
+		clockWake(&radioCond);
+	}
+	pthread_mutex_unlock(&radioMutex);
+	menuAt = clockNow() + menuGap();
+	return;
+}
+
+/**************************************************************************
+*	runCycles()
+*
+*	Boots the MC against a fresh simulated network and runs the main loop
+*	for the given virtual time. The clock thread of finalMain.c is
+*	replaced by an updateTime() call after every pass.
+*
+*	PARAMETERS:
+*		Input:	struct benchResult pointer, rooms, regs, loss, prio, swing
+*				and menu set
+*				int virtual seconds to run
+*				unsigned int seed
+*		Output: none
+*
+**************************************************************************/
+void runCycles(struct benchResult *res, int seconds, unsigned int seed)
+{
+	struct simStats stats;
+	unsigned int end;
+	unsigned int passStart;
+	unsigned int first = 0;
+	unsigned int last = 0;
+	unsigned int polls;
+	int runs;
+	clock_t cpu;
+
+	simReset(res->rooms, res->loss, seed);
+	simRegisters(res->rooms * res->regs);
+	simSwing(res->swing);
+	msgPriority = res->prio;
+	init = 0;
+	initRF();
+	myAddr = mcAddr;
+	rxMode();
+
+	bootSequence();
+	buildNetwork(res->rooms, res->regs);
+	hvacSetting = 0;	// auto, the simulated thermostats read 2 F off their set temperature
+	page = 0;
+	line = 0;
+	initTasks();
+
+	runs = taskRuns[taskControl];
+	polls = phaseRuns[phasePoll];
+	end = millis() + (seconds * 1000);
+	taskNext[taskStats] = end + statsPeriod;	// printActStats() would clear the counters read below
+	if(res->menu > 0)
+	{
+		menuEvery = res->menu;
+		menuSeed = seed ? seed : 1;
+		menuAt = clockNow() + menuGap();
+		clockAttach(menuNext, menuFire);
+	}
+	cpu = clock();
+	while((int)(end - millis()) > 0)
+	{
+		passStart = millis();
+		mainCycle();
+		updateTime();
+		res->passes++;
+		if(taskRuns[taskControl] != runs)
+		{
+			// the control task is the first one a pass runs
+			if(res->cycles && ((passStart - last) > res->worstMs))
+			{
+				res->worstMs = passStart - last;
+			}
+			if(!res->cycles)
+			{
+				first = passStart;
+			}
+			last = passStart;
+			res->cycles++;
+			runs = taskRuns[taskControl];
+		}
+	}
+	cpu = clock() - cpu;
+	simGetStats(&stats);
+
+	polls = phaseRuns[phasePoll] - polls;
+	res->missed = taskMisses[taskControl];
+	res->periodMs = (res->cycles > 1) ? (last - first) / (double)(res->cycles - 1) : 0;
+	res->sweepMs = polls ? (seconds * 1000.0 * res->rooms) / polls : 0;
+	res->frames = res->cycles ? (stats.mcTx + stats.devTx) / (double)res->cycles : 0;
+	res->cpuUs = res->cycles ? (cpu * 1000000.0 / CLOCKS_PER_SEC) / res->cycles : 0;
+	res->lost = stats.lost;
+	res->missedFrames = stats.missed;
+	res->acts = actCount;
+	res->actMs = actCount ? actTotal / (double)actCount : 0;
+	res->actMaxMs = actMax;
+	res->handoffs = handoffRuns;
+	res->handoffMs = handoffRuns ? handoffTotal / (1000.0 * handoffRuns) : 0;
+	res->handoffMaxMs = handoffMax / 1000.0;
+	return;
+}
+
+/**************************************************************************
+*	runBench()
+*
+*	Runs one topology in a child process, so every run starts from the
+*	MC's initial state and virtual time 0.
+*
+*	PARAMETERS:
+*		Input:	struct benchResult pointer, rooms, regs, loss, prio, swing
+*				and menu set
+*				int virtual seconds to run
+*				unsigned int seed
+*		Output: integer (1) ran (0) the child failed
+*
+**************************************************************************/
+int runBench(struct benchResult *res, int seconds, unsigned int seed)
+{
+	int pipeFd[2];
+	int status;
+	pid_t child;
+	int got;
+
+	if(pipe(pipeFd))
+	{
+		return 0;
+	}
+	fflush(NULL);
+	child = fork();
+	if(child < 0)
+	{
+		close(pipeFd[0]);
+		close(pipeFd[1]);
+		return 0;
+	}
+	if(child == 0)
+	{
+		close(pipeFd[0]);
+		runCycles(res, seconds, seed);
+		got = (write(pipeFd[1], res, sizeof(*res)) == sizeof(*res));
+		_exit(got ? 0 : 1);
+	}
+	close(pipeFd[1]);
+	got = (read(pipeFd[0], res, sizeof(*res)) == sizeof(*res));
+	close(pipeFd[0]);
+	waitpid(child, &status, 0);
+	return got && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+// No display or buttons on a host: the LCD and GPIO expander do nothing
+int lcdInit(int lines, int width, int bits, int rs, int strb,
+	int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7)
+{
+	return 0;
+}
+
+void lcdClear(int fd)
+{
+	return;
+}
+
+void lcdPosition(int fd, int x, int y)
+{
+	return;
+}
+
+void lcdPuts(int fd, const char *string)
+{
+	return;
+}
+
+void lcdPrintf(int fd, const char *message, ...)
+{
+	return;
+}
+
+int mcp23017Setup(int pinBase, int i2cAddress)
+{
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct benchResult res;
+	FILE *csv = NULL;
+	char *csvPath = NULL;
+	char roomText[] = "1,5,15,30,60,125";
+	char regText[] = "1,2,4,8";
+	char lossText[] = "0";
+	char prioText[] = "1";
+	int roomList[maxList];
+	int regList[maxList];
+	int lossList[maxList];
+	int prioList[maxList];
+	int roomCount;
+	int regCount;
+	int lossCount;
+	int prioCount;
+	int swing = 0;
+	int menu = 0;
+	int seconds = 600;
+	unsigned int seed = 1;
+	int r;
+	int g;
+	int l;
+	int p;
+	int i;
+
+	roomCount = parseList(roomText, roomList);
+	regCount = parseList(regText, regList);
+	lossCount = parseList(lossText, lossList);
+	prioCount = parseList(prioText, prioList);
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "-r") && (i + 1 < argc))
+		{
+			roomCount = parseList(argv[++i], roomList);
+		}
+		else if(!strcmp(argv[i], "-g") && (i + 1 < argc))
+		{
+			regCount = parseList(argv[++i], regList);
+		}
+		else if(!strcmp(argv[i], "-l") && (i + 1 < argc))
+		{
+			lossCount = parseList(argv[++i], lossList);
+		}
+		else if(!strcmp(argv[i], "-p") && (i + 1 < argc))
+		{
+			prioCount = parseList(argv[++i], prioList);
+		}
+		else if(!strcmp(argv[i], "-w") && (i + 1 < argc))
+		{
+			swing = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-m") && (i + 1 < argc))
+		{
+			menu = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-t") && (i + 1 < argc))
+		{
+			seconds = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-s") && (i + 1 < argc))
+		{
+			seed = strtoul(argv[++i], NULL, 0);
+		}
+		else if(!strcmp(argv[i], "-o") && (i + 1 < argc))
+		{
+			csvPath = argv[++i];
+		}
+		else
+		{
+			printf("usage: %s [-r 1,5,15,30,60,125] [-g 1,2,4,8] [-l 0] [-p 1] [-w 0] [-m 0] [-t seconds] [-s seed] [-o file.csv]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(seconds < 1)
+	{
+		printf("seconds must be at least 1\n");
+		return 1;
+	}
+	if(csvPath != NULL)
+	{
+		csv = fopen(csvPath, "w");
+		if(csv == NULL)
+		{
+			printf("%s could not be opened\n", csvPath);
+			return 1;
+		}
+		fprintf(csv, "rooms,regs_per_room,loss_pct,msg_priority,swing_s,virtual_s,passes,control_cycles,control_missed,"
+		"period_ms,worst_period_ms,sweep_ms,frames_per_cycle,cpu_us_per_cycle,frames_lost,frames_missed,"
+		"actuations,actuation_ms,worst_actuation_ms,menu_ms,handoffs,handoff_ms,worst_handoff_ms\n");
+	}
+
+	// Keep the report, drop the MC's printf() output
+	out = fdopen(dup(fileno(stdout)), "w");
+	if((out == NULL) || (freopen("/dev/null", "w", stdout) == NULL))
+	{
+		return 1;
+	}
+
+	fprintf(out, "rooms regs loss%% prio  cycles missed  period ms   worst ms   sweep ms  frames/cycle  cpu us/cycle"
+		"   acts  act ms  worst act ms  handoffs  handoff ms  worst handoff ms\n");
+	for(r = 0; r < roomCount; r++)
+	{
+		for(g = 0; g < regCount; g++)
+		{
+			for(l = 0; l < lossCount; l++)
+			{
+				for(p = 0; p < prioCount; p++)
+				{
+					memset(&res, 0, sizeof(res));
+					res.rooms = (roomList[r] < 1) ? 1 : (roomList[r] > simMaxDevs) ? simMaxDevs : roomList[r];
+					res.regs = (regList[g] < 0) ? 0 : regList[g];
+					res.loss = lossList[l];
+					res.prio = (prioList[p] != 0);
+					res.swing = swing;
+					res.menu = menu;
+					if(res.rooms * res.regs > simMaxRegs)
+					{
+						fprintf(out, "%5d %4d %5d %4d  skipped, %d registers is over the %d register addresses\n",
+							res.rooms, res.regs, res.loss, res.prio, res.rooms * res.regs, simMaxRegs);
+						fflush(out);
+						continue;
+					}
+					if(!runBench(&res, seconds, seed))
+					{
+						fprintf(out, "%5d %4d %5d %4d  run failed\n", res.rooms, res.regs, res.loss, res.prio);
+						fflush(out);
+						continue;
+					}
+					fprintf(out, "%5d %4d %5d %4d  %6d %6d %10.1f %10.1f %10.1f %13.1f %13.1f %6u %7.1f %13u %9u %11.1f %17.1f\n",
+						res.rooms, res.regs, res.loss, res.prio, res.cycles, res.missed, res.periodMs,
+						res.worstMs, res.sweepMs, res.frames, res.cpuUs, res.acts, res.actMs, res.actMaxMs,
+						res.handoffs, res.handoffMs, res.handoffMaxMs);
+					fflush(out);
+					if(csv != NULL)
+					{
+						fprintf(csv, "%d,%d,%d,%d,%d,%d,%u,%d,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%u,%u,%u,%.1f,%u,%d,%u,%.1f,%.1f\n",
+							res.rooms, res.regs, res.loss, res.prio, res.swing, seconds, res.passes, res.cycles,
+							res.missed, res.periodMs, res.worstMs, res.sweepMs, res.frames, res.cpuUs,
+							res.lost, res.missedFrames, res.acts, res.actMs, res.actMaxMs,
+							res.menu, res.handoffs, res.handoffMs, res.handoffMaxMs);
+					}
+				}
+			}
+		}
+	}
+	if(csv != NULL)
+	{
+		fclose(csv);
+	}
+	fclose(out);
+	return 0;
+}
@@ -0,0 +1,20 @@
+/**************************************************************************
+*	lcd.h (bench)
+*
+*	OBJECTIVE:
+*	Stands in for the wiringPi LCD library when the Master Controller
+*	code is built on a host. There is no display, the stand-ins in
+*	cycleBench.c take the output and drop it.
+*
+**************************************************************************/
+#ifndef		BenchLcd_H
+#define		BenchLcd_H
+
+int lcdInit(int lines, int width, int bits, int rs, int strb,
+	int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7);
+void lcdClear(int fd);
+void lcdPosition(int fd, int x, int y);
+void lcdPuts(int fd, const char *string);
+void lcdPrintf(int fd, const char *message, ...);
+
+#endif
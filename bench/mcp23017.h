@@ -0,0 +1,14 @@
+/**************************************************************************
+*	mcp23017.h (bench)
+*
+*	OBJECTIVE:
+*	Stands in for the wiringPi MCP23017 GPIO expander driver when the
+*	Master Controller code is built on a host. See cycleBench.c.
+*
+**************************************************************************/
+#ifndef		BenchMcp23017_H
+#define		BenchMcp23017_H
+
+int mcp23017Setup(int pinBase, int i2cAddress);
+
+#endif
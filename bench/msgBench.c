@@ -0,0 +1,455 @@
+/**************************************************************************
+*	msgBench.c
+*
+*	OBJECTIVE:
+*	Benchmark of the messaging layer. It runs the Master Controller's
+*	sendMessage() and awaitReply() from messaging.c, unchanged, against
+*	the simulated radio and devices in radioSim.c, and reports for each
+*	workload, device count and frame loss:
+*
+*		exchanges and frames per second of (virtual) air time
+*		request/response latency percentiles
+*		SPI transfers per exchange
+*		retries, failures, and host CPU time per exchange
+*
+*	Built on any host from the repository root:
+*
+*		gcc -O2 -Ibench -o msgBench bench/msgBench.c bench/radioSim.c bench/simClock.c messaging.c -lpthread
+*		msgBench [-w poll|set|listen|both] [-d 1,10,125] [-l 0,10] [-n count] [-r tries] [-p ms]
+*			[-b ms] [-s seed] [-o file.csv]
+*
+*		-w		poll: GET_TEMPS answered by RETURN_TEMPS
+*				set: SET_FLOW answered by its ACK only
+*				listen: a thermostat's getMessage() loop, one call every
+*				simDevPoll, while its sync button is tapped
+*				both: poll and set
+*		-d		device counts to run, every one of them pushing its
+*				temperatures while the exchanges go to each in turn
+*		-l		% of frames lost to run
+*		-n		exchanges per run, spread over the devices in turn
+*		-r		tries per exchange before it counts as failed
+*		-p		ms between each thermostat's pushes, (0) none
+*		-b		ms the sync button is held per tap in listen, every tapEvery
+*		-s		seed for the loss and device timing
+*		-o		also write the results as CSV, one line per run
+*
+*	For listen the latency is that of each getMessage() call, and the
+*	getMessage() histogram of messaging.c is printed below its line.
+*
+*	FUNCTIONS:
+*		parseList()		- reads a comma separated list of numbers
+*		byValue()		- qsort compare on unsigned values
+*		percentile()	- returns a percentile of sorted values
+*		exchange()		- one request and its answer
+*		listen()		- getMessage() calls of a thermostat
+*		runBench()		- runs one workload, device count and loss
+*		main()
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "wiringPi.h"
+#include "radioSim.h"
+#include "../messaging.h"
+
+#define maxList			16		// entries in a -d or -l list
+#define mcAddr			0x01	// address the benchmark's MC uses
+
+// Workloads
+#define wlPoll			1
+#define wlSet			2
+#define wlListen		4
+
+#define thermAddr		0xFE	// address the benchmark takes in listen, past the simulated thermostats
+#define tapEvery		2000	// ms between sync button taps in listen
+
+extern unsigned char myAddr;
+extern int init;
+extern unsigned int getLatHist[getLatBuckets];
+extern unsigned int getLatMax;
+
+FILE *out;			// the report, messaging.c's printf() output is discarded
+
+struct benchResult
+{
+	int workload;
+	int devices;
+	int loss;
+	int count;
+	int ok;
+	int retries;
+	double seconds;		// virtual air time of the run
+	double fps;			// frames sent by the MC and the devices per second
+	double xps;			// exchanges completed per second
+	double p50;			// latency percentiles of completed exchanges, ms
+	double p90;
+	double p99;
+	double max;
+	double spi;			// SPI transfers per exchange
+	double cpuUs;		// host CPU time per exchange
+	unsigned int lost;
+	unsigned int missed;
+	unsigned int hist[getLatBuckets];	// getMessage() calls by duration, listen only
+};
+
+/**************************************************************************
+*	parseList()
+*
+*	PARAMETERS:
+*		Input:	char pointer to the list, e.g. "1,10,125"
+*				int pointer to the array to fill, maxList entries
+*		Output: integer number of entries
+*
+**************************************************************************/
+int parseList(char *text, int *list)
+{
+	int n = 0;
+	char *item = strtok(text, ",");
+
+	while((item != NULL) && (n < maxList))
+	{
+		list[n++] = atoi(item);
+		item = strtok(NULL, ",");
+	}
+	return n;
+}
+
+int byValue(const void *a, const void *b)
+{
+	unsigned int valA = *(unsigned int *)a;
+	unsigned int valB = *(unsigned int *)b;
+
+	return (valA > valB) - (valA < valB);
+}
+
+/**************************************************************************
+*	percentile()
+*
+*	PARAMETERS:
+*		Input:	unsigned int pointer to values sorted in us
+*				int number of values
+*				int percentile wanted
+*		Output: double value in ms, (0) with no values
+*
+**************************************************************************/
+double percentile(unsigned int *sorted, int count, int pct)
+{
+	int i;
+
+	if(count == 0)
+	{
+		return 0;
+	}
+	i = ((count * pct) + 99) / 100 - 1;
+	if(i < 0)
+	{
+		i = 0;
+	}
+	return sorted[i] / 1000.0;
+}
+
+/**************************************************************************
+*	exchange()
+*
+*	PARAMETERS:
+*		Input:	int workload
+*				unsigned char device address
+*				int sequence number, used as the SET_FLOW value
+*		Output: integer (1) answered (0) not
+*
+**************************************************************************/
+int exchange(int workload, unsigned char addr, int seq)
+{
+	unsigned char type = RETURN_TEMPS;
+	int val1;
+	int val2;
+
+	if(workload == wlSet)
+	{
+		return sendMessage(SET_FLOW, addr, (seq % 10) + 1, 0);
+	}
+	if(!sendMessage(GET_TEMPS, addr, 0, 0))
+	{
+		return 0;
+	}
+	return awaitReply(&type, addr, replyWait, &val1, &val2, typeMC);
+}
+
+/**************************************************************************
+*	listen()
+*
+*	Runs a thermostat's receive loop with nothing addressed to it, while
+*	the sync button is tapped for less than syncHold, so no pairing
+*	starts.
+*
+*	PARAMETERS:
+*		Input:	struct benchResult pointer, count set
+*				unsigned int pointer to count latencies in us
+*				int ms the button is held per tap
+*		Output: none
+*
+**************************************************************************/
+void listen(struct benchResult *res, unsigned int *lat, int holdMs)
+{
+	unsigned char type;
+	unsigned char from;
+	unsigned int start;
+	int val1;
+	int val2;
+	int k;
+
+	myAddr = thermAddr;
+	simButton(holdMs, tapEvery);
+	memset(getLatHist, 0, sizeof(getLatHist));
+	getLatMax = 0;
+	for(k = 0; k < res->count; k++)
+	{
+		pairOnButton(typeTherm);
+		start = micros();
+		if(getMessage(&type, &from, &val1, &val2, typeTherm))
+		{
+			answerMessage(typeTherm);
+		}
+		lat[res->ok++] = micros() - start;
+		delay(simDevPoll / 1000);
+	}
+	memcpy(res->hist, getLatHist, sizeof(res->hist));
+	return;
+}
+
+/**************************************************************************
+*	runBench()
+*
+*	PARAMETERS:
+*		Input:	struct benchResult pointer, workload, devices and loss set
+*				int tries per exchange
+*				int ms between each thermostat's pushes
+*				int ms the sync button is held per tap in listen
+*				unsigned int seed
+*		Output: none
+*
+**************************************************************************/
+void runBench(struct benchResult *res, int tries, int pushMs, int holdMs, unsigned int seed)
+{
+	struct simStats stats;
+	unsigned int *lat;
+	unsigned int start;
+	clock_t cpu;
+	int k;
+	int t;
+	int done;
+
+	lat = malloc(res->count * sizeof(unsigned int));
+	if(lat == NULL)
+	{
+		return;
+	}
+	simReset(res->devices, res->loss, seed);
+	init = 0;
+	initRF();
+	myAddr = mcAddr;
+	rxMode();
+	if(res->workload != wlListen)
+	{
+		simPushes(pushMs, mcAddr);
+	}
+
+	res->ok = 0;
+	res->retries = 0;
+	cpu = clock();
+	if(res->workload == wlListen)
+	{
+		listen(res, lat, holdMs);
+	}
+	for(k = 0; (k < res->count) && (res->workload != wlListen); k++)
+	{
+		start = micros();
+		done = 0;
+		for(t = 0; (t < tries) && !done; t++)
+		{
+			if(t)
+			{
+				res->retries++;
+			}
+			done = exchange(res->workload, simAddr(k % res->devices), k);
+		}
+		if(done)
+		{
+			lat[res->ok++] = micros() - start;
+		}
+	}
+	cpu = clock() - cpu;
+	simGetStats(&stats);
+
+	qsort(lat, res->ok, sizeof(unsigned int), byValue);
+	res->seconds = stats.usec / 1000000.0;
+	res->fps = (stats.mcTx + stats.devTx) / res->seconds;
+	res->xps = res->ok / res->seconds;
+	res->p50 = percentile(lat, res->ok, 50);
+	res->p90 = percentile(lat, res->ok, 90);
+	res->p99 = percentile(lat, res->ok, 99);
+	res->max = percentile(lat, res->ok, 100);
+	res->spi = stats.spi / (double)res->count;
+	res->cpuUs = (cpu * 1000000.0 / CLOCKS_PER_SEC) / res->count;
+	res->lost = stats.lost;
+	res->missed = stats.missed;
+	free(lat);
+	return;
+}
+
+int main(int argc, char *argv[])
+{
+	struct benchResult res;
+	FILE *csv = NULL;
+	char *csvPath = NULL;
+	char devText[] = "1,10,125";
+	char lossText[] = "0,10";
+	int devList[maxList];
+	int lossList[maxList];
+	int devCount;
+	int lossCount;
+	int workloads = wlPoll|wlSet;
+	int count = 500;
+	int tries = 3;
+	int pushMs = 30000;
+	int holdMs = 500;
+	unsigned int seed = 1;
+	char *names[wlListen + 1] = {"", "poll", "set", "", "listen"};
+	int w;
+	int d;
+	int l;
+	int i;
+
+	devCount = parseList(devText, devList);
+	lossCount = parseList(lossText, lossList);
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "-w") && (i + 1 < argc))
+		{
+			i++;
+			workloads = !strcmp(argv[i], "poll") ? wlPoll : !strcmp(argv[i], "set") ? wlSet :
+				!strcmp(argv[i], "listen") ? wlListen : (wlPoll|wlSet);
+		}
+		else if(!strcmp(argv[i], "-d") && (i + 1 < argc))
+		{
+			devCount = parseList(argv[++i], devList);
+		}
+		else if(!strcmp(argv[i], "-l") && (i + 1 < argc))
+		{
+			lossCount = parseList(argv[++i], lossList);
+		}
+		else if(!strcmp(argv[i], "-n") && (i + 1 < argc))
+		{
+			count = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-r") && (i + 1 < argc))
+		{
+			tries = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-p") && (i + 1 < argc))
+		{
+			pushMs = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-b") && (i + 1 < argc))
+		{
+			holdMs = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-s") && (i + 1 < argc))
+		{
+			seed = strtoul(argv[++i], NULL, 0);
+		}
+		else if(!strcmp(argv[i], "-o") && (i + 1 < argc))
+		{
+			csvPath = argv[++i];
+		}
+		else
+		{
+			printf("usage: %s [-w poll|set|listen|both] [-d 1,10,125] [-l 0,10] [-n count] [-r tries] [-p ms] [-b ms] [-s seed] [-o file.csv]\n", argv[0]);
+			return 1;
+		}
+	}
+	if((count < 1) || (tries < 1))
+	{
+		printf("count and tries must be at least 1\n");
+		return 1;
+	}
+	if(pushMs < 0)
+	{
+		printf("the push interval cannot be negative\n");
+		return 1;
+	}
+	if((holdMs < 0) || (holdMs >= syncHold))
+	{
+		printf("the button must be held under %d ms\n", syncHold);
+		return 1;
+	}
+	if(csvPath != NULL)
+	{
+		csv = fopen(csvPath, "w");
+		if(csv == NULL)
+		{
+			printf("%s could not be opened\n", csvPath);
+			return 1;
+		}
+		fprintf(csv, "workload,devices,loss_pct,exchanges,ok,retries,air_s,frames_per_s,exchanges_per_s,"
+		"p50_ms,p90_ms,p99_ms,max_ms,spi_per_exchange,cpu_us_per_exchange,frames_lost,frames_missed\n");
+	}
+
+	// Keep the report, drop the messaging layer's printf() output
+	out = fdopen(dup(fileno(stdout)), "w");
+	if((out == NULL) || (freopen("/dev/null", "w", stdout) == NULL))
+	{
+		return 1;
+	}
+
+	fprintf(out, "workload devs loss%%   ok/count retries  frames/s  exch/s    p50 ms    p90 ms    p99 ms    max ms  spi/exch  cpu us\n");
+	for(w = wlPoll; w <= wlListen; w <<= 1)
+	{
+		if(!(workloads & w))
+		{
+			continue;
+		}
+		for(d = 0; d < devCount; d++)
+		{
+			for(l = 0; l < lossCount; l++)
+			{
+				memset(&res, 0, sizeof(res));
+				res.workload = w;
+				res.devices = (devList[d] < 1) ? 1 : (devList[d] > simMaxDevs) ? simMaxDevs : devList[d];
+				res.loss = lossList[l];
+				res.count = count;
+				runBench(&res, tries, pushMs, holdMs, seed);
+
+				fprintf(out, "%-8s %4d %5d %5d/%-5d %7d %9.1f %7.2f %9.1f %9.1f %9.1f %9.1f %9.1f %7.1f\n",
+				names[w], res.devices, res.loss, res.ok, res.count, res.retries,
+				res.fps, res.xps, res.p50, res.p90, res.p99, res.max, res.spi, res.cpuUs);
+				for(i = 0; (w == wlListen) && (i < getLatBuckets); i++)
+				{
+					if(res.hist[i])
+					{
+						fprintf(out, "         getMessage() %s %7uus %u\n", (i < getLatBuckets - 1) ? "< " : ">=",
+							(i < getLatBuckets - 1) ? 1U << i : 1U << (i - 1), res.hist[i]);
+					}
+				}
+				fflush(out);
+				if(csv != NULL)
+				{
+					fprintf(csv, "%s,%d,%d,%d,%d,%d,%.3f,%.2f,%.3f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%u,%u\n",
+					names[w], res.devices, res.loss, res.count, res.ok, res.retries,
+					res.seconds, res.fps, res.xps, res.p50, res.p90, res.p99, res.max, res.spi, res.cpuUs,
+					res.lost, res.missed);
+				}
+			}
+		}
+	}
+	if(csv != NULL)
+	{
+		fclose(csv);
+		fprintf(out, "\nresults written to %s\n", csvPath);
+	}
+	fclose(out);
+	return 0;
+}
@@ -0,0 +1,649 @@
+/**************************************************************************
+*	radioSim.c
+*
+*	OBJECTIVE:
+*	Simulated nRF24L01 and devices for the msgBench benchmark. This file
+*	provides the wiringPiSPI functions and the GPIO side of wiringPi
+*	messaging.c calls. It is an event source of the virtual clock in
+*	simClock.c: delay() moves the clock forward and delivers the frames
+*	due by then, so a run takes as long on the air as it would on the
+*	Raspberry Pi but finishes at host speed.
+*
+*	FUNCTIONS:
+*		simReset()		- starts a run with a number of devices and a loss
+*		simAddr()		- returns the address of a simulated device
+*		simRegisters()	- adds registers to the run
+*		simRegAddr()	- returns the address of a simulated register
+*		simDevOf()		- returns the device at an address
+*		simSwing()		- makes the thermostats' readings drift
+*		simGetStats()	- returns the counters of the current run
+*		simRand()		- repeatable pseudo random numbers
+*		simPost()		- schedules a frame to land
+*		simSend()		- puts a frame on the air, applying the loss
+*		simButton()		- taps the sync button
+*		simPushes()		- makes the thermostats push their temperatures
+*		simPush()		- a thermostat pushes its temperatures
+*		simNextAt()		- returns the time the next frame lands
+*		simIrq()		- sets a STATUS interrupt bit, pulling IRQ low
+*		simFire()		- delivers the next frame
+*		simDevice()		- a device takes a frame and answers it
+*		simStatus()		- builds the STATUS register
+*		simFifoStatus()	- builds the FIFO_STATUS register
+*		wiringPi and wiringPiSPI replacements
+*
+**************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "wiringPi.h"
+#include "wiringPiSPI.h"
+#include "radioSim.h"
+#include "simClock.h"
+#include "../messaging.h"
+
+// Event kinds
+#define evToMC			1		// frame lands at the MC
+#define evToDev			2		// frame lands at a device
+#define evTxDone		3		// the MC's frame has left, TX_DS is set
+#define evButton		4		// the sync button is pressed or released
+#define evPush			5		// a thermostat is due to push its temperatures
+
+struct simEvent
+{
+	unsigned long long at;
+	int kind;
+	int dev;
+	unsigned char frame[11];
+};
+
+unsigned long long simStart = 0;	// clockNow() at simReset()
+int simAttached = 0;				// 1 once the radio is a source of the clock
+struct simEvent simQueue[simEvents];
+int simPending = 0;
+unsigned char simReg[32];			// MC radio registers
+unsigned char simRx[3][11];			// MC RX FIFO
+int simRxCount = 0;
+unsigned char simTx[11];			// MC TX payload
+int simTxLoaded = 0;
+int simTxBusy = 0;
+int simCE = 0;
+int simDevCount = 1;
+int simRegCount = 0;				// registers are devices simMaxDevs and up
+int simLoss = 0;					// % of frames lost
+unsigned int simSeed = 1;
+int simSwingSec = 0;				// seconds per 1F step of the readings, (0) fixed
+int simTapMs = 0;					// ms the sync button is held per tap, (0) never pressed
+int simTapEvery = 0;				// ms from one tap to the next
+int simBtnDown = 0;
+void (*simBtnISR)(void) = NULL;		// set by wiringPiISR()
+void (*simIrqISR)(void) = NULL;		// set by wiringPiISR() when RFIRQ is wired
+int simPushEvery = 0;				// ms between each thermostat's pushes, (0) none
+unsigned char simPushTo;			// address the pushes are sent to
+unsigned long long simBusy[simMaxDevs + simMaxRegs];	// device not listening before this time
+struct simStats simCount;
+
+/**************************************************************************
+*	simReset()
+*
+*	PARAMETERS:
+*		Input:	int number of devices, up to simMaxDevs
+*				int % of frames lost
+*				unsigned int seed for the loss and device poll timing
+*		Output: none
+*
+**************************************************************************/
+void simReset(int devices, int lossPct, unsigned int seed)
+{
+	simDevCount = (devices > simMaxDevs) ? simMaxDevs : devices;
+	simRegCount = 0;
+	simLoss = lossPct;
+	simSeed = seed ? seed : 1;
+	simSwingSec = 0;
+	simTapMs = 0;
+	simBtnDown = 0;
+	simPushEvery = 0;
+	simPending = 0;
+	simRxCount = 0;
+	simTxLoaded = 0;
+	simTxBusy = 0;
+	memset(simReg, 0, sizeof(simReg));
+	memset(simBusy, 0, sizeof(simBusy));
+	memset(&simCount, 0, sizeof(simCount));
+	simStart = clockNow();
+	if(!simAttached)
+	{
+		clockAttach(simNextAt, simFire);
+		simAttached = 1;
+	}
+	return;
+}
+
+unsigned char simAddr(int dev)
+{
+	if(dev >= simMaxDevs)
+	{
+		return regID | (dev - simMaxDevs + 2);
+	}
+	return thermoID | (dev + 1);
+}
+
+/**************************************************************************
+*	simRegisters()
+*
+*	PARAMETERS:
+*		Input:	int number of registers, up to simMaxRegs, answering at
+*				simRegAddr(0) and up. Called after simReset().
+*		Output: none
+*
+**************************************************************************/
+void simRegisters(int regs)
+{
+	simRegCount = (regs > simMaxRegs) ? simMaxRegs : regs;
+	return;
+}
+
+unsigned char simRegAddr(int reg)
+{
+	return simAddr(simMaxDevs + reg);
+}
+
+/**************************************************************************
+*	simSwing()
+*
+*	Thermostats normally read 72F against a 70F setpoint. With a swing
+*	each one steps through 70F to 73F and back down, one step every
+*	swing seconds and staggered by device, so rooms keep crossing their
+*	setpoint and the MC keeps changing register flows.
+*
+*	PARAMETERS:
+*		Input:	int seconds per step, (0) fixed readings. Called after
+*				simReset().
+*		Output: none
+*
+**************************************************************************/
+void simSwing(int seconds)
+{
+	simSwingSec = seconds;
+	return;
+}
+
+/**************************************************************************
+*	simDevOf()
+*
+*	PARAMETERS:
+*		Input:	unsigned char address
+*		Output: integer device at that address in this run, (-1) none
+*
+**************************************************************************/
+int simDevOf(unsigned char addr)
+{
+	int n;
+
+	if(addr & thermoID)
+	{
+		n = (addr & 0x7F) - 1;
+		return ((n >= 0) && (n < simDevCount)) ? n : -1;
+	}
+	n = addr - 2;
+	return ((n >= 0) && (n < simRegCount)) ? simMaxDevs + n : -1;
+}
+
+void simGetStats(struct simStats *stats)
+{
+	*stats = simCount;
+	stats->usec = clockNow() - simStart;
+	return;
+}
+
+unsigned int simRand(void)
+{
+	simSeed ^= simSeed << 13;
+	simSeed ^= simSeed >> 17;
+	simSeed ^= simSeed << 5;
+	return simSeed;
+}
+
+void simPost(unsigned long long at, int kind, int dev, unsigned char *frame)
+{
+	if(simPending == simEvents)
+	{
+		simCount.lost++;
+		return;
+	}
+	simQueue[simPending].at = at;
+	simQueue[simPending].kind = kind;
+	simQueue[simPending].dev = dev;
+	if(frame != NULL)
+	{
+		memcpy(simQueue[simPending].frame, frame, 11);
+	}
+	simPending++;
+	return;
+}
+
+/**************************************************************************
+*	simSend()
+*
+*	PARAMETERS:
+*		Input:	unsigned long long time the frame lands
+*				int evToMC or evToDev
+*				int device the frame is for (evToDev)
+*				unsigned char pointer to the frame
+*		Output: none
+*
+**************************************************************************/
+void simSend(unsigned long long at, int kind, int dev, unsigned char *frame)
+{
+	if((simRand() % 100) < simLoss)
+	{
+		simCount.lost++;
+		return;
+	}
+	simPost(at, kind, dev, frame);
+	return;
+}
+
+/**************************************************************************
+*	simButton()
+*
+*	Taps the sync button: it goes down every tap interval and comes back
+*	up after the hold time. digitalRead() of SyncBtn follows it and the
+*	handler given to wiringPiISR() runs on both edges.
+*
+*	PARAMETERS:
+*		Input:	int ms the button is held per tap, (0) never pressed
+*				int ms from one tap to the next
+*				Called after simReset().
+*		Output: none
+*
+**************************************************************************/
+void simButton(int holdMs, int everyMs)
+{
+	simTapMs = holdMs;
+	simTapEvery = (everyMs > holdMs) ? everyMs : holdMs + 1;
+	if(simTapMs)
+	{
+		simPost(clockNow() + (simTapEvery * 1000ULL), evButton, 0, NULL);
+	}
+	return;
+}
+
+/**************************************************************************
+*	simPushes()
+*
+*	Every thermostat pushes an unsolicited RETURN_TEMPS to the MC once
+*	per interval, each at its own random phase, like subscribed
+*	thermostats reporting their changes. A push is traffic the MC has to
+*	take and ACK whichever device it is waiting on, so it grows with the
+*	number of devices.
+*
+*	PARAMETERS:
+*		Input:	int ms between each thermostat's pushes, (0) none
+*				unsigned char address of the MC
+*				Called after simReset().
+*		Output: none
+*
+**************************************************************************/
+void simPushes(int everyMs, unsigned char mc)
+{
+	int dev;
+
+	simPushEvery = everyMs;
+	simPushTo = mc;
+	for(dev = 0; (dev < simDevCount) && (everyMs > 0); dev++)
+	{
+		simPost(clockNow() + (simRand() % (everyMs * 1000ULL)), evPush, dev, NULL);
+	}
+	return;
+}
+
+/**************************************************************************
+*	simPush()
+*
+*	A thermostat pushes its temperatures unless it is busy with the MC,
+*	then waits for its next interval.
+*
+**************************************************************************/
+void simPush(int dev)
+{
+	unsigned char out[11];
+
+	simPost(clockNow() + (simPushEvery * 1000ULL), evPush, dev, NULL);
+	if(clockNow() < simBusy[dev])
+	{
+		return;
+	}
+	memset(out, 0, sizeof(out));
+	out[0] = simPushTo;
+	out[1] = simAddr(dev);
+	out[2] = RETURN_TEMPS;
+	out[6] = 72;
+	out[10] = 70;
+	simCount.devTx++;
+	simSend(clockNow() + simAirUs, evToMC, dev, out);
+	simBusy[dev] = clockNow() + simAirUs + simBusyUs;
+	return;
+}
+
+/**************************************************************************
+*	simDevice()
+*
+*	A device reads the frame on its next poll, ACKs it like answerMessage()
+*	and, for a request, sends the reply like sendMessage(). ACKs for its
+*	own replies are only taken. It does not listen while it is busy.
+*
+**************************************************************************/
+void simDevice(int dev, unsigned char *frame)
+{
+	unsigned char out[11];
+	unsigned long long read;
+	unsigned long long ack;
+	unsigned char reply = 0;
+	int step;
+
+	if(clockNow() < simBusy[dev])
+	{
+		simCount.missed++;
+		return;
+	}
+	if((frame[2] == ACK) || (msgTable[frame[2]].flags & msgQuiet))
+	{
+		return;
+	}
+	switch(frame[2])
+	{
+		case SEND_BYTE:			reply = RETURN_BYTE;		break;
+		case GET_TEMPS:			reply = RETURN_TEMPS;		break;
+		case GET_HUM:			reply = RETURN_HUM;			break;
+		case GET_FLOW:			reply = RETURN_FLOW;		break;
+		case GET_SYNC_STATS:	reply = RETURN_SYNC_STATS;	break;
+		case GET_TELEMETRY:		reply = RETURN_TELEMETRY;	break;
+		case GET_BATCH:			reply = RETURN_BATCH;		break;
+	}
+
+	read = clockNow() + (simRand() % simDevPoll);
+	ack = read + simAckUs;
+	memset(out, 0, sizeof(out));
+	out[0] = frame[1];
+	out[1] = frame[0];
+	out[2] = ACK;
+	out[6] = frame[2];
+	memcpy(&out[7], &frame[3], 4);
+	simCount.devTx++;
+	simSend(ack, evToMC, dev, out);
+	simBusy[dev] = ack + simBusyUs;
+
+	if(reply)
+	{
+		memset(out, 0, sizeof(out));
+		out[0] = frame[1];
+		out[1] = frame[0];
+		out[2] = reply;
+		out[6] = 72;
+		out[10] = 70;
+		if(simSwingSec)
+		{
+			step = (int)((clockNow() - simStart)/(1000000ULL*simSwingSec)) + dev;
+			out[6] = 70 + ((step % 6 < 4) ? step % 6 : 6 - step % 6);
+		}
+		simCount.devTx++;
+		simSend(ack + simReplyUs, evToMC, dev, out);
+		simBusy[dev] = ack + simReplyUs + simBusyUs;
+	}
+	return;
+}
+
+/**************************************************************************
+*	simNextAt()
+*
+*	Returns the time the earliest frame or TX_DS in flight is due, or
+*	clockIdle if there is none.
+*
+**************************************************************************/
+unsigned long long simNextAt(void)
+{
+	unsigned long long at = clockIdle;
+	int i;
+
+	for(i = 0; i < simPending; i++)
+	{
+		if(simQueue[i].at < at)
+		{
+			at = simQueue[i].at;
+		}
+	}
+	return at;
+}
+
+/**************************************************************************
+*	simIrq()
+*
+*	Sets RX_DR or TX_DS. The nRF24L01 holds IRQ low while any of them is
+*	set, so the handler given to wiringPiISR() for RFIRQ runs only when
+*	none was set before, on the falling edge.
+*
+**************************************************************************/
+void simIrq(unsigned char bit)
+{
+	int low = simReg[STATUS] & 0x70;
+
+	simReg[STATUS] |= bit;
+	if(!low && (simIrqISR != NULL))
+	{
+		simIrqISR();
+	}
+	return;
+}
+
+/**************************************************************************
+*	simFire()
+*
+*	Handles the earliest event in flight. simClock.c has already moved
+*	the clock to its time.
+*
+**************************************************************************/
+void simFire(void)
+{
+	struct simEvent ev;
+	int i;
+	int next = 0;
+
+	if(simPending == 0)
+	{
+		return;
+	}
+	for(i = 1; i < simPending; i++)
+	{
+		if(simQueue[i].at < simQueue[next].at)
+		{
+			next = i;
+		}
+	}
+	ev = simQueue[next];
+	simQueue[next] = simQueue[--simPending];
+
+	if(ev.kind == evPush)
+	{
+		simPush(ev.dev);
+	}
+	else if(ev.kind == evButton)
+	{
+		simBtnDown = !simBtnDown;
+		simPost(clockNow() + (simBtnDown ? simTapMs : simTapEvery - simTapMs) * 1000ULL, evButton, 0, NULL);
+		if(simBtnISR != NULL)
+		{
+			simBtnISR();
+		}
+	}
+	else if(ev.kind == evTxDone)
+	{
+		simIrq(0x20);
+		simTxBusy = 0;
+	}
+	else if(ev.kind == evToDev)
+	{
+		simDevice(ev.dev, ev.frame);
+	}
+	else if(simCE && ((simReg[CONFIG] & 0x03) == 0x03) && !simTxBusy && (simRxCount < 3))
+	{
+		memcpy(simRx[simRxCount++], ev.frame, 11);
+		simIrq(0x40);
+		simCount.mcRx++;
+	}
+	else
+	{
+		simCount.missed++;	// MC not in RX mode, or its FIFO is full
+	}
+	return;
+}
+
+unsigned char simStatus(void)
+{
+	return (simReg[STATUS] & 0x70)|(simRxCount ? 0x00 : 0x0E)|(simTxLoaded ? 0x01 : 0x00);
+}
+
+unsigned char simFifoStatus(void)
+{
+	return (simTxLoaded ? 0x20 : 0x10)|((simRxCount == 3) ? 0x02 : 0x00)|(simRxCount ? 0x00 : 0x01);
+}
+
+/**************************************************************************
+*	wiringPiSPIDataRW()
+*
+*	Takes one SPI transfer to the MC's radio. The STATUS register is
+*	returned in the first byte, as the nRF24L01 does.
+*
+**************************************************************************/
+int wiringPiSPIDataRW(int channel, unsigned char *data, int len)
+{
+	unsigned char cmd = data[0];
+	int reg = cmd & 0x1F;
+
+	simCount.spi++;
+	clockRun(clockNow());
+
+	if(cmd == R_RX_PAYLOAD)
+	{
+		if(simRxCount)
+		{
+			memcpy(&data[1], simRx[0], (len > 12) ? 11 : len - 1);
+			memmove(simRx[0], simRx[1], 2 * 11);
+			simRxCount--;
+		}
+	}
+	else if(cmd == W_TX_PAYLOAD)
+	{
+		memcpy(simTx, &data[1], 11);
+		simTxLoaded = 1;
+	}
+	else if(cmd == FLUSH_TX)
+	{
+		simTxLoaded = 0;
+	}
+	else if(cmd == FLUSH_RX)
+	{
+		simRxCount = 0;
+	}
+	else if((cmd & 0xE0) == W_REGISTER)
+	{
+		if(reg == STATUS)
+		{
+			simReg[STATUS] &= ~(data[1] & 0x70);
+		}
+		else
+		{
+			simReg[reg] = data[1];
+		}
+	}
+	else if((cmd & 0xE0) == R_REGISTER)
+	{
+		data[1] = (reg == STATUS) ? simStatus() : (reg == FIFO_STATUS) ? simFifoStatus() : simReg[reg];
+	}
+	data[0] = simStatus();
+	return len;
+}
+
+int wiringPiSPISetup(int channel, int speed)
+{
+	return 0;
+}
+
+/**************************************************************************
+*	digitalWrite()
+*
+*	A rising CE edge with the radio powered up in TX mode sends the TX
+*	payload to the device it is addressed to.
+*
+**************************************************************************/
+void digitalWrite(int pin, int value)
+{
+	int dev;
+
+	if(pin != CE)
+	{
+		return;
+	}
+	if(value && !simCE && ((simReg[CONFIG] & 0x03) == 0x02) && simTxLoaded)
+	{
+		simTxLoaded = 0;
+		simTxBusy = 1;
+		simCount.mcTx++;
+		simPost(clockNow() + simAirUs, evTxDone, 0, NULL);
+		dev = simDevOf(simTx[0]);
+		if(dev >= 0)
+		{
+			simSend(clockNow() + simAirUs, evToDev, dev, simTx);
+		}
+	}
+	simCE = value;
+	return;
+}
+
+// Threads do not run. The sync button is the only GPIO input, see simButton()
+int wiringPiSetupGpio(void)
+{
+	return 0;
+}
+
+void pinMode(int pin, int mode)
+{
+	return;
+}
+
+int digitalRead(int pin)
+{
+	// the button pulls SyncBtn low while it is held
+	return ((pin == SyncBtn) && simBtnDown) ? LOW : HIGH;
+}
+
+int piThreadCreate(void *(*fn)(void *))
+{
+	return 0;
+}
+
+void piLock(int key)
+{
+	return;
+}
+
+void piUnlock(int key)
+{
+	return;
+}
+
+int piHiPri(int pri)
+{
+	return 0;
+}
+
+int wiringPiISR(int pin, int edgeType, void (*function)(void))
+{
+	if(pin == SyncBtn)
+	{
+		simBtnISR = function;
+	}
+	else if(pin == RFIRQ)
+	{
+		simIrqISR = function;
+	}
+	return 0;
+}
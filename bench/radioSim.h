@@ -0,0 +1,54 @@
+/**************************************************************************
+*	radioSim.h
+*
+*	OBJECTIVE:
+*	This file defines the simulated radio network the msgBench benchmark
+*	runs messaging.c against. It runs on the virtual clock in simClock.c.
+*
+*	DEFINITIONS:
+*	The Master Controller's nRF24L01 is modelled at the SPI level, so
+*	messaging.c runs unchanged. The devices on the other end are modelled
+*	by their timing only, thermostats and registers alike: how long after
+*	a frame arrives each one has its ACK and its reply on the air. Those
+*	times follow the device side of getMessage() and sendMessage(), where
+*	every SPI transfer costs 2 ms of delay(). Every frame is lost with the
+*	configured probability, and a frame also misses a radio that is not
+*	listening when it lands.
+*
+**************************************************************************/
+#ifndef		RadioSim_H
+#define		RadioSim_H
+
+#define simMaxDevs		125		// thermostats 0x81 to 0xFD
+#define simMaxRegs		126		// registers 0x02 to 0x7F, 0x01 is the MC
+#define simEvents		512		// frames in flight or waiting on a device
+#define simAirUs		200		// us from CE to the frame landing: 130 settling + 72 on air at 2Mbps
+#define simDevPoll		10000	// us between a device's getMessage() polls
+#define simAckUs		41000	// us from a device reading a frame to its ACK landing
+#define simReplyUs		18000	// us from that ACK to the device's reply landing
+#define simBusyUs		10000	// us after its last frame before a device listens again
+
+struct simStats
+{
+	unsigned long long usec;	// virtual time
+	unsigned int spi;			// SPI transfers by the MC
+	unsigned int mcTx;			// frames sent by the MC
+	unsigned int mcRx;			// frames that landed in the MC's RX FIFO
+	unsigned int devTx;			// frames sent by the devices
+	unsigned int lost;			// frames dropped by the configured loss
+	unsigned int missed;		// frames that landed while the receiver was not listening
+};
+
+void simReset(int devices, int lossPct, unsigned int seed);
+unsigned char simAddr(int dev);
+void simRegisters(int regs);
+unsigned char simRegAddr(int reg);
+void simSwing(int seconds);
+void simButton(int holdMs, int everyMs);
+void simPushes(int everyMs, unsigned char mc);
+void simGetStats(struct simStats *stats);
+unsigned long long simNextAt(void);
+void simIrq(unsigned char bit);
+void simFire(void);
+
+#endif
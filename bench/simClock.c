@@ -0,0 +1,197 @@
+/**************************************************************************
+*	simClock.c
+*
+*	OBJECTIVE:
+*	Virtual clock for running the Master Controller code on a host. This
+*	file provides the wiringPi time functions on a clock that only moves
+*	when the code waits: delay() hands every event due by the new time to
+*	the simulated hardware, in time order, then returns at once. It is
+*	also the virtual backend of the waits in clockWait.h.
+*
+*	FUNCTIONS:
+*		clockAttach()	- adds an event source
+*		clockNow()		- returns the virtual time in us
+*		clockStep()		- fires the next event due, if any
+*		clockRun()		- moves the clock forward, firing events due
+*		delay(), delayMicroseconds(), millis(), micros()
+*		clockCondInit(), clockWait(), clockWake()
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "wiringPi.h"
+#include "simClock.h"
+#include "../clockWait.h"
+
+unsigned long long clockUs = 0;		// virtual time in us, never goes back
+unsigned long long (*clockNext[clockSources])(void);
+void (*clockFire[clockSources])(void);
+int clockCount = 0;
+int clockWoken = 0;		// (1) clockWake() was called during a clockWait()
+
+/**************************************************************************
+*	clockAttach()
+*
+*	PARAMETERS:
+*		Input:	function returning the time the source's next event is
+*				due, or clockIdle
+*				function handling that event
+*		Output: none
+*
+**************************************************************************/
+void clockAttach(unsigned long long (*next)(void), void (*fire)(void))
+{
+	if(clockCount == clockSources)
+	{
+		printf("simClock: too many event sources\n");
+		return;
+	}
+	clockNext[clockCount] = next;
+	clockFire[clockCount] = fire;
+	clockCount++;
+	return;
+}
+
+unsigned long long clockNow(void)
+{
+	return clockUs;
+}
+
+/**************************************************************************
+*	clockStep()
+*
+*	Fires the event due first across all sources, moving the clock to
+*	it, if one is due by the given time.
+*
+*	PARAMETERS:
+*		Input:	unsigned long long us the event must be due by
+*		Output: integer (1) an event was fired (0) none is due by then
+*
+**************************************************************************/
+int clockStep(unsigned long long until)
+{
+	unsigned long long at;
+	unsigned long long best = clockIdle;
+	int i;
+	int next = -1;
+
+	for(i = 0; i < clockCount; i++)
+	{
+		at = clockNext[i]();
+		if((at <= until) && (at < best))
+		{
+			best = at;
+			next = i;
+		}
+	}
+	if(next < 0)
+	{
+		return 0;
+	}
+	if(best > clockUs)
+	{
+		clockUs = best;
+	}
+	clockFire[next]();
+	return 1;
+}
+
+/**************************************************************************
+*	clockRun()
+*
+*	Moves the clock to the given time, firing the event due first across
+*	all sources until none is due by then. An event may schedule more
+*	events, which are fired too if they are due in time.
+*
+**************************************************************************/
+void clockRun(unsigned long long until)
+{
+	while(clockStep(until))
+	{
+	}
+	if(until > clockUs)
+	{
+		clockUs = until;
+	}
+	return;
+}
+
+void delay(unsigned int ms)
+{
+	clockRun(clockUs + (ms * 1000ULL));
+	return;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	clockRun(clockUs + us);
+	return;
+}
+
+unsigned int millis(void)
+{
+	return (unsigned int)(clockUs / 1000);
+}
+
+unsigned int micros(void)
+{
+	return (unsigned int)clockUs;
+}
+
+/**************************************************************************
+*	clockCondInit()
+*
+*	The virtual clock has no time of its own to set on the condition
+*	variable, it is set up with the defaults.
+*
+**************************************************************************/
+void clockCondInit(pthread_cond_t *cond)
+{
+	pthread_cond_init(cond, NULL);
+	return;
+}
+
+/**************************************************************************
+*	clockWait()
+*
+*	There is only one thread on the virtual clock, so whatever would
+*	wake it has to be an event. The mutex is let go and events are fired
+*	one at a time until one of them calls clockWake() or the time is up,
+*	the way the thread would sleep through them on the Pi. A wait with no
+*	limit and no event left to fire could never end, so the bench stops.
+*
+*	PARAMETERS:
+*		Input:	pthread_cond_t pointer to the condition variable
+*				pthread_mutex_t pointer to the mutex, locked
+*				int ms to wait at most, clockForever for no limit
+*		Output: integer (1) woken (0) timed out
+*
+**************************************************************************/
+int clockWait(pthread_cond_t *cond, pthread_mutex_t *mutex, int ms)
+{
+	unsigned long long until = (ms < 0) ? clockIdle : clockUs + (ms * 1000ULL);
+
+	clockWoken = 0;
+	pthread_mutex_unlock(mutex);
+	while(!clockWoken && clockStep(until))
+	{
+	}
+	if(!clockWoken)
+	{
+		if(ms < 0)
+		{
+			printf("simClock: waiting forever with no event due\n");
+			exit(1);
+		}
+		clockUs = until;
+	}
+	pthread_mutex_lock(mutex);
+	return clockWoken;
+}
+
+void clockWake(pthread_cond_t *cond)
+{
+	clockWoken = 1;
+	return;
+}
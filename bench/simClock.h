@@ -0,0 +1,31 @@
+/**************************************************************************
+*	simClock.h
+*
+*	OBJECTIVE:
+*	This file defines the virtual clock the Master Controller code runs
+*	on when it is built on a host against the bench wiringPi.h. It is
+*	the virtual backend of the wiringPi time functions every file
+*	already keeps its time with: delay(), delayMicroseconds(), millis()
+*	and micros(). On the Raspberry Pi, wiringPi is the real backend.
+*
+*	DEFINITIONS:
+*	The clock is a discrete-event simulation. Simulated hardware, like
+*	the radio in radioSim.c, attaches itself as an event source that
+*	says when its next event is due and handles it when asked. delay()
+*	moves the clock forward one event at a time, in time order, so
+*	waiting costs no real time and a simulated day runs at host speed.
+*	The waits of clockWait.h are run the same way, see simClock.c.
+*
+**************************************************************************/
+#ifndef		SimClock_H
+#define		SimClock_H
+
+#define clockSources	4		// event sources that may attach
+#define clockIdle		0xFFFFFFFFFFFFFFFFULL	// next event time of a source with nothing due
+
+void clockAttach(unsigned long long (*next)(void), void (*fire)(void));
+unsigned long long clockNow(void);
+int clockStep(unsigned long long until);
+void clockRun(unsigned long long until);
+
+#endif
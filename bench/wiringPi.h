@@ -0,0 +1,40 @@
+/**************************************************************************
+*	wiringPi.h (bench)
+*
+*	OBJECTIVE:
+*	Stands in for wiringPi when the Master Controller code is built on a
+*	host. Time is the virtual clock in simClock.c, so delay() returns at
+*	once and lets the simulated radio and devices run up to the new
+*	time. The GPIO side is in radioSim.c. Waits on a condition variable
+*	go through clockWait.h, which simClock.c implements on the same
+*	clock.
+*
+**************************************************************************/
+#ifndef		BenchWiringPi_H
+#define		BenchWiringPi_H
+
+#define INPUT			0
+#define OUTPUT			1
+#define LOW				0
+#define HIGH			1
+#define INT_EDGE_FALLING	1
+#define INT_EDGE_RISING	2
+#define INT_EDGE_BOTH	3
+
+#define PI_THREAD(X) void *X(void *dummy)
+
+int wiringPiSetupGpio(void);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+void delay(unsigned int ms);
+void delayMicroseconds(unsigned int us);
+unsigned int millis(void);
+unsigned int micros(void);
+int piThreadCreate(void *(*fn)(void *));
+void piLock(int key);
+void piUnlock(int key);
+int piHiPri(int pri);
+int wiringPiISR(int pin, int edgeType, void (*function)(void));
+
+#endif
@@ -0,0 +1,15 @@
+/**************************************************************************
+*	wiringPiSPI.h (bench)
+*
+*	OBJECTIVE:
+*	Stands in for wiringPiSPI in the msgBench benchmark. SPI transfers
+*	go to the simulated nRF24L01 in radioSim.c.
+*
+**************************************************************************/
+#ifndef		BenchWiringPiSPI_H
+#define		BenchWiringPiSPI_H
+
+int wiringPiSPISetup(int channel, int speed);
+int wiringPiSPIDataRW(int channel, unsigned char *data, int len);
+
+#endif
@@ -0,0 +1,85 @@
+/**************************************************************************
+*	clockWait.c
+*
+*	OBJECTIVE:
+*	The Raspberry Pi backend of the waits declared in clockWait.h, on
+*	pthread condition variables timed by CLOCK_MONOTONIC. The bench has
+*	its own in bench/simClock.c.
+*
+*	FUNCTIONS:
+*		clockCondInit()	- sets up a condition variable for clockWait()
+*		clockWait()		- waits until woken or for some ms
+*		clockWake()		- wakes everything in clockWait() on a condition
+*
+**************************************************************************/
+#include <time.h>
+#include <pthread.h>
+#include "clockWait.h"
+
+/**************************************************************************
+*	clockCondInit()
+*
+*	Sets the condition variable's timed waits to run on CLOCK_MONOTONIC,
+*	so they are not stretched or cut short when the system time is set.
+*	To be called before any other thread can use it.
+*
+*	PARAMETERS:
+*		Input:	pthread_cond_t pointer to the condition variable
+*		Output: none
+*
+**************************************************************************/
+void clockCondInit(pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+	
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+	return;
+}
+
+/**************************************************************************
+*	clockWait()
+*
+*	PARAMETERS:
+*		Input:	pthread_cond_t pointer to the condition variable, set up
+*					by clockCondInit()
+*				pthread_mutex_t pointer to the mutex, locked
+*				int ms to wait at most, clockForever for no limit
+*		Output: integer (1) woken or returned early (0) timed out
+*
+**************************************************************************/
+int clockWait(pthread_cond_t *cond, pthread_mutex_t *mutex, int ms)
+{
+	struct timespec until;
+	
+	if(ms < 0)
+	{
+		pthread_cond_wait(cond, mutex);
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &until);
+	until.tv_sec += ms / 1000;
+	until.tv_nsec += (long)(ms % 1000) * 1000000L;
+	if(until.tv_nsec >= 1000000000L)
+	{
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000L;
+	}
+	return (pthread_cond_timedwait(cond, mutex, &until) == 0);
+}
+
+/**************************************************************************
+*	clockWake()
+*
+*	PARAMETERS:
+*		Input:	pthread_cond_t pointer to the condition variable
+*		Output: none
+*
+**************************************************************************/
+void clockWake(pthread_cond_t *cond)
+{
+	pthread_cond_broadcast(cond);
+	return;
+}
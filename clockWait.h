@@ -0,0 +1,29 @@
+/**************************************************************************
+*	clockWait.h
+*
+*	OBJECTIVE:
+*	This file declares the waits the Master Controller makes on a
+*	condition variable, for the radio handoff between the main loop and
+*	the menu thread in time.c. Like delay() and millis(), they belong to
+*	the clock backend: clockWait.c on the Raspberry Pi, and the virtual
+*	clock in bench/simClock.c on the bench, so the bench runs the same
+*	handoff code as the Pi.
+*
+*	DEFINITIONS:
+*	clockWait() is called with the mutex locked and returns with it
+*	locked, like pthread_cond_wait(). It may return before it is woken
+*	or timed out, so callers wait in a loop on their own condition.
+*
+**************************************************************************/
+#ifndef		ClockWait_H
+#define		ClockWait_H
+
+#include <pthread.h>
+
+#define clockForever	-1		// clockWait() ms that never times out
+
+void clockCondInit(pthread_cond_t *cond);
+int clockWait(pthread_cond_t *cond, pthread_mutex_t *mutex, int ms);
+void clockWake(pthread_cond_t *cond);
+
+#endif
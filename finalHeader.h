@@ -1,132 +1,270 @@
-/****************************************************************************************
-finalHeader.h
-	by group 2: Raul Rojas, Christa McDaniel, Alex Fotso
-	
-	Objective: 
-	This file contains all defined constants as well as all function prototypes for all 
-	files associated with the main program of the Master Controller. 
-	
-****************************************************************************************/
-
-#ifndef		FinalHeader_H
-#define		FinalHeader_H
-
-//Define constants
-#define FAN             22
-#define COOL            13
-#define HEAT            26
-#define LCD_D4			104
-#define LCD_D5			105
-#define LCD_D6			106
-#define LCD_D7			107
-#define LCD_RS			102	
-#define LCD_E			103
-#define pwrLED			6
-#define syncLED			23
-#define entSwitch		16
-#define dwnSwitch		25
-#define upSwitch		24
-#define syncSwitch		17
-#define rstSwitch		5
-#define pwrSwitch		27
-
-#define rows 			128
-#define columns 		128
-
-#define	arrHr			0
-#define arrMin			1
-#define arrSec			2
-#define	arrAP			3
-
-#define thermTimer		0
-#define miscTimer		1
-
-#define retCurrTemp		0
-#define retSetTemp		1
-#define retHum			2
-
-//3-dimensional array z axis index reference constants
-#define sendingAF	0	//sending AirFlow
-#define	receivingAF	1	//receiving AirFlow
-
-//temps[][]: [Current temp | Set temp | Current Humidity | temp difference | start difference]
-#define currTemp	0
-#define setTemp		1
-#define	tempDiff	3
-#define startDiff	4
-#define hvacOut		3
-
-//Define Prototypes
-
-	//menuFunctions.c prototypes	
-	void lcdinitialization(void);
-	void lcdBoot(void);
-	void updateDisplay(void);
-	void mainDisplay(void);
-	void settings(int line);
-	void settingConfig(int line);
-	void errorPage1(int line);
-	void errorPage2(void);
-	void warningPage(void);
-	void display(int, int, int);
-	//void SuccessMessage(int line);
-	void syncMenu(int line);
-	void manageDeviceMenu(int line);
-	void addDeviceMenu(int line);
-	void removeDeviceMenu(int line);
-	void SuccessMessage(int line, int page);
-	void setTimeDisplay(int);
-	void page0(void);
-    void page1(void);
-    void page2(void);
-    void page3(void);
-    void page4(void);
-    void page5and6(void);
-    void page7(void);
-    void page8(void); 
-    void page9(void);
-    void page10(void);
-	void page11(void);
-	void page12(void);
-	void page13(void);
-	void dispTime(void);
-	void remDevWarn(void);
-	void toRoomMenu(void);
-	
-	
-	//syncing.c prototypes
-	void initArray(void);
-	void populateArrays(void);
-	int addTherm(void);
-	int addReg(int addToRoom);
-	void dispMatrix(void);
-	void rmDevAddr(unsigned char address);
-	void retrieveTemps(void);
-	void setReg(void);
-	void initRegFlow(void);
-	void initTempsArr(void);
-	int countErrors(void);
-	void calcDiff(void);
-	void hvacControl(void);
-	void initRocArray(void);
-	void adjustReg(int i, int flowIndex);
-	void initFailedCon(void);
-	
-	//time.c prototypes
-	int getSec(void);
-	void initTimeArr(void);
-	void updateTime(void);
-	void parseTime(void);
-	void rtTimerStart(int timerNum, int timerType);
-	int rtTimerEnd(int timerNum, int timerType);
-
-	
-	//misc
-	int smartDelay(int i);
-	void setups(void);
-	void bootSequence(void);
-	void shutDownSequence(void);
-	void updateStatus(void);
-	
-	
+/****************************************************************************************
+finalHeader.h
+	by group 2: Raul Rojas, Christa McDaniel, Alex Fotso
+	
+	Objective: 
+	This file contains all defined constants as well as all function prototypes for all 
+	files associated with the main program of the Master Controller. 
+	
+****************************************************************************************/
+
+#ifndef		FinalHeader_H
+#define		FinalHeader_H
+
+//Define constants
+#define FAN             22
+#define COOL            13
+#define HEAT            26
+#define LCD_D4			104
+#define LCD_D5			105
+#define LCD_D6			106
+#define LCD_D7			107
+#define LCD_RS			102	
+#define LCD_E			103
+#define pwrLED			6
+#define syncLED			23
+#define entSwitch		16
+#define dwnSwitch		25
+#define upSwitch		24
+#define syncSwitch		17
+#define rstSwitch		5
+#define pwrSwitch		27
+
+#define rows 			128
+#define columns 		128
+
+#define	arrHr			0
+#define arrMin			1
+#define arrSec			2
+#define	arrAP			3
+
+#define thermTimer		0
+#define miscTimer		1
+
+#define retCurrTemp		0
+#define retSetTemp		1
+#define retHum			2
+
+//3-dimensional array z axis index reference constants
+#define sendingAF	0	//sending AirFlow
+#define	receivingAF	1	//receiving AirFlow
+#define ackedAF		2	//last AirFlow acknowledged by the register (-1 if unknown)
+
+#define regRefresh	20	//number of setReg() calls between SET_FLOW refreshes of each room
+#define groupAcks	1	//1 to collect member ACKs for room GROUP_FLOW frames, 0 to skip them
+
+#define reportDelta	1	//temperature change (F) that makes a subscribed thermostat report
+#define reportMax	300	//max seconds between reports from a subscribed thermostat
+
+//main loop scheduler tasks (time.c), each with a fixed period whatever the room count
+#define taskControl	0	//calcDiff() and hvacControl()
+#define taskActuate	1	//setReg()
+#define taskUI		2	//refreshStatus()
+#define taskSync	3	//collectSyncStats()
+#define taskStats	4	//printed statistics
+#define taskCount	5
+
+#define pollPeriod	10000	//ms between the first polls of a room, doubled while it stays stable
+#define pollMin		5000	//ms between polls of a room that is conditioning or changing temperature
+#define staleDefault	120000	//default pollStale, keep below the thermostats' batch buffer (8 min)
+#define moveRate	0.1	//F per minute fitted over the buffered samples that counts as changing
+#define controlPeriod	5000	//ms between control evaluations
+#define controlDeadline	1000	//ms a control evaluation may start late
+#define actuatePeriod	5000	//ms between register updates (retries), also run right after each evaluation
+#define actuateDeadline	1000
+#define uiPeriod	1000	//ms between LCD status refreshes
+#define uiDeadline	500
+#define syncPeriod	600000	//ms between time sync statistics requests
+#define statsPeriod	60000	//ms between printed statistics
+#define ingestPoll	10	//ms ingestTemps() naps between reads, cut short by the radio IRQ if wired
+
+//timed phases of the control cycle (time.c), each with a latency histogram
+#define phasePoll	0	//pollNext()
+#define phaseDiff	1	//calcDiff()
+#define phaseHvac	2	//hvacControl()
+#define phaseSetReg	3	//setReg()
+#define phaseDisplay	4	//display() of the page after a button press
+#define phaseCount	5
+#define phaseOther	5	//main loop work outside the phases above, for the watchdog only
+#define phaseBuckets	108	//4 buckets per doubling from 1us, the last holds 268s and over
+
+#define wdDeadline	30000	//ms a main loop cycle may take before the watchdog turns the hvac off
+#define wdCheck		100	//ms between watchdog checks
+#define relayLock	1	//piLock() key guarding the hvac relays, switched by the main loop and the watchdog
+
+#define histLen		64	//buffered samples kept per room (16 min at the thermostats' 15 s)
+#define batchEvery	60000	//ms between GET_BATCH requests to a room
+#define fitMin		4	//samples over an hvac run needed to fit its rate of change
+
+//roomVote[][]: each room's contribution to the decisions of calcDiff() and hvacControl(), totals in row 0
+#define voteHeat	0	//1 if the room needs heating (auto)
+#define voteCool	1	//1 if the room needs cooling (auto)
+#define voteDiff	2	//out of range difference, positive for heating (auto)
+#define voteWarn	3	//1 if the room is out of range the other way from the hvac setting
+#define voteOut		4	//1 if the room needs the hvac on (heating or cooling)
+#define voteBusy	5	//1 while the room's hvac run has not reached its temperature
+#define voteCols	6
+
+//hvac states, see hvacEvent()
+#define hvacOff			0
+#define hvacStarting	1	//registers being opened for a run
+#define hvacConditioning	2
+#define hvacSettling	3	//rest after a run
+#define hvacFanOnly		4
+
+//hvac events
+#define hvacEvReading	1	//a room's reading arrived
+#define hvacEvTarget	2	//a room reached its temperature
+#define hvacEvMode		3	//the user changed the hvac setting
+#define hvacEvFlows		4	//setReg() sent the register flows
+#define hvacEvTick		5	//periodic check by the control task
+
+#define hvacStartMax	10000	//ms a run waits for its registers before turning the air on anyway
+#define hvacRest	180000	//ms the hvac stays off after a run before it may start again
+
+//temps[][]: [Current temp | Set temp | Current Humidity | temp difference | start difference]
+#define currTemp	0
+#define setTemp		1
+#define	tempDiff	3
+#define startDiff	4
+#define hvacOut		3
+
+//Define Prototypes
+
+	//menuFunctions.c prototypes	
+	void lcdinitialization(void);
+	void lcdBoot(void);
+	void updateDisplay(void);
+	void mainDisplay(void);
+	void settings(int line);
+	void settingConfig(int line);
+	void errorPage1(int line);
+	void errorPage2(void);
+	void warningPage(void);
+	void display(int, int, int);
+	//void SuccessMessage(int line);
+	void syncMenu(int line);
+	void manageDeviceMenu(int line);
+	void addDeviceMenu(int line);
+	void removeDeviceMenu(int line);
+	void SuccessMessage(int line, int page);
+	void setTimeDisplay(int);
+	void page0(void);
+    void page1(void);
+    void page2(void);
+    void page3(void);
+    void page4(void);
+    void page5and6(void);
+    void page7(void);
+    void page8(void); 
+    void page9(void);
+    void page10(void);
+	void page11(void);
+	void page12(void);
+	void page13(void);
+	void dispTime(void);
+	void remDevWarn(void);
+	void toRoomMenu(void);
+	void phaseMenu(int line);
+	void page14(void);
+	void overrunPage(void);
+	
+	
+	//syncing.c prototypes
+	void initArray(void);
+	void populateArrays(void);
+	int addTherm(void);
+	int addReg(int addToRoom);
+	void dispMatrix(void);
+	void rmDevAddr(unsigned char address);
+	int pollRoom(int i);
+	int pollNext(unsigned int now);
+	int pollWait(unsigned int now);
+	unsigned int pollInterval(int room);
+	void pollSoon(int room);
+	void printPollStats(void);
+	void flowActed(int i);
+	void printActStats(void);
+	void refreshStatus(void);
+	void collectSyncStats(void);
+	void printSyncStats(void);
+	void setReg(void);
+	void setRoomReg(int i, int refresh);
+	void queueDone(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2, int success);
+	void initRegFlow(void);
+	void initTempsArr(void);
+	int countErrors(void);
+	void markRoom(int i);
+	void markFlow(int i);
+	void markAllRooms(void);
+	int voteSet(int i, int col, int val);
+	void roomDiff(int i);
+	void voteResult(void);
+	void calcDiff(void);
+	void roomUpdate(int i);
+	int roomControl(int i);
+	void hvacRelays(int cool, int fan, int heat);
+	void hvacStart(void);
+	void hvacRun(void);
+	void hvacStop(void);
+	void hvacEnter(int state);
+	void hvacEvent(int event, int room);
+	void hvacControl(void);
+	void hvacTrip(void);
+	void initRocArray(void);
+	void adjustReg(int i, int flowIndex);
+	void initFailedCon(void);
+	void pushGroup(int room);
+	void updateRoutes(void);
+	int fleetCaps(void);
+	int roomOf(unsigned char address);
+	int devSynced(unsigned char address);
+	void storeTemps(int room, int curr, int set);
+	void takeTelemetry(unsigned char msgType, unsigned char source, int val1, int val2);
+	int storeBatch(int room, int val1, int val2);
+	void pollBatch(int room);
+	float roomSlope(int room, int secs, int *n);
+	float runRate(int room, int secs);
+	void ingestTemps(int ms);
+	void dutyRest(unsigned int until);
+	
+	//time.c prototypes
+	int getSec(void);
+	void initTimeArr(void);
+	void updateTime(void);
+	void parseTime(void);
+	void rtTimerStart(int timerNum, int timerType);
+	int rtTimerEnd(int timerNum, int timerType);
+	void taskInit(int task, unsigned int period, unsigned int deadline);
+	int taskDue(int task, unsigned int now);
+	void taskStart(int task, unsigned int now);
+	void taskKick(int task);
+	int taskLeft(int task, unsigned int now);
+	int taskWait(unsigned int now);
+	void printTaskStats(void);
+	void phaseEnd(int phase, unsigned int start);
+	unsigned int phasePct(int phase, int pct);
+	void printPhaseStats(void);
+	unsigned int phaseBegin(int phase);
+	void wdCycle(void);
+	void watchdog(void);
+	void radioInit(void);
+	void radioTake(void);
+	void radioGive(void);
+	int radioYield(void);
+	int radioPass(void);
+	void radioNap(int ms);
+	void radioIrqISR(void);
+	void initTasks(void);
+	void mainCycle(void);
+
+	
+	//misc
+	int smartDelay(int i);
+	void setups(void);
+	void bootSequence(void);
+	void shutDownSequence(void);
+	void updateStatus(void);
+	
+	
 #endif
\ No newline at end of file
@@ -1,1203 +1,3077 @@
-/**************************************************************************
-*	messaging.c
-*		by Eric Ceballos, LeValle Bradix, and Robert Young
-*
-*	OBJECTIVE:
-*	This file lays out the functions to be called in each device's main
-*	C file.
-*
-*	FUNCTIONS:
-*		initRF()		- initializes the nRF24L01 module
-*		writeReadRF()	- reads and writes to the nRF24L01
-*		rxMode()		- sets the RF module into receiver mode
-*		txMode()		- sets the RF module into transmitter mode
-*		initMC()		- initialization function for Master Controller
-*		initThermo()	- initialization function for Thermostats
-*		initReg()		- initialization function for Registers
-*		addDevice()		- listens for a new device, then returns address
-*		getMessage()	- receives message from another device
-*		getSyncMessage()- receives a sync message from a device or MC
-*		sendMessage()	- sends a message to another device
-*
-**************************************************************************/
-#include <stdio.h>
-#include <stdlib.h>
-#include <wiringPi.h>
-#include <wiringPiSPI.h>
-#include <time.h>
-#include "messaging.h"
-
-// Global variables to be used by functions
-unsigned char myAddr = 0;
-unsigned char Master;
-int LEDStatus = 2;
-int addrCount;
-int init = 0;
-int devCount = 0;
-int myNumber = 0;
-
-/**************************************************************************
-*	initRF()
-*
-*	To be used prior to initialization. Sets the RF module's registers to
-*	desired settings.
-*
-*	PARAMETERS:
-*		Input: none
-*		Output: integer indicating success(1), or failure(0)
-*
-**************************************************************************/
-int initRF(void)
-{
-	// printf("\nStarting initRF()");
-	// Initialize Sync GPIO
-	pinMode(CE, OUTPUT);
-	digitalWrite(CE, LOW);
-	pinMode(SyncLED, OUTPUT);
-	digitalWrite(SyncLED, HIGH);
-	pinMode(SyncBtn, INPUT);
-	
-	// Initialize Variables used
-	unsigned char data[11];
-	int a;
-	
-	// Initialize SPI module: Channel 0, 8Mbps
-	if (wiringPiSPISetup(Chan, Speed) < 0)
-	{
-		// printf("\nInitRF() failed!");
-		a = 0;
-		init = 2;
-	}
-	else
-	{
-		// Flush TX and RX_FIFOs
-		writeReadRF((unsigned char)(FLUSH_TX), data, 1);
-		writeReadRF((unsigned char)(FLUSH_RX), data, 1);
-		
-		// Clear all STATUS flags
-		data[0] = 0x70;
-		writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-		
-		// Disable Auto Acknowledge
-		data[0] = 0x00;
-		writeReadRF((unsigned char)(W_REGISTER|EN_AA), data, 2);
-		
-		// Disable all but first data pipe
-		data[0] = 0x01;
-		writeReadRF((unsigned char)(W_REGISTER|EN_RXADDR), data, 2);
-		
-		// Config Initializes: PWR_UP (0), CRC enabled, 1 byte CRC
-		data[0] = 0x08;
-		writeReadRF((unsigned char)(W_REGISTER|CONFIG), data, 2);
-		
-		a = 1;
-		init = 1;
-		// printf("\nInitRF() Successful!");
-	}
-	printf("\nLeaving initRF()\n");
-	return a;
-}
-
-/**************************************************************************
-*	writeReadRF()
-*
-*	Used by the functions as an all purpose SPI read/write command.
-*	Designed to condense the functions that use the same code flow several
-*	times.
-*
-*	PARAMETERS:
-*		Input:	unsigned character command for the function of the nRF24L01
-*				unsigned character pointer to the data array
-*					clear the array before read command.
-*				integer total byte length of SPI transfer including command
-*		Output: unsigned character contents of the nRF24L01's STATUS
-*
-**************************************************************************/
-unsigned char writeReadRF(unsigned char command, unsigned char *data, int length)
-{
-	// Define variables to be used
-	int i;
-	unsigned char dataBuffer[12];
-	unsigned char status;
-	
-	// Command Byte always first
-	dataBuffer[0] = command;
-	
-	// Write data to buffer
-	for(i = 1; i < length; i++)
-	{
-		dataBuffer[i] = data[(i - 1)];
-	}
-	// Clear the remaining space in buffer
-	for(i = length; i < sizeof(dataBuffer); i++)
-	{
-		dataBuffer[i] = 0x00;
-	}
-	delay(1);
-	
-	// Simultaneous read/write to SPI module
-	wiringPiSPIDataRW(Chan, dataBuffer, length);
-	delay(1);
-	
-	// STATUS Register is always returned first
-	status = dataBuffer[0];
-	
-	// Write to the data buffer input
-	for(i = 0; i < 11; i++)
-	{
-		data[i] = dataBuffer[(i + 1)];
-	}
-	
-	return status;
-}
-
-/**************************************************************************
-*	rxMode()
-*
-*	Used by the functions to set the nRF24L01 into receiver mode
-*
-*	PARAMETERS:
-*		Input:	None
-*		Output: None
-*
-**************************************************************************/
-void rxMode(void)
-{
-	// printf("\nEntering RX Mode");
-	// Declare function variables
-	int i;
-	unsigned char data[11];
-	
-	// CE starts LOW
-	digitalWrite(CE, LOW);
-	delay(1);
-	
-	// CONFIG: PWR_UP (1), CRC enabled, 1byte CRC, RX mode
-	data[0] = 0x7B;
-	for(i = 1; i < sizeof(data); i++)
-	{
-		data[i] = 0x00;
-	}
-	writeReadRF((unsigned char)(W_REGISTER|CONFIG), data, 2);
-	
-	// Set desired payload width to 11 bytes
-	data[0] = 11;
-	for(i = 1; i < sizeof(data); i++)
-	{
-		data[i] = 0x00;
-	}
-	writeReadRF((unsigned char)(W_REGISTER|RX_PW_P0), data, 2);
-	
-	// Start listening
-	digitalWrite(CE, HIGH);
-	delay(1);
-	
-	// printf("\n");
-	return;
-}
-
-/**************************************************************************
-*	txMode()
-*
-*	Used by the functions to set the nRF24L01 into transmitter mode
-*
-*	PARAMETERS:
-*		Input:	None
-*		Output: None
-*
-**************************************************************************/
-void txMode(void)
-{
-	// printf("\nEntering TX Mode");
-	// Declare function variables
-	int i;
-	unsigned char data[11];
-	
-	// CE starts LOW
-	digitalWrite(CE, LOW);
-	delay(1);
-	
-	// CONFIG: PWR_UP (1), CRC enabled, 1byte CRC, TX mode
-	data[0] = 0x7A;
-	for(i = 1; i < sizeof(data); i++)
-	{
-		data[i] = 0x00;
-	}
-	writeReadRF((unsigned char)(W_REGISTER|CONFIG), data, 2);
-	
-	// printf("\n");
-	return;
-}
-/**************************************************************************
-*	initMC()
-*
-*	To be used by the Master Control device. Generates an address for the
-*	Master controller, then listens for a device id from a thermostat, 
-*	then registers. For each device, an address is generated and sent out.
-*	The MC then listens for an ACK packet from the same device. The address
-*	created for that device is only saved if an ACK packet is received.
-*
-*	PARAMETERS:
-*		Input:	int pointer to variable for total number of devices
-*				unsigned char pointer to array of devices listed in order
-*		Output: integer indicating success(1), or failure(0)
-*
-**************************************************************************/
-int initMC(int *devNumber, unsigned char *devArray)
-{
-	printf("\nInitializing MC!\n");
-	
-	// Declare and Initialize function variables
-	unsigned char source;
-	int stat;
-	unsigned char msgCommand;
-	unsigned char thermoAddr;
-	unsigned char regAddr;
-	unsigned char dev[126];
-	int data1;
-	int data2;
-	int i;
-	int j;
-	int success = 0;
-	int loop = 0;
-	devCount = 0;
-	
-	myAddr = 0;
-	LEDStatus = 0;
-	
-	if(init == 0)
-	{
-		initRF();
-	}
-	delay(1);
-	piThreadCreate(SyncLEDPulse);
-	
-	printf("\nLED blinking");
-	
-	for(i = 0; i < sizeof(dev); i++)
-	{
-		dev[i] = 0;
-	}
-	
-	// printf("\ndevArray cleared");
-	
-	srand(time(NULL));
-	myAddr = ((rand() % 15) + 1) & 0xFF;
-	addrCount = myAddr;
-	printf("\nMy Addr: %#.2x", myAddr);
-	
-	rxMode();
-	printf("\nSend Thermostat ID");
-	delay(25);
-	do
-	{
-		stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
-		//printf("\nstat = %d", stat);
-		if(stat == 1)
-		{
-			delay(25);
-			if((msgCommand == CREATE_ADDR) && (data1 & 0x00000080))
-			{
-				thermoAddr = (data1) | (addrCount);
-				if(addrCount >= 127)
-				{
-					printf("\nRolling over Thermostat Address");
-					thermoAddr = (data1)|((addrCount + 1) & 0x7F);
-				}
-				dev[devCount] = thermoAddr;
-				printf("\nThermostat Addr: %#.2x", dev[devCount]);
-				sendMessage(SET_ADDR, SYNC, dev[devCount], data2);
-				j = 0;
-				delay(1);
-				
-				do
-				{
-					stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
-					if(stat == 1)
-					{
-						printf("\nmsgCommand: %#.2x", msgCommand);
-						printf("\nsource: %#.2x", source);
-						printf("\ndata: %d %d", data1, data2);
-						dev[devCount] = thermoAddr;
-						if(msgCommand == RECEIVED_ADDR)
-						{
-							printf("\nThermostat Set! Send next device.");
-							addrCount++;
-							devCount++;
-							printf("\n\ndevCount: %d", devCount);
-							loop = 1;
-						}
-						else if(msgCommand == ADDR_NOT_SET)
-						{
-							dev[devCount] = 0;
-							printf("\nThermostat failed to initialize");
-							loop = 1;
-						}
-						else
-						{
-							printf("\nWrong Packet");
-							loop = 0;
-						}
-					}
-					j++;
-					delay(18);
-				}while((j < 250) && (loop == 0));
-				printf("\nExiting Loop");
-				loop = 0;
-				if(j >= 250)
-				{
-					dev[devCount] = 0;
-					printf("\nTimed out. Try again.");
-				}
-			}
-			else if((msgCommand == CREATE_ADDR) && (!(data1 & 0x00000080)) && (devCount > 0))
-			{
-				regAddr = (data1) | (addrCount);
-				if(addrCount >= 128)
-				{
-					printf("\nRolling Over Register Address");
-					regAddr = (data1)|((addrCount + 1) & 0x7F);
-				}
-				dev[devCount] = regAddr;
-				printf("\nRegister Addr: %#.2x", dev[devCount]);
-				
-				sendMessage(SET_ADDR, SYNC, dev[devCount], data2);
-				j = 0;
-				delay(1);
-				
-				do
-				{
-					stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
-					if(stat == 1)
-					{
-						printf("\nmsgCommand: %#.2x", msgCommand);
-						printf("\nsource: %#.2x", source);
-						printf("\ndata: %d %d", data1, data2);
-						dev[devCount] = regAddr;
-						if(msgCommand == RECEIVED_ADDR)
-						{
-							printf("\nRegister Set! Send next device.");
-							addrCount++;
-							devCount++;
-							printf("devCount: %d", devCount);
-							loop = 1;
-							j = 0;
-						}
-						else if(msgCommand == ADDR_NOT_SET)
-						{
-							dev[devCount] = 0;
-							printf("\nRegister failed to initialize");
-							loop = 1;
-						}
-						else
-						{
-							printf("\nWrong Packet");
-							loop = 0;
-						}
-					}
-					j++;
-					delay(18);
-				}while((j < 250) && (loop == 0));
-				printf("\nExiting Loop");
-				loop = 0;
-				if(j == 250)
-				{
-					dev[devCount] = 0;
-					printf("\nTimed out. Try again.");
-				}
-			}
-			else if((msgCommand == CREATE_ADDR) && (!(data1 & 0x00000080)) && (devCount == 0))
-			{
-				printf("\nRegister pressed too early");
-				sendMessage(REJECT_ADDR, SYNC, 0, data2);
-			}
-			else
-			{
-				msgCommand = 0;
-				source = 0;
-				data1 = 0;
-				data2 = 0;
-			}
-		}
-		delay(18);
-	}while((digitalRead(SyncBtn)) && (devCount < 126));
-	if(devCount == 126)
-	{
-		printf("\nMax device count reached");
-	}
-	
-	*devNumber = devCount;
-	printf("\nNumber of devices: %d", *devNumber);
-	for(i = 0; i < sizeof(dev); i++)
-	{
-		devArray[i] = dev[i];
-	}
-	for(i = 0; i < devCount; i++)
-	{
-		printf("\nAddress[%d]: %#.2x", i, devArray[i]);
-	}
-	if(dev[0] == 0)
-	{
-		LEDStatus = 2;
-		success = 0;
-	}
-	else
-	{
-		LEDStatus = 1;
-		success = 1;
-	}
-	return success;
-}
-
-/**************************************************************************
-*	initThermo()
-*
-*	To be used by the thermostat device. Sends out a thermostat ID packet
-*	with a randomly generated number then listens for a response from the
-*	MC. If the MC sends back an address with the same number, the MC
-*	address is saved, and an ACK packet is sent out.
-*
-*	PARAMETERS:
-*		Input:	unsigned character pointer to Master Control address
-*		Output: integer indicating success(1), or failure(0)
-*
-**************************************************************************/
-int initThermo(unsigned char *MCAddr)
-{
-	printf("\nInitializing Thermostat!\n");
-	unsigned char source;
-	unsigned char stat;
-	unsigned char msgCommand;
-	int data1;
-	int data2;
-	int j;
-	int a;
-	
-	if(LEDStatus != 0)
-	{
-		LEDStatus = 0;
-		piThreadCreate(SyncLEDPulse);
-	}
-	myAddr = 0;
-	delay(1);
-	
-	if(myNumber == 0)
-	{
-		srand(time(NULL));
-		myNumber = rand();
-	}
-	
-	sendMessage(CREATE_ADDR, SYNC, thermoID, myNumber);
-	j = 0;
-	
-	do
-	{
-		stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
-		//printf("\nstat = %d", stat);
-		if(stat == 1)
-		{
-			if((msgCommand == SET_ADDR) && (data1 & 0x80) && (data2 == myNumber))
-			{
-				myAddr = (data1 & 0xFF);
-				*MCAddr = source;
-				delay(25);
-				sendMessage(RECEIVED_ADDR, *MCAddr, 0, 0);
-				printf("\nMy Address: %#.2x\nMC Address: %#.2x", myAddr, *MCAddr);
-				LEDStatus = 1;
-				a = 1;
-			}
-			else if((msgCommand == SET_ADDR) && (data1 & 0x80) && (data2 != myNumber))
-			{
-				*MCAddr = source;
-				delay(25);
-				sendMessage(ADDR_NOT_SET, *MCAddr, 0, 0);
-			}
-			else
-			{
-				msgCommand = 0;
-				source = 0;
-				data1 = 0;
-				data2 = 0;
-			}
-		}
-		delay(18);
-		j++;
-	}while((myAddr == 0) && (j < 250));
-	if(j == 250)
-	{
-		printf("\nTimeout. Leaving Thermostat initialization.\n");
-		LEDStatus = 2;
-		a = 0;
-	}
-	else
-	{
-		printf("\nAddress set\n");
-	}
-	rxMode();
-	return a;
-}
-
-/**************************************************************************
-*	initReg()
-*
-*	To be used by the register devices. Sends out a register ID packet
-*	with a randomly generated number then listens for a response from the
-*	MC. If the MC sends back an address with the same number, the MC
-*	address is saved, and an ACK packet is sent out. If a reject packet is
-*	received, the program exits with a failure status.
-*
-*	PARAMETERS:
-*		Input:	int pointer to Master Control address
-*		Output: integer indicating success(1), or failure(0)
-*
-**************************************************************************/
-int initReg(unsigned char *MCAddr)
-{
-	printf("\nInitializing Register!\n");
-	unsigned char source;
-	unsigned char stat;
-	unsigned char msgCommand;
-	int data1;
-	int data2;
-	int j;
-	int a;
-	
-	if(LEDStatus != 0)
-	{
-		LEDStatus = 0;
-		piThreadCreate(SyncLEDPulse);
-	}
-	
-	myAddr = 0;
-	delay(1);
-	
-	if(myNumber == 0)
-	{
-		srand(time(NULL));
-		myNumber = rand();
-	}
-	sendMessage(CREATE_ADDR, SYNC, regID, myNumber);
-	j = 0;
-	
-	do
-	{
-		stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
-		//printf("\nstat = %d", stat);
-		if(stat == 1)
-		{
-			if((msgCommand == SET_ADDR) && !(data1 & 0x80) && (data2 == myNumber))
-			{
-				myAddr = (data1 & 0xFF);
-				*MCAddr = source;
-				delay(25);
-				sendMessage(RECEIVED_ADDR, *MCAddr, 0, 0);
-				printf("\nMy Address: %#.2x\nMC Address: %#.2x", myAddr, *MCAddr);
-				LEDStatus = 1;
-				a = 1;
-			}
-			else if((msgCommand == SET_ADDR) && !(data1 & 0x80) && (data2 != myNumber))
-			{
-				*MCAddr = source;
-				delay(25);
-				sendMessage(ADDR_NOT_SET, *MCAddr, 0, 0);
-			}
-			else if(msgCommand == REJECT_ADDR)
-			{
-				LEDStatus = 2;
-				a = 0;
-			}
-			else
-			{
-				myAddr = 0;
-				msgCommand = 0;
-				data1 = 0;
-				data2 = 0;
-				LEDStatus = 0;
-			}
-		}
-		delay(18);
-		j++;
-	}while((myAddr == 0) && (j < 250) && (LEDStatus != 2));
-	if(j == 250)
-	{
-		LEDStatus = 2;
-		a = 0;
-		printf("\nTimeout. Leaving Register initialization.\n");
-	}
-	/* else if(LEDStatus == 2)
-	{
-		printf("\nNot your time.");
-	}
-	else
-	{
-		printf("\nAddress set\n");
-	} */
-	rxMode();
-	return a;
-}
-
-/**************************************************************************
-*	addDevice()
-*
-*	To be used by the Master Control device. Listens for a device ID to be
-*	transmitted by a thermostat or register. Once it receives the ID, it
-*	generates an address for the device, then sends it to the device. The
-*	MC then waits for a confirmation packet from the device. The function
-*	then returns from execution.
-*
-*	PARAMETERS:
-*		Input:	unsigned char pointer to a device address variable
-*				integer indicating expected device type
-*		Output: integer indicating success(1), or failure(0)
-*
-**************************************************************************/
-int addDevice(unsigned char *devAddr, int type)
-{
-	printf("\nAdding a Device!\n");
-	unsigned char source;
-	int stat;
-	unsigned char msgCommand;
-	unsigned char thermoAddr;
-	unsigned char regAddr;
-	int dev = 0;
-	int data1;
-	int data2;
-	int j;
-	int success = 0;
-	
-	LEDStatus = 0;
-	delay(1);
-	piThreadCreate(SyncLEDPulse);
-	
-	rxMode();
-	printf("\nSend Device ID");
-	delay(25);
-	
-	while(!(digitalRead(SyncBtn)))
-	{
-		delay(20);
-	}
-	while((success == 0) && digitalRead(SyncBtn) && devCount < 126);
-	{
-		stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
-		if(stat == 1)
-		{
-			delay(25);
-			if((msgCommand == CREATE_ADDR) && (data1 & 0x00000080) && (type == 1))
-			{
-				thermoAddr = (data1) | (addrCount);
-				if(addrCount >= 127)
-				{
-					thermoAddr = (data1)|((addrCount+1) & 0x7F);
-				}
-				dev = thermoAddr;
-				printf("\nThermostat Addr: %#.2x", dev);
-				sendMessage(SET_ADDR, SYNC, dev, data2);
-				j = 0;
-				delay(1);
-				
-				do
-				{
-					stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
-					if(stat == 1)
-					{
-						printf("\nmsgCommand: %#.2x", msgCommand);
-						printf("\nsource: %#.2x", source);
-						printf("\ndata: %d %d", data1, data2);
-						if(msgCommand == RECEIVED_ADDR)
-						{
-							printf("\nThermostat Set! Send next device.");
-							addrCount++;
-							devCount++;
-							success = 1;
-							j = 0;
-						}
-						else if(msgCommand == ADDR_NOT_SET)
-						{
-							dev = 0;
-							success = 2;
-						}
-						else
-						{
-							printf("\nWrong Packet");
-							success = 0;
-						}
-					}
-					j++;
-					delay(18);
-				}while((j < 250) && (success == 0));
-				if(j == 250)
-				{
-					printf("\nTimed out.");
-				}
-			}
-			else if((msgCommand == CREATE_ADDR) && (!(data1 & 0x00000080)) && (type == 2))
-			{
-				regAddr = (data1) | (addrCount);
-				if(addrCount >= 128)
-				{
-					regAddr = (data1)|((addrCount + 1) & 0x7F);
-				}
-				dev = regAddr;
-				printf("\nRegister Addr: %#.2x", dev);
-				
-				sendMessage(SET_ADDR, SYNC, dev, data2);
-				j = 0;
-				delay(1);
-				do
-				{
-					stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
-					if(stat == 1)
-					{
-						printf("\nmsgCommand: %#.2x", msgCommand);
-						printf("\nsource: %#.2x", source);
-						printf("\ndata: %d %d", data1, data2);
-						if(msgCommand == RECEIVED_ADDR)
-						{
-							printf("\nRegister Set! Send next device.");
-							addrCount++;
-							devCount++;
-							success = 1;
-							j = 0;
-						}
-						else if(msgCommand == ADDR_NOT_SET)
-						{
-							dev = 0;
-							success = 2;
-						}
-						else
-						{
-							printf("\nWrong Packet");
-							success = 0;
-						}
-					}
-					j++;
-					delay(18);
-				}while((j < 250) && (success == 0));
-				if(j == 250)
-				{
-					printf("\nTimed out. Try again.");
-				}
-			}
-			else
-			{
-				msgCommand = 0;
-				source = 0;
-				data1 = 0;
-				data2 = 0;
-			}
-		}
-		delay(18);
-	}
-	if(devCount == 126)
-	{
-		printf("\nMax device count reached");
-	}
-	
-	*devAddr = dev;
-	if(dev == 0)
-	{
-		LEDStatus = 2;
-		success = 0;
-	}
-	else
-	{
-		LEDStatus = 1;
-		success = 1;
-	}
-	return success;
-}
-
-/*************************************************************************
-*	getMessage()
-*
-*	Checks for available message, then reads the contents of the RX FIFO.
-*
-*	PARAMETERS:
-*		Input:	unsigned char pointer to the type of message
-*				unsigned char pointer to source address
-*				int pointer to first data value
-*				int pointer to second data value
-*				int type of device calling the getMessage
-*					(0) Master Control, (1) Thermostat, (2) Register
-*		Output: int that indicates a read packet: (0) No Packet, (1) Packet
-*
-**************************************************************************/
-int getMessage(unsigned char *msgType, unsigned char *msgSourceAddr, int *msgVal1, int *msgVal2, int devType)
-{
-	// printf("\nReading Message");
-	int i;
-	int j = 0;
-	int a;
-	unsigned char data[11];
-	unsigned char stat;
-	
-	if(init == 0)
-	{
-		if(initRF())
-		{
-			printf("\nRF Module Initialized");
-		}
-		else
-		{
-			printf("\nRF Module failed to initialize");
-		}
-	}
-	if((myAddr == 0) & (LEDStatus != 0))
-	{
-		LEDStatus = 0;
-		piThreadCreate(SyncLEDPulse);
-		//printf("\nDevice not Synced");
-	}
-	if((!digitalRead(SyncBtn)))
-	{
-		while((!digitalRead(SyncBtn)) && (j < 60))
-		{
-			delay(50);
-			j++;
-		}
-		writeReadRF((unsigned char)(FLUSH_RX), data, 1);
-		data[0] = 0x40;
-		writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-		if((j == 60) && (devType == 1))
-		{
-			initThermo(&Master);
-		}
-		else if((j == 60) && (devType == 2))
-		{
-			initReg(&Master);
-		}
-	}
-	//printf("\nMy address: %#.2x", myAddr);
-	stat = writeReadRF((unsigned char)(NOP), data, 1);
-	if((stat & 0x40) && (myAddr != 0))
-	{
-		for(i = 0; i < sizeof(data); i++)
-		{
-			data[i] = 0x00;
-		}
-		writeReadRF((unsigned char)(R_RX_PAYLOAD), data, 12);
-	
-		if(((data[0] == myAddr) || (data[0] == BROADCAST)))
-		{
-			*msgType = data[2];
-			*msgSourceAddr = data[1];
-			*msgVal1 = (data[3] << 24)|(data[4] << 16)|(data[5] << 8)|(data[6]);
-			*msgVal2 = (data[7] << 24)|(data[8] << 16)|(data[9] << 8)|(data[10]);
-			delay(1);
-		
-			printf("\nReturned msgTyp: %#.2x\nReturned SourceAddr: %#.2x\nReturned Payload: %d %d", *msgType, *msgSourceAddr, *msgVal1, *msgVal2);
-		
-			writeReadRF((unsigned char)(FLUSH_RX), data, 1);
-			data[0] = 0x40;
-			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-			
-			txMode();
-			delay(25);
-	
-			data[0] = *msgSourceAddr;
-			data[1] = myAddr;
-			data[2] = ACK;
-			data[3] = 0;
-			data[4] = 0;
-			data[5] = 0;
-			data[6] = *msgType;
-			data[7] = ((*msgVal1) >> 24) & 0xFF;
-			data[8] = ((*msgVal1) >> 16) & 0xFF;
-			data[9] = ((*msgVal1) >> 8) & 0xFF;
-			data[10] = (*msgVal1) & 0xFF;
-	
-			stat = writeReadRF((unsigned char)(W_TX_PAYLOAD), data, 12);
-	
-			digitalWrite(CE, HIGH);
-			delayMicroseconds(100);
-			digitalWrite(CE, LOW);
-			delayMicroseconds(100);
-	
-			do
-			{
-				stat = writeReadRF((unsigned char)(NOP), data, 1);
-			}while(!(stat & 0x30));
-	
-			if(stat & 0x10)
-			{
-				printf("\nFailed to ACK");
-				data[0] = 0x30;
-				stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-				a = 0;
-			}
-			else
-			{
-				printf("\nACK sent");
-				data[0] = 0x30;
-				stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-				a = 1;
-			}
-			rxMode();
-			// a = 1;
-		}
-		else
-		{
-			a = 0;
-			delay(1);
-		
-			// printf("\nReturned msgTyp: %#.2x\nReturned SourceAddr: %#.2x\nReturned Payload: %d %d", *msgType, *msgSourceAddr, *msgVal1, *msgVal2);
-			
-			writeReadRF((unsigned char)(FLUSH_RX), data, 1);
-			data[0] = 0x40;
-			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-		}
-	}
-	else
-	{
-		a = 0;
-	}
-		return a;
-}
-
-/**************************************************************************
-*	getSyncMessage()
-*
-*	For use by the syncing and initialization functions. Reads a sync
-*	packet and returns the contents.
-*
-*	PARAMETERS:
-*		Input:	unsigned char pointer to the command type
-*				unsigned char pointer to source address
-*				int pointer to first sync value
-*				int pointer to second sync value
-*		Output: int that indicates a read packet: (0) No Packet, (1) Packet
-*
-**************************************************************************/
-int getSyncMessage(unsigned char *syncType, unsigned char *syncSource, int *syncVal1, int *syncVal2)
-{
-	//printf("\nReading Message");
-	int i;
-	int a;
-	unsigned char data[11];
-	unsigned char stat;
-	
-	//printf("\nMy address: %#.2x", myAddr);
-	stat = writeReadRF((unsigned char)(NOP), data, 1);
-	if(stat & 0x40)
-	{
-		for(i = 0; i < sizeof(data); i++)
-		{
-			data[i] = 0x00;
-		}
-		writeReadRF((unsigned char)(R_RX_PAYLOAD), data, 12);
-	
-		if(((data[0] == myAddr) || (data[0] == BROADCAST) || (data[0] == SYNC)))
-		{
-			*syncType = data[2];
-			*syncSource = data[1];
-			*syncVal1 = (data[3] << 24)|(data[4] << 16)|(data[5] << 8)|(data[6]);
-			*syncVal2 = (data[7] << 24)|(data[8] << 16)|(data[9] << 8)|(data[10]);
-			delay(1);
-		
-			// printf("\nReturned msgTyp: %#.2x\nReturned SourceAddr: %#.2x\nReturned Payload: %d %d", *syncType, *syncSource, *syncVal1, *syncVal2);
-		
-			writeReadRF((unsigned char)(FLUSH_RX), data, 1);
-			data[0] = 0x40;
-			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-			
-			a = 1;
-		}
-		else
-		{
-			a = 0;
-			delay(1);
-		
-			// printf("\nReturned msgTyp: %#.2x\nReturned SourceAddr: %#.2x\nReturned Payload: %d %d", *syncType, *syncSource, *syncVal1, *syncVal2);
-			
-			writeReadRF((unsigned char)(FLUSH_RX), data, 1);
-			data[0] = 0x40;
-			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-		}
-		//printf("\nDone Reading Message\n");
-	}
-	else
-	{
-		a = 0;
-	}
-		return a;
-}
-
-/**************************************************************************
-*	sendMessage()
-*
-*	Puts the device into TX mode, then builds a packet to be transmitted.
-*	
-*
-*	PARAMETERS:
-*		Input:	unsigned char the type of message
-*				unsigned char destination address
-*				int first data value
-*				int second data value
-*		Output: integer (0) failed transmission (1) successful transmission
-*
-**************************************************************************/
-int sendMessage(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2)
-{
-	// printf("\nBeginning sendMessage()");
-	unsigned char data[11];
-	unsigned char stat;
-	int a = 0;
-	int ACKVal;
-	int j = 0;
-	int i;
-	
-	if((msgVal1 == 0))
-	{
-		switch(msgType)
-		{
-			case SET_ADDR:
-			case CREATE_ADDR:
-			case RECEIVED_ADDR:
-			case REJECT_ADDR:
-			case SET_FLOW:
-			case RETURN_FLOW:
-			case ADDR_NOT_SET:
-			{
-				break;
-			}
-			default:
-			{
-				srand(time(NULL));
-				msgVal1 = rand();
-			}
-		}
-	}
-	
-	txMode();
-	
-	data[0] = msgAddr;
-	data[1] = myAddr;
-	data[2] = msgType;
-	data[3] = (msgVal1 >> 24) & 0xFF;
-	data[4] = (msgVal1 >> 16) & 0xFF;
-	data[5] = (msgVal1 >> 8) & 0xFF;
-	data[6] = (msgVal1) & 0xFF;
-	data[7] = (msgVal2 >> 24) & 0xFF;
-	data[8] = (msgVal2 >> 16) & 0xFF;
-	data[9] = (msgVal2 >> 8) & 0xFF;
-	data[10] = (msgVal2) & 0xFF;
-	printf("\nSending to %#.2x: %#.2x %d %d\n", msgAddr, msgType, msgVal1, msgVal2);
-	stat = writeReadRF((unsigned char)(W_TX_PAYLOAD), data, 12);
-	
-	digitalWrite(CE, HIGH);
-	delayMicroseconds(100);
-	digitalWrite(CE, LOW);
-	delayMicroseconds(100);
-	
-	do
-	{
-		stat = writeReadRF((unsigned char)(NOP), data, 1);
-	}while(!(stat & 0x30));
-	
-	if(stat & 0x10)
-	{
-		// printf("\nFailed to send");
-		data[0] = 0x30;
-		stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-		a = 0;
-	}
-	else
-	{
-		// printf("\nSend successful");
-		data[0] = 0x30;
-		stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
-		// a = 1;
-	}
-	rxMode();
-	
-	switch(msgType)
-	{
-		case CREATE_ADDR:
-		case SET_ADDR:
-		case REJECT_ADDR:
-		case RECEIVED_ADDR:
-		case ADDR_NOT_SET:
-		{
-			break;
-		}
-		default:
-		{
-			j = 0;
-			do
-			{
-				stat = writeReadRF((unsigned char)(NOP), data, 1);
-				if(stat & 0x40)
-				{
-					for(i = 0; i < sizeof(data); i++)
-					{
-						data[i] = 0;
-					}
-					for(i = 0; i < sizeof(data); i++)
-					{
-						data[i] = 0x00;
-					}
-					writeReadRF((unsigned char)(R_RX_PAYLOAD), data, 12);
-	
-					if(((data[0] == myAddr) || (data[0] == BROADCAST)))
-					{
-						ACKVal = (data[7] << 24)|(data[8] << 16)|(data[9] << 8)|(data[10]);
-						if((data[1] == msgAddr) && (data[2] == ACK) && (ACKVal == msgVal1) && (data[6] == msgType))
-						{
-							a = 1;
-						}
-						else
-						{
-							a = 0;
-						}
-					}
-				}
-				j++;
-				delay(18);
-			}while((j < 50) && (a == 0));
-		}
-	}
-	
-	return a;
-}
-
-/**************************************************************************
-*	SyncLEDPulse
-*
-*	Used by the initialization functions. A separate thread blinks the
-*	SyncLED until LEDStatus changes. The LED is left ON for successful
-*	initialization and OFF for failed initialization.
-*
-*	PARAMETERS:
-*		Input:	none
-*		Output: none
-*
-**************************************************************************/
-
-PI_THREAD(SyncLEDPulse)
-{
-	do
-	{
-        
-        digitalWrite(SyncLED, HIGH);
-        delay( 500);
-
-        
-        digitalWrite(SyncLED, LOW);
-        delay( 500);
-		
-		if(LEDStatus==1)
-		{
-			digitalWrite(SyncLED, LOW);
-			//printf("Sync LED ON");
-			break;
-		}
-		else if(LEDStatus==2)
-		{
-			digitalWrite(SyncLED, HIGH);
-			//printf("Sync LED OFF");
-			break;
-		}
-    }while(LEDStatus == 0);
-	return 0;
+/**************************************************************************
+*	messaging.c
+*		by Eric Ceballos, LeValle Bradix, and Robert Young
+*
+*	OBJECTIVE:
+*	This file lays out the functions to be called in each device's main
+*	C file.
+*
+*	FUNCTIONS:
+*		initRF()		- initializes the nRF24L01 module
+*		writeReadRF()	- reads and writes to the nRF24L01
+*		rxMode()		- sets the RF module into receiver mode
+*		txMode()		- sets the RF module into transmitter mode
+*		initMC()		- initialization function for Master Controller
+*		initThermo()	- initialization function for Thermostats
+*		initReg()		- initialization function for Registers
+*		addDevice()		- listens for a new device, then returns address
+*		getMessage()	- receives message from another device
+*		answerMessage()	- ACKs and handles the frame getMessage() read
+*		pairOnButton()	- pairs once the sync button asks for it
+*		getSyncMessage()- receives a sync message from a device or MC
+*		sendMessage()	- sends a message to another device
+*		sendGroupFlow()	- sends one flow value to a room's group address
+*		reportTemps()	- pushes temperatures to a subscribed MC
+*		queueMessage()	- queues a message by priority class
+*		sendQueue()		- sends queued messages of a class or higher
+*		setQueueHandler()- sets the function told of each queued send result
+*		setQueueYield()	- sets the function called between queued frames
+*		printQueueStats()- prints queue latency per class
+*		traceOpen()		- maps the binary frame trace file
+*		traceFrame()	- records one frame in the trace
+*		powerDown()		- powers the nRF24L01 down
+*		wakeRadio()		- powers the nRF24L01 back up into RX mode
+*		sleepWindow()	- works out how long the radio may sleep
+*		wakeDue()		- tells if a wake time has been reached
+*		dutyAccount()	- adds up the time the radio spent awake and asleep
+*		sleepNetwork()	- tells the nodes to sleep, then sleeps the MC radio
+*		printDutyStats()- prints radio awake time and late wakes
+*		sendBeacon()	- broadcasts the network time when it is due
+*		syncBeacon()	- adjusts the local offset to a received beacon
+*		netTime()		- returns the network time in ms
+*		msToPhase()		- ms until the network time reaches a phase
+*		setParent()		- sets the thermostat that relays to a register
+*		sendRouted()	- sends directly or through a relay, by link loss
+*		sendRelay()		- sends a message through a thermostat
+*		relayFrame()	- forwards a relayed message (thermostats only)
+*		identVal()		- builds the pairing value with version and caps
+*		storeIdent()	- stores a device's protocol version and caps
+*		linkCaps()		- capabilities shared with a device
+*		onSetGroup()	- takes a SET_GROUP (registers)
+*		onSubscribe()	- takes a SUBSCRIBE (thermostats)
+*		onSleepUntil()	- takes a SLEEP_UNTIL
+*		onTimeBeacon()	- takes a TIME_BEACON
+*		onGetSyncStats()- answers a GET_SYNC_STATS
+*		onRelay()		- takes a RELAY (thermostats)
+*		dispatchMessage()- routes a frame no one is waiting on
+*		awaitReply()	- waits for one reply, dispatching other frames
+*		awaitPairing()	- waits for a device to confirm its address
+*		setTelemetryHandler()- sets the function given pushed readings
+*		initButton()	- installs the sync button edge interrupt
+*		syncButtonISR()	- tracks sync button presses
+*		getLatency()	- adds a getMessage() call to its histogram
+*		printGetLatency()- prints the getMessage() latency histogram
+*		txWait()		- bounded wait for a frame to finish sending
+*		packTemps()		- packs two temperatures into one value
+*		unpackTemps()	- unpacks two temperatures from one value
+*		setTelemetry()	- keeps the thermostat's last sample
+*		onGetTelemetry()- answers a GET_TELEMETRY (thermostats)
+*		batchSample()	- buffers one temperature sample (thermostats)
+*		packBatch()		- delta encodes buffered samples into one frame
+*		unpackBatch()	- decodes the samples of a RETURN_BATCH
+*		onGetBatch()	- answers a GET_BATCH (thermostats)
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <wiringPi.h>
+#include <wiringPiSPI.h>
+#include <time.h>
+#include "messaging.h"
+#include "trace.h"
+
+// Global variables to be used by functions
+unsigned char myAddr = 0;
+unsigned char Master;
+int LEDStatus = 2;
+int addrCount;
+int init = 0;
+int devCount = 0;
+int myNumber = 0;
+unsigned char myGroup = 0;	// room group address set by SET_GROUP (registers only)
+int mySlot = 0;				// ACK slot within the group
+int subDelta = 0;			// temperature change that triggers a report (thermostats only)
+int subMax = 0;				// max seconds between reports, (0) not subscribed
+int lastCurr;				// last reported current temperature
+int lastSet;				// last reported set temperature
+unsigned int lastPush;		// millis() of the last report (thermostats only)
+int msgQueue[queueSize][7];	// frames waiting to be sent, see qPrio..qSeq
+int queueCount = 0;
+int queueSeq = 0;
+int msgPriority = 1;		// (1) send by class, (0) send in queued order after the poll sweep
+void (*queueHandler)(unsigned char, unsigned char, int, int, int) = NULL;
+int (*queueYield)(void) = NULL;	// called between queued frames, see setQueueYield()
+int latCount[3];			// frames sent per class
+unsigned long long latTotal[3];	// total microseconds from queueing to send per class
+unsigned int latMax[3];		// worst microseconds from queueing to send per class
+struct traceRecord *traceRing = NULL;	// mapped trace records, NULL when tracing is off
+uint32_t traceSeq = 0;
+unsigned char txRetry[256];	// unACKed sends in a row to each address
+int radioAsleep = 0;		// (1) radio powered down by powerDown()
+unsigned int wakeAt;		// millis() the radio is due to wake
+int dutyAwake = 1;			// power state dutyAccount() is timing
+unsigned int dutyLast = 0;	// millis() of the last power state change
+unsigned long long awakeMs = 0;
+unsigned long long asleepMs = 0;
+int sleepCount = 0;
+int lateWakes = 0;			// wakes more than wakeLate ms after wakeAt
+unsigned int maxLate = 0;
+int netOffset = 0;			// network time minus local millis(), 0 on the MC
+unsigned int lastBeacon;	// network time of the last beacon sent or received
+int beaconCount = 0;
+int syncErr = 0;			// ms the local clock was off at the last beacon
+int syncMaxErr = 0;
+int driftPpm = 0;			// local clock drift measured between the last beacons
+int relayMode = 0;			// (1) let sendRouted() relay through parent thermostats
+unsigned char relayParent[256];	// parent thermostat of each register, (0) none
+unsigned char linkLoss[256];	// recent % of direct sends not ACKed, by address
+unsigned char relayLoss[256];	// recent % of relayed sends not ACKed, by address
+unsigned int relayCount[256];	// relayed sends to each address, for probing
+unsigned char devVersion[256];	// protocol version sent during pairing, by address
+unsigned short devCaps[256];	// capabilities sent during pairing, by address
+unsigned int lastRx;		// millis() when getMessage() last read a frame
+int btnInit = 0;			// (1) syncButtonISR() is installed
+int telCurr;				// last sample given to setTelemetry() (thermostats only)
+int telSet;
+int telHum = -1;
+int telValid = 0;
+int batchBuf[batchMax];		// buffered samples in 0.1F, oldest first (thermostats only)
+unsigned int batchAt[batchMax];	// millis() each buffered sample was taken
+int batchCount = 0;
+int spiReady = 0;			// (1) SPI channel opened by initRF()
+int txTimeouts = 0;			// sends that never completed, each followed by initRF()
+volatile int btnDown = 0;	// (1) sync button held, set by syncButtonISR()
+volatile unsigned int pressedAt;	// millis() when the sync button was pressed
+volatile int pairRequested = 0;	// (1) sync button held for syncHold, see pairOnButton()
+unsigned char lastFrame[11];	// frame getMessage() last read, see answerMessage()
+int answerDue = 0;			// (1) lastFrame has not been ACKed and handled yet
+unsigned int getLatHist[getLatBuckets];	// getMessage() calls by duration, bucket n is under 2^n us
+unsigned int getLatMax = 0;
+void (*telemetryHandler)(unsigned char, unsigned char, int, int) = NULL;
+
+// Message types by code: name, msgTable flags, route on the MC, handler on the devices
+const struct msgInfo msgTable[256] =
+{
+	[SEND_BYTE]			= {"SEND_BYTE",			0,									routeNone,		NULL},
+	[RETURN_BYTE]		= {"RETURN_BYTE",		0,									routeReply,		NULL},
+	[ACK]				= {"ACK",				msgNoAck,							routeNone,		NULL},
+	[SET_TEMP]			= {"SET_TEMP",			0,									routeNone,		NULL},
+	[GET_TEMPS]			= {"GET_TEMPS",			0,									routeNone,		NULL},
+	[RETURN_TEMPS]		= {"RETURN_TEMPS",		0,									routeTelemetry,	NULL},
+	[GET_HUM]			= {"GET_HUM",			0,									routeNone,		NULL},
+	[RETURN_HUM]		= {"RETURN_HUM",		0,									routeReply,		NULL},
+	[GET_FLOW]			= {"GET_FLOW",			0,									routeNone,		NULL},
+	[RETURN_FLOW]		= {"RETURN_FLOW",		msgRawVal1,							routeReply,		NULL},
+	[SET_FLOW]			= {"SET_FLOW",			msgRawVal1,							routeNone,		NULL},
+	[SET_GROUP]			= {"SET_GROUP",			0,									routeNone,		onSetGroup},
+	[GROUP_FLOW]		= {"GROUP_FLOW",		msgNoAck|msgRawVal1,				routeNone,		NULL},
+	[SUBSCRIBE]			= {"SUBSCRIBE",			0,									routeNone,		onSubscribe},
+	[SLEEP_UNTIL]		= {"SLEEP_UNTIL",		msgNoAck|msgRawVal1|msgQuiet,		routeNone,		onSleepUntil},
+	[TIME_BEACON]		= {"TIME_BEACON",		msgNoAck|msgRawVal1|msgQuiet,		routeNone,		onTimeBeacon},
+	[GET_SYNC_STATS]	= {"GET_SYNC_STATS",	0,									routeNone,		onGetSyncStats},
+	[RETURN_SYNC_STATS]	= {"RETURN_SYNC_STATS",	msgRawVal1,							routeReply,		NULL},
+	[RELAY]				= {"RELAY",				0,									routeNone,		onRelay},
+	[RELAY_RESULT]		= {"RELAY_RESULT",		0,									routeReply,		NULL},
+	[GET_TELEMETRY]		= {"GET_TELEMETRY",		0,									routeNone,		onGetTelemetry},
+	[RETURN_TELEMETRY]	= {"RETURN_TELEMETRY",	msgRawVal1,							routeTelemetry,	NULL},
+	[GET_BATCH]			= {"GET_BATCH",			0,									routeNone,		onGetBatch},
+	[RETURN_BATCH]		= {"RETURN_BATCH",		msgRawVal1,							routeTelemetry,	NULL},
+	[CREATE_ADDR]		= {"CREATE_ADDR",		msgNoAck|msgRawVal1,				routePairing,	NULL},
+	[SET_ADDR]			= {"SET_ADDR",			msgNoAck|msgRawVal1,				routePairing,	NULL},
+	[REJECT_ADDR]		= {"REJECT_ADDR",		msgNoAck|msgRawVal1,				routePairing,	NULL},
+	[RECEIVED_ADDR]		= {"RECEIVED_ADDR",		msgNoAck|msgRawVal1,				routePairing,	NULL},
+	[ADDR_NOT_SET]		= {"ADDR_NOT_SET",		msgNoAck|msgRawVal1,				routePairing,	NULL},
+};
+
+/**************************************************************************
+*	initRF()
+*
+*	To be used prior to initialization. Sets the RF module's registers to
+*	desired settings.
+*
+*	PARAMETERS:
+*		Input: none
+*		Output: integer indicating success(1), or failure(0)
+*
+**************************************************************************/
+int initRF(void)
+{
+	// printf("\nStarting initRF()");
+	// Initialize Sync GPIO
+	pinMode(CE, OUTPUT);
+	digitalWrite(CE, LOW);
+	pinMode(SyncLED, OUTPUT);
+	digitalWrite(SyncLED, HIGH);
+	pinMode(SyncBtn, INPUT);
+	
+	// Initialize Variables used
+	unsigned char data[11];
+	int a;
+	
+	// Initialize SPI module: Channel 0, 8Mbps, once
+	if ((!spiReady) && (wiringPiSPISetup(Chan, Speed) < 0))
+	{
+		// printf("\nInitRF() failed!");
+		a = 0;
+		init = 2;
+	}
+	else
+	{
+		spiReady = 1;
+		
+		// Flush TX and RX_FIFOs
+		writeReadRF((unsigned char)(FLUSH_TX), data, 1);
+		writeReadRF((unsigned char)(FLUSH_RX), data, 1);
+		
+		// Clear all STATUS flags
+		data[0] = 0x70;
+		writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+		
+		// Disable Auto Acknowledge
+		data[0] = 0x00;
+		writeReadRF((unsigned char)(W_REGISTER|EN_AA), data, 2);
+		
+		// Disable all but first data pipe
+		data[0] = 0x01;
+		writeReadRF((unsigned char)(W_REGISTER|EN_RXADDR), data, 2);
+		
+		// Config Initializes: PWR_UP (0), CRC enabled, 1 byte CRC
+		data[0] = 0x08;
+		writeReadRF((unsigned char)(W_REGISTER|CONFIG), data, 2);
+		
+		a = 1;
+		init = 1;
+		// printf("\nInitRF() Successful!");
+	}
+	printf("\nLeaving initRF()\n");
+	return a;
+}
+
+/**************************************************************************
+*	writeReadRF()
+*
+*	Used by the functions as an all purpose SPI read/write command.
+*	Designed to condense the functions that use the same code flow several
+*	times.
+*
+*	PARAMETERS:
+*		Input:	unsigned character command for the function of the nRF24L01
+*				unsigned character pointer to the data array
+*					clear the array before read command.
+*				integer total byte length of SPI transfer including command
+*		Output: unsigned character contents of the nRF24L01's STATUS
+*
+**************************************************************************/
+unsigned char writeReadRF(unsigned char command, unsigned char *data, int length)
+{
+	// Define variables to be used
+	int i;
+	unsigned char dataBuffer[12];
+	unsigned char status;
+	
+	// Command Byte always first
+	dataBuffer[0] = command;
+	
+	// Write data to buffer
+	for(i = 1; i < length; i++)
+	{
+		dataBuffer[i] = data[(i - 1)];
+	}
+	// Clear the remaining space in buffer
+	for(i = length; i < sizeof(dataBuffer); i++)
+	{
+		dataBuffer[i] = 0x00;
+	}
+	delay(1);
+	
+	// Simultaneous read/write to SPI module
+	wiringPiSPIDataRW(Chan, dataBuffer, length);
+	delay(1);
+	
+	// STATUS Register is always returned first
+	status = dataBuffer[0];
+	
+	// Write to the data buffer input
+	for(i = 0; i < 11; i++)
+	{
+		data[i] = dataBuffer[(i + 1)];
+	}
+	
+	return status;
+}
+
+/**************************************************************************
+*	rxMode()
+*
+*	Used by the functions to set the nRF24L01 into receiver mode
+*
+*	PARAMETERS:
+*		Input:	None
+*		Output: None
+*
+**************************************************************************/
+void rxMode(void)
+{
+	// printf("\nEntering RX Mode");
+	// Declare function variables
+	int i;
+	unsigned char data[11];
+	
+	// CE starts LOW
+	digitalWrite(CE, LOW);
+	delay(1);
+	
+	// CONFIG: PWR_UP (1), CRC enabled, 1byte CRC, RX mode
+	data[0] = 0x7B;
+	for(i = 1; i < sizeof(data); i++)
+	{
+		data[i] = 0x00;
+	}
+	writeReadRF((unsigned char)(W_REGISTER|CONFIG), data, 2);
+	
+	// Set desired payload width to 11 bytes
+	data[0] = 11;
+	for(i = 1; i < sizeof(data); i++)
+	{
+		data[i] = 0x00;
+	}
+	writeReadRF((unsigned char)(W_REGISTER|RX_PW_P0), data, 2);
+	
+	// Start listening
+	digitalWrite(CE, HIGH);
+	delay(1);
+	
+	// printf("\n");
+	return;
+}
+
+/**************************************************************************
+*	txMode()
+*
+*	Used by the functions to set the nRF24L01 into transmitter mode
+*
+*	PARAMETERS:
+*		Input:	None
+*		Output: None
+*
+**************************************************************************/
+void txMode(void)
+{
+	// printf("\nEntering TX Mode");
+	// Declare function variables
+	int i;
+	unsigned char data[11];
+	
+	// CE starts LOW
+	digitalWrite(CE, LOW);
+	delay(1);
+	
+	// CONFIG: PWR_UP (1), CRC enabled, 1byte CRC, TX mode
+	data[0] = 0x7A;
+	for(i = 1; i < sizeof(data); i++)
+	{
+		data[i] = 0x00;
+	}
+	writeReadRF((unsigned char)(W_REGISTER|CONFIG), data, 2);
+	
+	// printf("\n");
+	return;
+}
+/**************************************************************************
+*	initMC()
+*
+*	To be used by the Master Control device. Generates an address for the
+*	Master controller, then listens for a device id from a thermostat, 
+*	then registers. For each device, an address is generated and sent out.
+*	The MC then listens for an ACK packet from the same device. The address
+*	created for that device is only saved if an ACK packet is received.
+*
+*	PARAMETERS:
+*		Input:	int pointer to variable for total number of devices
+*				unsigned char pointer to array of devices listed in order
+*		Output: integer indicating success(1), or failure(0)
+*
+**************************************************************************/
+int initMC(int *devNumber, unsigned char *devArray)
+{
+	printf("\nInitializing MC!\n");
+	
+	// Declare and Initialize function variables
+	unsigned char source;
+	int stat;
+	unsigned char msgCommand;
+	unsigned char thermoAddr;
+	unsigned char regAddr;
+	unsigned char dev[126];
+	int ident = 0;
+	int data1;
+	int data2;
+	int i;
+	int success = 0;
+	devCount = 0;
+	
+	myAddr = 0;
+	LEDStatus = 0;
+	
+	if(init == 0)
+	{
+		initRF();
+	}
+	delay(1);
+	piThreadCreate(SyncLEDPulse);
+	
+	printf("\nLED blinking");
+	
+	for(i = 0; i < sizeof(dev); i++)
+	{
+		dev[i] = 0;
+	}
+	
+	// printf("\ndevArray cleared");
+	
+	srand(time(NULL));
+	myAddr = ((rand() % 15) + 1) & 0xFF;
+	addrCount = myAddr;
+	printf("\nMy Addr: %#.2x", myAddr);
+	
+	rxMode();
+	printf("\nSend Thermostat ID");
+	delay(25);
+	do
+	{
+		stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
+		//printf("\nstat = %d", stat);
+		if(stat == 1)
+		{
+			delay(25);
+			if((msgCommand == CREATE_ADDR) && (data1 & 0x00000080))
+			{
+				ident = data1;
+				thermoAddr = (data1 & 0xFF) | (addrCount);
+				if(addrCount >= 127)
+				{
+					printf("\nRolling over Thermostat Address");
+					thermoAddr = (data1 & 0xFF)|((addrCount + 1) & 0x7F);
+				}
+				dev[devCount] = thermoAddr;
+				printf("\nThermostat Addr: %#.2x", dev[devCount]);
+				sendMessage(SET_ADDR, SYNC, identVal(dev[devCount]), data2);
+				delay(1);
+				switch(awaitPairing())
+				{
+					case 1:
+					{
+						printf("\nThermostat Set! Send next device.");
+						storeIdent(thermoAddr, ident);
+						addrCount++;
+						devCount++;
+						printf("\n\ndevCount: %d", devCount);
+						break;
+					}
+					case 2:
+					{
+						dev[devCount] = 0;
+						printf("\nThermostat failed to initialize");
+						break;
+					}
+					default:
+					{
+						dev[devCount] = 0;
+						printf("\nTimed out. Try again.");
+					}
+				}
+			}
+			else if((msgCommand == CREATE_ADDR) && (!(data1 & 0x00000080)) && (devCount > 0))
+			{
+				ident = data1;
+				regAddr = (data1 & 0xFF) | (addrCount);
+				if(addrCount >= 128)
+				{
+					printf("\nRolling Over Register Address");
+					regAddr = (data1 & 0xFF)|((addrCount + 1) & 0x7F);
+				}
+				dev[devCount] = regAddr;
+				printf("\nRegister Addr: %#.2x", dev[devCount]);
+				
+				sendMessage(SET_ADDR, SYNC, identVal(dev[devCount]), data2);
+				delay(1);
+				switch(awaitPairing())
+				{
+					case 1:
+					{
+						printf("\nRegister Set! Send next device.");
+						storeIdent(regAddr, ident);
+						addrCount++;
+						devCount++;
+						printf("devCount: %d", devCount);
+						break;
+					}
+					case 2:
+					{
+						dev[devCount] = 0;
+						printf("\nRegister failed to initialize");
+						break;
+					}
+					default:
+					{
+						dev[devCount] = 0;
+						printf("\nTimed out. Try again.");
+					}
+				}
+			}
+			else if((msgCommand == CREATE_ADDR) && (!(data1 & 0x00000080)) && (devCount == 0))
+			{
+				printf("\nRegister pressed too early");
+				sendMessage(REJECT_ADDR, SYNC, 0, data2);
+			}
+			else
+			{
+				msgCommand = 0;
+				source = 0;
+				data1 = 0;
+				data2 = 0;
+			}
+		}
+		delay(18);
+	}while((digitalRead(SyncBtn)) && (devCount < 126));
+	if(devCount == 126)
+	{
+		printf("\nMax device count reached");
+	}
+	
+	*devNumber = devCount;
+	printf("\nNumber of devices: %d", *devNumber);
+	for(i = 0; i < sizeof(dev); i++)
+	{
+		devArray[i] = dev[i];
+	}
+	for(i = 0; i < devCount; i++)
+	{
+		printf("\nAddress[%d]: %#.2x", i, devArray[i]);
+	}
+	if(dev[0] == 0)
+	{
+		LEDStatus = 2;
+		success = 0;
+	}
+	else
+	{
+		LEDStatus = 1;
+		success = 1;
+	}
+	return success;
+}
+
+/**************************************************************************
+*	initThermo()
+*
+*	To be used by the thermostat device. Sends out a thermostat ID packet
+*	with a randomly generated number then listens for a response from the
+*	MC. If the MC sends back an address with the same number, the MC
+*	address is saved, and an ACK packet is sent out.
+*
+*	PARAMETERS:
+*		Input:	unsigned character pointer to Master Control address
+*		Output: integer indicating success(1), or failure(0)
+*
+**************************************************************************/
+int initThermo(unsigned char *MCAddr)
+{
+	printf("\nInitializing Thermostat!\n");
+	unsigned char source;
+	unsigned char stat;
+	unsigned char msgCommand;
+	int data1;
+	int data2;
+	int j;
+	int a;
+	
+	if(LEDStatus != 0)
+	{
+		LEDStatus = 0;
+		piThreadCreate(SyncLEDPulse);
+	}
+	myAddr = 0;
+	delay(1);
+	
+	if(myNumber == 0)
+	{
+		srand(time(NULL));
+		myNumber = rand();
+	}
+	
+	sendMessage(CREATE_ADDR, SYNC, identVal(thermoID), myNumber);
+	j = 0;
+	
+	do
+	{
+		stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
+		//printf("\nstat = %d", stat);
+		if(stat == 1)
+		{
+			if((msgCommand == SET_ADDR) && (data1 & 0x80) && (data2 == myNumber))
+			{
+				myAddr = (data1 & 0xFF);
+				*MCAddr = source;
+				delay(25);
+				storeIdent(source, data1);
+				sendMessage(RECEIVED_ADDR, *MCAddr, identVal(0), 0);
+				printf("\nMy Address: %#.2x\nMC Address: %#.2x", myAddr, *MCAddr);
+				LEDStatus = 1;
+				a = 1;
+			}
+			else if((msgCommand == SET_ADDR) && (data1 & 0x80) && (data2 != myNumber))
+			{
+				*MCAddr = source;
+				delay(25);
+				sendMessage(ADDR_NOT_SET, *MCAddr, 0, 0);
+			}
+			else
+			{
+				msgCommand = 0;
+				source = 0;
+				data1 = 0;
+				data2 = 0;
+			}
+		}
+		delay(18);
+		j++;
+	}while((myAddr == 0) && (j < 250));
+	if(j == 250)
+	{
+		printf("\nTimeout. Leaving Thermostat initialization.\n");
+		LEDStatus = 2;
+		a = 0;
+	}
+	else
+	{
+		printf("\nAddress set\n");
+	}
+	rxMode();
+	return a;
+}
+
+/**************************************************************************
+*	initReg()
+*
+*	To be used by the register devices. Sends out a register ID packet
+*	with a randomly generated number then listens for a response from the
+*	MC. If the MC sends back an address with the same number, the MC
+*	address is saved, and an ACK packet is sent out. If a reject packet is
+*	received, the program exits with a failure status.
+*
+*	PARAMETERS:
+*		Input:	int pointer to Master Control address
+*		Output: integer indicating success(1), or failure(0)
+*
+**************************************************************************/
+int initReg(unsigned char *MCAddr)
+{
+	printf("\nInitializing Register!\n");
+	unsigned char source;
+	unsigned char stat;
+	unsigned char msgCommand;
+	int data1;
+	int data2;
+	int j;
+	int a;
+	
+	if(LEDStatus != 0)
+	{
+		LEDStatus = 0;
+		piThreadCreate(SyncLEDPulse);
+	}
+	
+	myAddr = 0;
+	delay(1);
+	
+	if(myNumber == 0)
+	{
+		srand(time(NULL));
+		myNumber = rand();
+	}
+	sendMessage(CREATE_ADDR, SYNC, identVal(regID), myNumber);
+	j = 0;
+	
+	do
+	{
+		stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
+		//printf("\nstat = %d", stat);
+		if(stat == 1)
+		{
+			if((msgCommand == SET_ADDR) && !(data1 & 0x80) && (data2 == myNumber))
+			{
+				myAddr = (data1 & 0xFF);
+				*MCAddr = source;
+				delay(25);
+				storeIdent(source, data1);
+				sendMessage(RECEIVED_ADDR, *MCAddr, identVal(0), 0);
+				printf("\nMy Address: %#.2x\nMC Address: %#.2x", myAddr, *MCAddr);
+				LEDStatus = 1;
+				a = 1;
+			}
+			else if((msgCommand == SET_ADDR) && !(data1 & 0x80) && (data2 != myNumber))
+			{
+				*MCAddr = source;
+				delay(25);
+				sendMessage(ADDR_NOT_SET, *MCAddr, 0, 0);
+			}
+			else if(msgCommand == REJECT_ADDR)
+			{
+				LEDStatus = 2;
+				a = 0;
+			}
+			else
+			{
+				myAddr = 0;
+				msgCommand = 0;
+				data1 = 0;
+				data2 = 0;
+				LEDStatus = 0;
+			}
+		}
+		delay(18);
+		j++;
+	}while((myAddr == 0) && (j < 250) && (LEDStatus != 2));
+	if(j == 250)
+	{
+		LEDStatus = 2;
+		a = 0;
+		printf("\nTimeout. Leaving Register initialization.\n");
+	}
+	/* else if(LEDStatus == 2)
+	{
+		printf("\nNot your time.");
+	}
+	else
+	{
+		printf("\nAddress set\n");
+	} */
+	rxMode();
+	return a;
+}
+
+/**************************************************************************
+*	addDevice()
+*
+*	To be used by the Master Control device. Listens for a device ID to be
+*	transmitted by a thermostat or register. Once it receives the ID, it
+*	generates an address for the device, then sends it to the device. The
+*	MC then waits for a confirmation packet from the device. The function
+*	then returns from execution.
+*
+*	PARAMETERS:
+*		Input:	unsigned char pointer to a device address variable
+*				integer indicating expected device type
+*		Output: integer indicating success(1), or failure(0)
+*
+**************************************************************************/
+int addDevice(unsigned char *devAddr, int type)
+{
+	printf("\nAdding a Device!\n");
+	unsigned char source;
+	int stat;
+	unsigned char msgCommand;
+	unsigned char thermoAddr;
+	unsigned char regAddr;
+	int dev = 0;
+	int ident = 0;
+	int data1;
+	int data2;
+	int success = 0;
+	
+	LEDStatus = 0;
+	delay(1);
+	piThreadCreate(SyncLEDPulse);
+	
+	rxMode();
+	printf("\nSend Device ID");
+	delay(25);
+	
+	while(!(digitalRead(SyncBtn)))
+	{
+		delay(20);
+	}
+	while((success == 0) && digitalRead(SyncBtn) && devCount < 126)
+	{
+		stat = getSyncMessage(&msgCommand, &source, &data1, &data2);
+		if(stat == 1)
+		{
+			delay(25);
+			if((msgCommand == CREATE_ADDR) && (data1 & 0x00000080) && (type == 1))
+			{
+				ident = data1;
+				thermoAddr = (data1 & 0xFF) | (addrCount);
+				if(addrCount >= 127)
+				{
+					thermoAddr = (data1 & 0xFF)|((addrCount+1) & 0x7F);
+				}
+				dev = thermoAddr;
+				printf("\nThermostat Addr: %#.2x", dev);
+				sendMessage(SET_ADDR, SYNC, identVal(dev), data2);
+				delay(1);
+				switch(awaitPairing())
+				{
+					case 1:
+					{
+						printf("\nThermostat Set! Send next device.");
+						storeIdent(thermoAddr, ident);
+						addrCount++;
+						devCount++;
+						success = 1;
+						break;
+					}
+					case 2:
+					{
+						dev = 0;
+						success = 2;
+						break;
+					}
+					default:
+					{
+						dev = 0;
+						printf("\nTimed out.");
+					}
+				}
+			}
+			else if((msgCommand == CREATE_ADDR) && (!(data1 & 0x00000080)) && (type == 2))
+			{
+				ident = data1;
+				regAddr = (data1 & 0xFF) | (addrCount);
+				if(addrCount >= 128)
+				{
+					regAddr = (data1 & 0xFF)|((addrCount + 1) & 0x7F);
+				}
+				dev = regAddr;
+				printf("\nRegister Addr: %#.2x", dev);
+				
+				sendMessage(SET_ADDR, SYNC, identVal(dev), data2);
+				delay(1);
+				switch(awaitPairing())
+				{
+					case 1:
+					{
+						printf("\nRegister Set! Send next device.");
+						storeIdent(regAddr, ident);
+						addrCount++;
+						devCount++;
+						success = 1;
+						break;
+					}
+					case 2:
+					{
+						dev = 0;
+						success = 2;
+						break;
+					}
+					default:
+					{
+						dev = 0;
+						printf("\nTimed out. Try again.");
+					}
+				}
+			}
+			else
+			{
+				msgCommand = 0;
+				source = 0;
+				data1 = 0;
+				data2 = 0;
+			}
+		}
+		delay(18);
+	}
+	if(devCount == 126)
+	{
+		printf("\nMax device count reached");
+	}
+	
+	*devAddr = dev;
+	if(dev == 0)
+	{
+		LEDStatus = 2;
+		success = 0;
+	}
+	else
+	{
+		LEDStatus = 1;
+		success = 1;
+	}
+	return success;
+}
+
+/*************************************************************************
+*	getMessage()
+*
+*	Checks for available message, then reads the contents of the RX FIFO.
+*	One frame is read per call; any frames queued behind it stay in the
+*	FIFO for the next call instead of being flushed. The frame is only
+*	read here, answerMessage() ACKs it and runs its handler.
+*
+*	PARAMETERS:
+*		Input:	unsigned char pointer to the type of message
+*				unsigned char pointer to source address
+*				int pointer to first data value
+*				int pointer to second data value
+*				int type of device calling the getMessage
+*					(0) Master Control, (1) Thermostat, (2) Register
+*		Output: int that indicates a read packet: (0) No Packet, (1) Packet
+*
+**************************************************************************/
+int getMessage(unsigned char *msgType, unsigned char *msgSourceAddr, int *msgVal1, int *msgVal2, int devType)
+{
+	// printf("\nReading Message");
+	int i;
+	int a;
+	int group;
+	unsigned int start = micros();
+	unsigned char data[11];
+	unsigned char stat;
+	
+	if(init == 0)
+	{
+		if(initRF())
+		{
+			printf("\nRF Module Initialized");
+		}
+		else
+		{
+			printf("\nRF Module failed to initialize");
+		}
+	}
+	if((!btnInit) && (devType != typeMC))
+	{
+		initButton();
+	}
+	if(radioAsleep)
+	{
+		// Stay powered down until the wake time or a sync button press
+		if(wakeDue(millis(), wakeAt) || btnDown || pairRequested)
+		{
+			wakeRadio(millis());
+		}
+		else
+		{
+			getLatency(start);
+			return 0;
+		}
+	}
+	//printf("\nMy address: %#.2x", myAddr);
+	stat = writeReadRF((unsigned char)(NOP), data, 1);
+	// RX_P_NO shows a frame is still queued after RX_DR was cleared
+	if(((stat & 0x40) || ((stat & 0x0E) != 0x0E)) && (myAddr != 0))
+	{
+		for(i = 0; i < sizeof(data); i++)
+		{
+			data[i] = 0x00;
+		}
+		writeReadRF((unsigned char)(R_RX_PAYLOAD), data, 12);
+		lastRx = millis();
+		traceFrame(traceRX, data, stat, 0);
+		
+		// Group flows are only taken by registers of that room's group
+		group = ((data[2] == GROUP_FLOW) && (myGroup != 0) && (data[0] == myGroup));
+	
+		if(((data[0] == myAddr) || (data[0] == BROADCAST) || group) && ((data[2] != GROUP_FLOW) || group))
+		{
+			*msgType = data[2];
+			*msgSourceAddr = data[1];
+			*msgVal1 = (data[3] << 24)|(data[4] << 16)|(data[5] << 8)|(data[6]);
+			*msgVal2 = (data[7] << 24)|(data[8] << 16)|(data[9] << 8)|(data[10]);
+		
+			printf("\nReturned msgTyp: %#.2x\nReturned SourceAddr: %#.2x\nReturned Payload: %d %d", *msgType, *msgSourceAddr, *msgVal1, *msgVal2);
+			
+			// The ACK and the handler are left to answerMessage()
+			for(i = 0; i < sizeof(data); i++)
+			{
+				lastFrame[i] = data[i];
+			}
+			answerDue = 1;
+			
+			// Frames queued behind this one are left for the next call
+			data[0] = 0x40;
+			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+			
+			if(group)
+			{
+				// Group flows are handed to the device as a normal SET_FLOW
+				*msgType = SET_FLOW;
+				*msgVal1 = *msgVal2;
+			}
+			a = 1;
+		}
+		else
+		{
+			a = 0;
+		
+			// printf("\nReturned msgTyp: %#.2x\nReturned SourceAddr: %#.2x\nReturned Payload: %d %d", *msgType, *msgSourceAddr, *msgVal1, *msgVal2);
+			
+			data[0] = 0x40;
+			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+		}
+	}
+	else
+	{
+		a = 0;
+	}
+	getLatency(start);
+		return a;
+}
+
+/**************************************************************************
+*	answerMessage()
+*
+*	To be called once getMessage() returns a frame, before it is called
+*	again. Sends the ACK the frame's sender is waiting for, in this
+*	device's slot for a group frame, then runs the frame's msgTable
+*	handler. Kept apart from getMessage() so a read never waits on the
+*	ACK timing or on a handler that sends.
+*
+*	PARAMETERS:
+*		Input:	int type of device calling the answerMessage
+*					(0) Master Control, (1) Thermostat, (2) Register
+*		Output: integer (1) ACK sent or none owed (0) ACK failed
+*
+**************************************************************************/
+int answerMessage(int devType)
+{
+	int i;
+	int a;
+	int group;
+	int val1;
+	int val2;
+	unsigned char type;
+	unsigned char source;
+	unsigned char data[11];
+	unsigned char frame[11];
+	unsigned char stat;
+	
+	if(!answerDue)
+	{
+		return 1;
+	}
+	answerDue = 0;
+	
+	type = lastFrame[2];
+	source = lastFrame[1];
+	val1 = (lastFrame[3] << 24)|(lastFrame[4] << 16)|(lastFrame[5] << 8)|(lastFrame[6]);
+	val2 = (lastFrame[7] << 24)|(lastFrame[8] << 16)|(lastFrame[9] << 8)|(lastFrame[10]);
+	group = ((type == GROUP_FLOW) && (myGroup != 0) && (lastFrame[0] == myGroup));
+	
+	if((group && !(val1 & groupAckReq)) || (msgTable[type].flags & msgQuiet))
+	{
+		// No ACK was requested for this group frame, or every
+		// node would answer this broadcast at once
+		a = 1;
+	}
+	else
+	{
+		if(group)
+		{
+			// Members ACK in turn so their replies do not collide
+			delay(mySlot * groupSlot);
+		}
+		txMode();
+		delay(25);
+	
+		data[0] = source;
+		data[1] = myAddr;
+		data[2] = ACK;
+		data[3] = 0;
+		data[4] = 0;
+		data[5] = 0;
+		data[6] = type;
+		data[7] = (val1 >> 24) & 0xFF;
+		data[8] = (val1 >> 16) & 0xFF;
+		data[9] = (val1 >> 8) & 0xFF;
+		data[10] = val1 & 0xFF;
+		for(i = 0; i < sizeof(data); i++)
+		{
+			frame[i] = data[i];
+		}
+	
+		stat = writeReadRF((unsigned char)(W_TX_PAYLOAD), data, 12);
+	
+		digitalWrite(CE, HIGH);
+		delayMicroseconds(100);
+		digitalWrite(CE, LOW);
+		delayMicroseconds(100);
+	
+		stat = txWait();
+		traceFrame(traceTX, frame, stat, 0);
+	
+		if((stat == 0) || (stat & 0x10))
+		{
+			printf("\nFailed to ACK");
+			data[0] = 0x30;
+			stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+			a = 0;
+		}
+		else
+		{
+			printf("\nACK sent");
+			data[0] = 0x30;
+			stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+			a = 1;
+		}
+		rxMode();
+	}
+	
+	if(msgTable[type].handler != NULL)
+	{
+		msgTable[type].handler(source, val1, val2, devType);
+	}
+	return a;
+}
+
+/**************************************************************************
+*	pairOnButton()
+*
+*	For use by Thermostats and Registers, called from the device's main
+*	loop. Runs the pairing routine once syncButtonISR() has seen the
+*	sync button held for syncHold, or it is still held past syncHold.
+*	Pairing blocks until it is done, so it is kept out of getMessage().
+*
+*	PARAMETERS:
+*		Input:	int type of device calling the pairOnButton
+*					(1) Thermostat, (2) Register
+*		Output: integer (1) pairing was run (0) not requested
+*
+**************************************************************************/
+int pairOnButton(int devType)
+{
+	unsigned char data[11];
+	
+	if(!btnInit)
+	{
+		initButton();
+	}
+	if(btnDown && ((millis() - pressedAt) >= syncHold))
+	{
+		// Held long enough to pair, once per press
+		btnDown = 0;
+		pairRequested = 1;
+	}
+	if(!pairRequested)
+	{
+		return 0;
+	}
+	pairRequested = 0;
+	
+	if(radioAsleep)
+	{
+		wakeRadio(millis());
+	}
+	answerDue = 0;
+	writeReadRF((unsigned char)(FLUSH_RX), data, 1);
+	data[0] = 0x40;
+	writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+	if(devType == typeTherm)
+	{
+		initThermo(&Master);
+	}
+	else if(devType == typeReg)
+	{
+		initReg(&Master);
+	}
+	return 1;
+}
+
+/**************************************************************************
+*	getSyncMessage()
+*
+*	For use by the syncing and initialization functions. Reads a sync
+*	packet and returns the contents.
+*
+*	PARAMETERS:
+*		Input:	unsigned char pointer to the command type
+*				unsigned char pointer to source address
+*				int pointer to first sync value
+*				int pointer to second sync value
+*		Output: int that indicates a read packet: (0) No Packet, (1) Packet
+*
+**************************************************************************/
+int getSyncMessage(unsigned char *syncType, unsigned char *syncSource, int *syncVal1, int *syncVal2)
+{
+	//printf("\nReading Message");
+	int i;
+	int a;
+	unsigned char data[11];
+	unsigned char stat;
+	
+	//printf("\nMy address: %#.2x", myAddr);
+	stat = writeReadRF((unsigned char)(NOP), data, 1);
+	if(stat & 0x40)
+	{
+		for(i = 0; i < sizeof(data); i++)
+		{
+			data[i] = 0x00;
+		}
+		writeReadRF((unsigned char)(R_RX_PAYLOAD), data, 12);
+		traceFrame(traceRX, data, stat, 0);
+	
+		if(((data[0] == myAddr) || (data[0] == BROADCAST) || (data[0] == SYNC)))
+		{
+			*syncType = data[2];
+			*syncSource = data[1];
+			*syncVal1 = (data[3] << 24)|(data[4] << 16)|(data[5] << 8)|(data[6]);
+			*syncVal2 = (data[7] << 24)|(data[8] << 16)|(data[9] << 8)|(data[10]);
+			delay(1);
+		
+			// printf("\nReturned msgTyp: %#.2x\nReturned SourceAddr: %#.2x\nReturned Payload: %d %d", *syncType, *syncSource, *syncVal1, *syncVal2);
+		
+			writeReadRF((unsigned char)(FLUSH_RX), data, 1);
+			data[0] = 0x40;
+			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+			
+			a = 1;
+		}
+		else
+		{
+			a = 0;
+			delay(1);
+		
+			// printf("\nReturned msgTyp: %#.2x\nReturned SourceAddr: %#.2x\nReturned Payload: %d %d", *syncType, *syncSource, *syncVal1, *syncVal2);
+			
+			writeReadRF((unsigned char)(FLUSH_RX), data, 1);
+			data[0] = 0x40;
+			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+		}
+		//printf("\nDone Reading Message\n");
+	}
+	else
+	{
+		a = 0;
+	}
+		return a;
+}
+
+/**************************************************************************
+*	sendMessage()
+*
+*	Puts the device into TX mode, then builds a packet to be transmitted.
+*	Frames other than the ACK received while waiting for it are passed to
+*	dispatchMessage().
+*
+*	PARAMETERS:
+*		Input:	unsigned char the type of message
+*				unsigned char destination address
+*				int first data value
+*				int second data value
+*		Output: integer (0) failed transmission (1) successful transmission
+*
+**************************************************************************/
+int sendMessage(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2)
+{
+	// printf("\nBeginning sendMessage()");
+	unsigned char data[11];
+	unsigned char frame[11];
+	unsigned char stat;
+	int a = 0;
+	int ACKVal;
+	int val1;
+	int j = 0;
+	int i;
+	
+	if((msgVal1 == 0) && !(msgTable[msgType].flags & msgRawVal1))
+	{
+		srand(time(NULL));
+		msgVal1 = rand();
+	}
+	
+	if(radioAsleep)
+	{
+		wakeRadio(millis());
+	}
+	txMode();
+	
+	data[0] = msgAddr;
+	data[1] = myAddr;
+	data[2] = msgType;
+	data[3] = (msgVal1 >> 24) & 0xFF;
+	data[4] = (msgVal1 >> 16) & 0xFF;
+	data[5] = (msgVal1 >> 8) & 0xFF;
+	data[6] = (msgVal1) & 0xFF;
+	data[7] = (msgVal2 >> 24) & 0xFF;
+	data[8] = (msgVal2 >> 16) & 0xFF;
+	data[9] = (msgVal2 >> 8) & 0xFF;
+	data[10] = (msgVal2) & 0xFF;
+	for(i = 0; i < sizeof(data); i++)
+	{
+		frame[i] = data[i];
+	}
+	printf("\nSending to %#.2x: %#.2x %d %d\n", msgAddr, msgType, msgVal1, msgVal2);
+	stat = writeReadRF((unsigned char)(W_TX_PAYLOAD), data, 12);
+	
+	digitalWrite(CE, HIGH);
+	delayMicroseconds(100);
+	digitalWrite(CE, LOW);
+	delayMicroseconds(100);
+	
+	stat = txWait();
+	traceFrame(traceTX, frame, stat, txRetry[msgAddr]);
+	if(stat == 0)
+	{
+		// The radio was reset, the frame never went out
+		rxMode();
+		return 0;
+	}
+	
+	if(stat & 0x10)
+	{
+		// printf("\nFailed to send");
+		data[0] = 0x30;
+		stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+		a = 0;
+	}
+	else
+	{
+		// printf("\nSend successful");
+		data[0] = 0x30;
+		stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+		// a = 1;
+	}
+	rxMode();
+	
+	if(!(msgTable[msgType].flags & msgNoAck))
+	{
+		j = 0;
+		do
+		{
+			stat = writeReadRF((unsigned char)(NOP), data, 1);
+			while((stat & 0x40) && (a == 0))
+			{
+				for(i = 0; i < sizeof(data); i++)
+				{
+					data[i] = 0x00;
+				}
+				writeReadRF((unsigned char)(R_RX_PAYLOAD), data, 12);
+				traceFrame(traceRX, data, stat, 0);
+
+				if(((data[0] == myAddr) || (data[0] == BROADCAST)))
+				{
+					ACKVal = (data[7] << 24)|(data[8] << 16)|(data[9] << 8)|(data[10]);
+					if((data[1] == msgAddr) && (data[2] == ACK) && (ACKVal == msgVal1) && (data[6] == msgType))
+					{
+						a = 1;
+					}
+					else if(data[2] != ACK)
+					{
+						// Not the ACK, route it so a reading pushed meanwhile is kept
+						val1 = (data[3] << 24)|(data[4] << 16)|(data[5] << 8)|(data[6]);
+						dispatchMessage(data[2], data[1], val1, ACKVal);
+					}
+				}
+				// Clear RX_DR, then keep reading while RX_P_NO shows the RX FIFO
+				// holds frames, the ACK may be queued behind another device's
+				data[0] = 0x40;
+				stat = writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+				stat = ((stat & 0x0E) != 0x0E) ? 0x40 : 0;
+			}
+			j++;
+			delay(18);
+		}while((j < 50) && (a == 0));
+		
+		linkLoss[msgAddr] = ((linkLoss[msgAddr] * 7) + (a ? 0 : 100)) / 8;
+		if(a)
+		{
+			txRetry[msgAddr] = 0;
+		}
+		else if(txRetry[msgAddr] < 255)
+		{
+			txRetry[msgAddr]++;
+		}
+	}
+	
+	return a;
+}
+
+/**************************************************************************
+*	sendGroupFlow()
+*
+*	For use by the Master Control. Sends one GROUP_FLOW frame to a room's
+*	group address so every register in the room takes the same flow. When
+*	ACKs are requested the members reply in their slot order, and each
+*	reply is matched against the list of member addresses. Other frames
+*	received meanwhile are passed to dispatchMessage().
+*
+*	PARAMETERS:
+*		Input:	unsigned char group address of the room
+*				int flow value to be set
+*				unsigned char pointer to the member register addresses
+*				int number of members
+*				int request member ACKs (1) or not (0)
+*				int pointer to array set to (1) for each member that ACKed
+*		Output: integer number of members that ACKed
+*
+**************************************************************************/
+int sendGroupFlow(unsigned char groupAddr, int flow, unsigned char *members, int count, int ackReq, int *acked)
+{
+	unsigned char data[11];
+	unsigned char stat;
+	int val1;
+	int ACKVal;
+	int ackCount = 0;
+	int i;
+	int j;
+	
+	for(i = 0; i < count; i++)
+	{
+		acked[i] = 0;
+	}
+	
+	val1 = groupAddr;
+	if(ackReq)
+	{
+		val1 = val1 | groupAckReq;
+	}
+	sendMessage(GROUP_FLOW, groupAddr, val1, flow);
+	if(!ackReq)
+	{
+		return 0;
+	}
+	
+	// Listen until every member slot has passed
+	j = 0;
+	do
+	{
+		stat = writeReadRF((unsigned char)(NOP), data, 1);
+		while(stat & 0x40)
+		{
+			for(i = 0; i < sizeof(data); i++)
+			{
+				data[i] = 0x00;
+			}
+			writeReadRF((unsigned char)(R_RX_PAYLOAD), data, 12);
+			traceFrame(traceRX, data, stat, 0);
+			
+			ACKVal = (data[7] << 24)|(data[8] << 16)|(data[9] << 8)|(data[10]);
+			if((data[0] == myAddr) && (data[2] == ACK) && (data[6] == GROUP_FLOW) && (ACKVal == val1))
+			{
+				for(i = 0; i < count; i++)
+				{
+					if((members[i] == data[1]) && (!acked[i]))
+					{
+						acked[i] = 1;
+						ackCount++;
+					}
+				}
+			}
+			else if((data[0] == myAddr) && (data[2] != ACK))
+			{
+				// Not a member's ACK, route it so a reading pushed meanwhile is kept
+				dispatchMessage(data[2], data[1], (data[3] << 24)|(data[4] << 16)|(data[5] << 8)|(data[6]), ACKVal);
+			}
+			
+			// Clear RX_DR, then keep reading while the RX FIFO holds frames
+			data[0] = 0x40;
+			writeReadRF((unsigned char)(W_REGISTER|STATUS), data, 2);
+			writeReadRF((unsigned char)(R_REGISTER|FIFO_STATUS), data, 2);
+			if(data[0] & 0x01)
+			{
+				stat = 0;
+			}
+			else
+			{
+				stat = 0x40;
+			}
+		}
+		j++;
+		delay(18);
+	}while((ackCount < count) && ((j * 18) < ((count * groupSlot) + 100)));
+	
+	printf("\nGroup %#.2x: %d of %d ACKed", groupAddr, ackCount, count);
+	return ackCount;
+}
+
+/**************************************************************************
+*	reportTemps()
+*
+*	To be called by the thermostat after each temperature sample. Once the
+*	MC has sent a SUBSCRIBE, the temperatures are pushed to the MC as an
+*	unsolicited RETURN_TEMPS whenever the current temperature moved by the
+*	subscribed amount, the set temperature changed, or the max interval
+*	passed since the last report. When the MC supports it the report is a
+*	RETURN_TELEMETRY carrying the humidity from setTelemetry() as well.
+*
+*	PARAMETERS:
+*		Input:	int current temperature
+*				int set temperature
+*		Output: integer (0) nothing sent or not ACKed (1) report sent
+*
+**************************************************************************/
+int reportTemps(int curr, int set)
+{
+	int a = 0;
+	unsigned int elapsed;
+	
+	if((subMax == 0) || (myAddr == 0) || radioAsleep)
+	{
+		return 0;
+	}
+	
+	elapsed = (millis() - lastPush) / 1000;
+	if((abs(curr - lastCurr) >= subDelta) || (set != lastSet) || (elapsed >= subMax))
+	{
+		if(telValid && (linkCaps(Master) & capTelemetry))
+		{
+			// Humidity rides along when the MC takes telemetry frames
+			a = sendMessage(RETURN_TELEMETRY, Master, packTemps(curr, set), telHum);
+		}
+		else
+		{
+			a = sendMessage(RETURN_TEMPS, Master, curr, set);
+		}
+		if(a)
+		{
+			lastCurr = curr;
+			lastSet = set;
+			lastPush = millis();
+		}
+	}
+	return a;
+}
+
+/**************************************************************************
+*	queueMessage()
+*
+*	Queues a message to be sent by sendQueue(). May be called from any
+*	thread. The time the message was queued is kept so the latency from
+*	the decision to the send can be measured per class.
+*
+*	PARAMETERS:
+*		Input:	int priority class (prioAct, prioUser or prioPoll)
+*				unsigned char the type of message
+*				unsigned char destination address
+*				int first data value
+*				int second data value
+*		Output: integer (0) queue full (1) message queued
+*
+**************************************************************************/
+int queueMessage(int prio, unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2)
+{
+	int a = 0;
+	
+	piLock(queueLock);
+	if(queueCount < queueSize)
+	{
+		msgQueue[queueCount][qPrio] = prio;
+		msgQueue[queueCount][qType] = msgType;
+		msgQueue[queueCount][qAddr] = msgAddr;
+		msgQueue[queueCount][qVal1] = msgVal1;
+		msgQueue[queueCount][qVal2] = msgVal2;
+		msgQueue[queueCount][qTime] = micros();
+		msgQueue[queueCount][qSeq] = queueSeq++;
+		queueCount++;
+		a = 1;
+	}
+	piUnlock(queueLock);
+	
+	if(!a)
+	{
+		printf("\nMessage queue full, dropped %#.2x to %#.2x", msgType, msgAddr);
+	}
+	return a;
+}
+
+/**************************************************************************
+*	sendQueue()
+*
+*	Sends the queued messages whose class is prio or more urgent, one
+*	frame at a time, most urgent class first and oldest first within a
+*	class. The queue is checked again between frames so a more urgent
+*	message queued meanwhile goes out next, and the queueYield function
+*	may hand the radio over to another thread there. With msgPriority (0) the
+*	queue is sent in queued order and only once the poll sweep is done
+*	(prio = prioPoll), which is how the MC sent before the queue.
+*
+*	PARAMETERS:
+*		Input:	int least urgent class to send
+*		Output: integer number of messages sent
+*
+**************************************************************************/
+int sendQueue(int prio)
+{
+	int entry[7];
+	int best;
+	int success;
+	int count = 0;
+	int i;
+	unsigned int latency;
+	
+	if((!msgPriority) && (prio < prioPoll))
+	{
+		return 0;
+	}
+	
+	do
+	{
+		piLock(queueLock);
+		best = -1;
+		for(i = 0; i < queueCount; i++)
+		{
+			if(msgPriority && (msgQueue[i][qPrio] > prio))
+			{
+				continue;
+			}
+			if(best == -1)
+			{
+				best = i;
+			}
+			else if(msgPriority && (msgQueue[i][qPrio] != msgQueue[best][qPrio]))
+			{
+				if(msgQueue[i][qPrio] < msgQueue[best][qPrio])
+				{
+					best = i;
+				}
+			}
+			else if(msgQueue[i][qSeq] < msgQueue[best][qSeq])
+			{
+				best = i;
+			}
+		}
+		if(best != -1)
+		{
+			for(i = 0; i < 7; i++)
+			{
+				entry[i] = msgQueue[best][i];
+				msgQueue[best][i] = msgQueue[queueCount - 1][i];
+			}
+			queueCount--;
+		}
+		piUnlock(queueLock);
+		
+		if(best != -1)
+		{
+			success = sendRouted(entry[qType], entry[qAddr], entry[qVal1], entry[qVal2]);
+			
+			latency = micros() - entry[qTime];
+			latCount[entry[qPrio]]++;
+			latTotal[entry[qPrio]] += latency;
+			if(latency > latMax[entry[qPrio]])
+			{
+				latMax[entry[qPrio]] = latency;
+			}
+			
+			if(queueHandler != NULL)
+			{
+				queueHandler(entry[qType], entry[qAddr], entry[qVal1], entry[qVal2], success);
+			}
+			count++;
+			if(queueYield != NULL)
+			{
+				queueYield();
+			}
+		}
+	}while(best != -1);
+	
+	return count;
+}
+
+/**************************************************************************
+*	setQueueHandler()
+*
+*	Sets the function sendQueue() calls with the result of each message
+*	it sends, so the caller can record ACKs and failures.
+*
+*	PARAMETERS:
+*		Input:	pointer to the handler function
+*		Output: none
+*
+**************************************************************************/
+void setQueueHandler(void (*handler)(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2, int success))
+{
+	queueHandler = handler;
+	return;
+}
+
+/**************************************************************************
+*	setQueueYield()
+*
+*	Sets the function sendQueue() calls after each frame, once the queue
+*	lock is released and the result handled. The MC parks there while
+*	its menu thread needs the radio, instead of only between cycles.
+*
+*	PARAMETERS:
+*		Input:	pointer to the function, returning (1) if it handed the
+*				radio over
+*		Output: none
+*
+**************************************************************************/
+void setQueueYield(int (*yield)(void))
+{
+	queueYield = yield;
+	return;
+}
+
+/**************************************************************************
+*	printQueueStats()
+*
+*	Prints the average and worst latency from queueing to sending for
+*	each class, to compare runs with and without msgPriority.
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: none
+*
+**************************************************************************/
+void printQueueStats(void)
+{
+	int i;
+	char *names[3] = {"actuation", "user", "polling"};
+	
+	printf("\nQueue latency (%s):", msgPriority ? "by priority" : "in order");
+	for(i = 0; i < 3; i++)
+	{
+		if(latCount[i])
+		{
+			printf("\n  %-9s n=%d avg=%llums max=%ums", names[i], latCount[i], (latTotal[i] / latCount[i]) / 1000, latMax[i] / 1000);
+		}
+	}
+	printf("\n");
+	return;
+}
+
+/**************************************************************************
+*	traceOpen()
+*
+*	Maps the binary trace file so every frame sent or received can be
+*	recorded with a memory copy. The file keeps the last traceCapacity
+*	frames and is read with the traceDecode tool. An existing trace with
+*	the same layout is continued, anything else is cleared.
+*
+*	PARAMETERS:
+*		Input:	char pointer to the trace file path
+*		Output: integer indicating success(1), or failure(0)
+*
+**************************************************************************/
+int traceOpen(char *path)
+{
+	int fd;
+	int i;
+	size_t size;
+	void *map;
+	struct traceHeader *header;
+	
+	size = sizeof(struct traceHeader) + (traceCapacity * sizeof(struct traceRecord));
+	fd = open(path, O_RDWR | O_CREAT, 0644);
+	if(fd < 0)
+	{
+		printf("\nTrace file %s could not be opened", path);
+		return 0;
+	}
+	if(ftruncate(fd, size) < 0)
+	{
+		printf("\nTrace file %s could not be sized", path);
+		close(fd);
+		return 0;
+	}
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		printf("\nTrace file %s could not be mapped", path);
+		return 0;
+	}
+	
+	header = (struct traceHeader *)map;
+	traceSeq = 0;
+	if((header->magic == traceMagic) && (header->version == traceVersion) &&
+	(header->recordSize == sizeof(struct traceRecord)) && (header->capacity == traceCapacity))
+	{
+		// Continue after the newest record already in the file
+		for(i = 0; i < traceCapacity; i++)
+		{
+			if(((struct traceRecord *)(header + 1))[i].seq > traceSeq)
+			{
+				traceSeq = ((struct traceRecord *)(header + 1))[i].seq;
+			}
+		}
+	}
+	else
+	{
+		memset(map, 0, size);
+		header->magic = traceMagic;
+		header->version = traceVersion;
+		header->recordSize = sizeof(struct traceRecord);
+		header->capacity = traceCapacity;
+	}
+	traceRing = (struct traceRecord *)(header + 1);
+	printf("\nTracing frames to %s", path);
+	return 1;
+}
+
+/**************************************************************************
+*	traceFrame()
+*
+*	Records one frame in the trace ring. Does nothing until traceOpen()
+*	succeeds. The record's seq is written last so a record that is being
+*	overwritten is never read as complete.
+*
+*	PARAMETERS:
+*		Input:	int direction (traceTX or traceRX)
+*				unsigned char pointer to the 11 byte frame
+*				unsigned char STATUS register contents
+*				int earlier unACKed sends to the same address
+*		Output: none
+*
+**************************************************************************/
+void traceFrame(int dir, unsigned char *frame, unsigned char stat, int retry)
+{
+	struct timespec now;
+	struct traceRecord *rec;
+	uint32_t seq;
+	
+	if(traceRing == NULL)
+	{
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	seq = __sync_add_and_fetch(&traceSeq, 1);
+	rec = &traceRing[seq % traceCapacity];
+	
+	rec->seq = 0;
+	rec->usec = ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+	rec->dir = dir;
+	rec->stat = stat;
+	rec->retry = retry;
+	memcpy(rec->frame, frame, sizeof(rec->frame));
+	__sync_synchronize();
+	rec->seq = seq;
+	return;
+}
+
+/**************************************************************************
+*	powerDown()
+*
+*	Powers the nRF24L01 down (CONFIG PWR_UP = 0) until wakeRadio(). The
+*	radio draws under a microamp in this state and receives nothing.
+*
+*	PARAMETERS:
+*		Input:	unsigned int millis() at the call
+*		Output: none
+*
+**************************************************************************/
+void powerDown(unsigned int now)
+{
+	int i;
+	unsigned char data[11];
+	
+	digitalWrite(CE, LOW);
+	
+	// CONFIG: PWR_UP (0), CRC enabled, 1byte CRC, RX mode
+	data[0] = 0x79;
+	for(i = 1; i < sizeof(data); i++)
+	{
+		data[i] = 0x00;
+	}
+	writeReadRF((unsigned char)(W_REGISTER|CONFIG), data, 2);
+	
+	dutyAccount(now, 0);
+	radioAsleep = 1;
+	sleepCount++;
+	return;
+}
+
+/**************************************************************************
+*	wakeRadio()
+*
+*	Powers the nRF24L01 back up into receiver mode and counts the wake as
+*	late if it came more than wakeLate ms after wakeAt.
+*
+*	PARAMETERS:
+*		Input:	unsigned int millis() at the call
+*		Output: none
+*
+**************************************************************************/
+void wakeRadio(unsigned int now)
+{
+	unsigned int late;
+	
+	if(!radioAsleep)
+	{
+		return;
+	}
+	rxMode();
+	delay(2);	// power up to standby takes 1.5ms
+	
+	dutyAccount(now, 1);
+	radioAsleep = 0;
+	if(wakeDue(now, wakeAt))
+	{
+		late = now - wakeAt;
+		if(late > wakeLate)
+		{
+			lateWakes++;
+		}
+		if(late > maxLate)
+		{
+			maxLate = late;
+		}
+	}
+	return;
+}
+
+/**************************************************************************
+*	sleepWindow()
+*
+*	Works out how long the radio may sleep so it is listening again guard
+*	ms before the next poll. Only uses the times it is given, so the
+*	schedule can be run against a virtual clock.
+*
+*	PARAMETERS:
+*		Input:	unsigned int current time in ms
+*				unsigned int time of the next poll in ms
+*				int ms to be awake before the poll
+*		Output: integer ms to sleep, (0) if the window is too short
+*
+**************************************************************************/
+int sleepWindow(unsigned int now, unsigned int nextPoll, int guard)
+{
+	int window;
+	
+	window = (int)(nextPoll - now) - guard;
+	if(window < minSleep)
+	{
+		return 0;
+	}
+	if(window > maxSleep)
+	{
+		window = maxSleep;
+	}
+	return window;
+}
+
+/**************************************************************************
+*	wakeDue()
+*
+*	Tells if a wake time has been reached. The difference is taken as
+*	signed so it still works when millis() wraps.
+*
+*	PARAMETERS:
+*		Input:	unsigned int current time in ms
+*				unsigned int wake time in ms
+*		Output: integer (1) wake time reached (0) not yet
+*
+**************************************************************************/
+int wakeDue(unsigned int now, unsigned int wake)
+{
+	return ((int)(now - wake) >= 0);
+}
+
+/**************************************************************************
+*	dutyAccount()
+*
+*	Adds the time since the last power state change to the awake or
+*	asleep total, then records the new state.
+*
+*	PARAMETERS:
+*		Input:	unsigned int current time in ms
+*				int new state, (1) awake (0) asleep
+*		Output: none
+*
+**************************************************************************/
+void dutyAccount(unsigned int now, int awake)
+{
+	if(dutyAwake)
+	{
+		awakeMs += now - dutyLast;
+	}
+	else
+	{
+		asleepMs += now - dutyLast;
+	}
+	dutyLast = now;
+	dutyAwake = awake;
+	return;
+}
+
+/**************************************************************************
+*	sleepNetwork()
+*
+*	For use by the Master Control between poll rounds. Broadcasts a
+*	SLEEP_UNTIL with the ms left until the next poll and the wake guard,
+*	then powers its own radio down. The nodes are not asked to ACK since
+*	they would all answer at once.
+*
+*	PARAMETERS:
+*		Input:	int ms until the next poll
+*		Output: unsigned int millis() the MC radio is due to wake, equal
+*				to the call time if the window was too short to sleep
+*
+**************************************************************************/
+unsigned int sleepNetwork(int untilPoll)
+{
+	unsigned int now;
+	int window;
+	
+	now = millis();
+	if(sleepWindow(now, now + untilPoll, wakeGuard) == 0)
+	{
+		return now;
+	}
+	sendMessage(SLEEP_UNTIL, BROADCAST, untilPoll, wakeGuard);
+	
+	// Sending took some of the window
+	untilPoll -= millis() - now;
+	now = millis();
+	window = sleepWindow(now, now + untilPoll, wakeGuard);
+	if(window == 0)
+	{
+		return now;
+	}
+	wakeAt = now + window;
+	powerDown(now);
+	return wakeAt;
+}
+
+/**************************************************************************
+*	printDutyStats()
+*
+*	Prints the share of time the radio was powered, the number of sleeps
+*	and how many wakes came late.
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: none
+*
+**************************************************************************/
+void printDutyStats(void)
+{
+	dutyAccount(millis(), dutyAwake);
+	if(awakeMs + asleepMs)
+	{
+		printf("\nRadio awake %.1f%% (%llus of %llus), %d sleeps, %d late wakes, worst %ums late\n",
+		(100.0 * awakeMs) / (awakeMs + asleepMs), awakeMs / 1000, (awakeMs + asleepMs) / 1000, sleepCount, lateWakes, maxLate);
+	}
+	return;
+}
+
+/**************************************************************************
+*	sendBeacon()
+*
+*	For use by the Master Control at the start of a poll round, while the
+*	nodes are awake. Broadcasts the network time (the MC's own millis())
+*	and the beacon interval once the interval has passed since the last
+*	beacon. Nodes do not ACK a beacon.
+*
+*	PARAMETERS:
+*		Input:	int ms between beacons
+*		Output: integer (1) beacon sent (0) not due yet
+*
+**************************************************************************/
+int sendBeacon(int interval)
+{
+	if(beaconCount && ((millis() - lastBeacon) < interval))
+	{
+		return 0;
+	}
+	lastBeacon = millis();
+	sendMessage(TIME_BEACON, BROADCAST, netTime(), interval);
+	beaconCount++;
+	return 1;
+}
+
+/**************************************************************************
+*	syncBeacon()
+*
+*	For use by Thermostats and Registers when a TIME_BEACON arrives. The
+*	error between the beacon and the local network time is how far the
+*	local clock drifted since the last beacon. It is kept, with the drift
+*	rate in ppm, for GET_SYNC_STATS, then the offset is set to the beacon.
+*	Only uses the times it is given, so it can run against a virtual clock.
+*
+*	PARAMETERS:
+*		Input:	unsigned int local millis() when the beacon was read
+*				unsigned int network time carried by the beacon
+*		Output: none
+*
+**************************************************************************/
+void syncBeacon(unsigned int now, unsigned int mcTime)
+{
+	unsigned int elapsed;
+	
+	if(beaconCount)
+	{
+		syncErr = (int)(mcTime - (now + netOffset));
+		if(abs(syncErr) > syncMaxErr)
+		{
+			syncMaxErr = abs(syncErr);
+		}
+		elapsed = mcTime - lastBeacon;
+		if(elapsed)
+		{
+			driftPpm = (int)(((long long)syncErr * 1000000) / elapsed);
+		}
+	}
+	netOffset = (int)(mcTime - now);
+	lastBeacon = mcTime;
+	beaconCount++;
+	return;
+}
+
+/**************************************************************************
+*	netTime()
+*
+*	Returns the network time: the Master Control's millis() as carried by
+*	the last beacon, advanced by the local clock since.
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: unsigned int network time in ms
+*
+**************************************************************************/
+unsigned int netTime(void)
+{
+	return millis() + netOffset;
+}
+
+/**************************************************************************
+*	msToPhase()
+*
+*	Works out how long to wait for a network time t to reach the given
+*	phase of a period, so sampling, polls and slots on different devices
+*	line up.
+*
+*	PARAMETERS:
+*		Input:	unsigned int network time in ms
+*				int period in ms
+*				int phase within the period in ms
+*		Output: integer ms to wait, from 0 to period - 1
+*
+**************************************************************************/
+int msToPhase(unsigned int t, int period, int phase)
+{
+	return (int)((((unsigned int)phase % period) + period - (t % period)) % period);
+}
+
+/**************************************************************************
+*	setParent()
+*
+*	For use by the Master Control. Sets the thermostat that may relay
+*	frames to a register, (0) for none. The MC keeps this table as
+*	devices are added, removed or moved between rooms.
+*
+*	PARAMETERS:
+*		Input:	unsigned char register address
+*				unsigned char parent thermostat address
+*		Output: none
+*
+**************************************************************************/
+void setParent(unsigned char child, unsigned char parent)
+{
+	if(relayParent[child] != parent)
+	{
+		relayLoss[child] = 0;
+		relayCount[child] = 0;
+	}
+	relayParent[child] = parent;
+	return;
+}
+
+/**************************************************************************
+*	sendRouted()
+*
+*	For use by the Master Control in place of sendMessage(). With
+*	relayMode off, or no parent for the address, the frame is sent
+*	directly. Otherwise it takes the path with less recent loss, direct
+*	or through the parent, and every relayProbe relayed sends the direct
+*	link is tried again so a register that comes back in range is used
+*	directly.
+*
+*	PARAMETERS:
+*		Input:	unsigned char the type of message
+*				unsigned char destination address
+*				int first data value
+*				int second data value
+*		Output: integer (0) failed transmission (1) successful transmission
+*
+**************************************************************************/
+int sendRouted(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2)
+{
+	int a;
+	int rType;
+	int rVal1;
+	int rVal2;
+	
+	if(!relayMode || (relayParent[msgAddr] == 0) || (linkLoss[msgAddr] <= relayLoss[msgAddr] + relayHyst))
+	{
+		return sendMessage(msgType, msgAddr, msgVal1, msgVal2);
+	}
+	relayCount[msgAddr]++;
+	if((relayCount[msgAddr] % relayProbe) == 0)
+	{
+		return sendMessage(msgType, msgAddr, msgVal1, msgVal2);
+	}
+	
+	a = sendRelay(relayParent[msgAddr], msgAddr, msgType, msgVal1, msgVal2, &rType, &rVal1, &rVal2);
+	relayLoss[msgAddr] = ((relayLoss[msgAddr] * 7) + (a ? 0 : 100)) / 8;
+	return a;
+}
+
+/**************************************************************************
+*	sendRelay()
+*
+*	For use by the Master Control. Sends a RELAY frame to a thermostat,
+*	which forwards the inner message to the register and answers with a
+*	RELAY_RESULT. The inner value 1 is carried in 16 bits.
+*
+*		RELAY / RELAY_RESULT value 1:
+*		[ register address | message type | value 1 (16 bits) ]
+*
+*	A RELAY_RESULT with type ACK means the register ACKed, type 0 that
+*	it did not, and any other type is the register's reply.
+*
+*	PARAMETERS:
+*		Input:	unsigned char parent thermostat address
+*				unsigned char register address
+*				unsigned char the type of message
+*				int first data value
+*				int second data value
+*				int pointer to the result type
+*				int pointer to the result value 1
+*				int pointer to the result value 2
+*		Output: integer (1) the register ACKed (0) it did not or the
+*				thermostat did not answer
+*
+**************************************************************************/
+int sendRelay(unsigned char parent, unsigned char child, unsigned char msgType, int msgVal1, int msgVal2, int *rType, int *rVal1, int *rVal2)
+{
+	int val1;
+	unsigned char type;
+	
+	*rType = 0;
+	val1 = (child << 24)|(msgType << 16)|(msgVal1 & 0xFFFF);
+	if(!sendMessage(RELAY, parent, val1, msgVal2))
+	{
+		return 0;
+	}
+	
+	// The thermostat answers once its own send to the register is done
+	type = RELAY_RESULT;
+	if(!awaitReply(&type, parent, relayWait, rVal1, rVal2, typeMC) || (((*rVal1 >> 24) & 0xFF) != child))
+	{
+		return 0;
+	}
+	*rType = (*rVal1 >> 16) & 0xFF;
+	*rVal1 = (short)(*rVal1 & 0xFFFF);
+	printf("\nRelay via %#.2x to %#.2x: %#.2x", parent, child, *rType);
+	return (*rType != 0);
+}
+
+/**************************************************************************
+*	relayFrame()
+*
+*	For use by Thermostats when a RELAY arrives. Sends the inner message
+*	to the register, waits for the register's reply if the message asks
+*	for one, then reports back to the sender with RELAY_RESULT.
+*
+*	PARAMETERS:
+*		Input:	unsigned char address the RELAY came from
+*				int RELAY value 1
+*				int RELAY value 2
+*		Output: integer (1) the register ACKed (0) it did not
+*
+**************************************************************************/
+int relayFrame(unsigned char source, int relayVal1, int relayVal2)
+{
+	unsigned char child;
+	unsigned char type;
+	unsigned char rType;
+	unsigned char replyType;
+	int val1;
+	int rVal1;
+	int rVal2;
+	int replyVal1;
+	int replyVal2;
+	int a;
+	
+	child = (relayVal1 >> 24) & 0xFF;
+	type = (relayVal1 >> 16) & 0xFF;
+	val1 = (short)(relayVal1 & 0xFFFF);
+	
+	a = sendMessage(type, child, val1, relayVal2);
+	rType = a ? ACK : 0;
+	rVal1 = type;
+	rVal2 = 0;
+	
+	switch(type)
+	{
+		case GET_TEMPS:
+		case GET_HUM:
+		case GET_FLOW:
+		case GET_SYNC_STATS:
+		{
+			// Pass the register's reply back up
+			replyType = 0;
+			if(a && awaitReply(&replyType, child, replyWait, &replyVal1, &replyVal2, typeTherm))
+			{
+				rType = replyType;
+				rVal1 = replyVal1;
+				rVal2 = replyVal2;
+			}
+		}
+	}
+	
+	sendMessage(RELAY_RESULT, source, (child << 24)|(rType << 16)|(rVal1 & 0xFFFF), rVal2);
+	return a;
+}
+
+/**************************************************************************
+*	identVal()
+*
+*	Builds the value 1 sent with CREATE_ADDR, SET_ADDR and RECEIVED_ADDR
+*	during pairing. Devices built before the protocol was versioned only
+*	send the low byte, so they read as version 0 with no capabilities.
+*
+*		[ capabilities (16 bits) | protoVersion | address or device ID ]
+*
+*	PARAMETERS:
+*		Input:	unsigned char address or device ID for the low byte
+*		Output: integer value 1
+*
+**************************************************************************/
+int identVal(unsigned char low)
+{
+	return (protoCaps << 16)|(protoVersion << 8)|low;
+}
+
+/**************************************************************************
+*	storeIdent()
+*
+*	Stores the protocol version and capabilities a device sent during
+*	pairing, by its address.
+*
+*	PARAMETERS:
+*		Input:	unsigned char address of the device
+*				int value 1 received from it
+*		Output: none
+*
+**************************************************************************/
+void storeIdent(unsigned char addr, int val)
+{
+	devVersion[addr] = (val >> 8) & 0xFF;
+	devCaps[addr] = (val >> 16) & 0xFFFF;
+	printf("\n%#.2x: protocol version %d, capabilities %#.4x", addr, devVersion[addr], devCaps[addr]);
+	return;
+}
+
+/**************************************************************************
+*	linkCaps()
+*
+*	Returns the capabilities both ends of a link support, so each link
+*	uses the fastest mode both devices know and older devices keep the
+*	original frames.
+*
+*	PARAMETERS:
+*		Input:	unsigned char address of the other device
+*		Output: integer capability bits (cap...) shared with the device
+*
+**************************************************************************/
+int linkCaps(unsigned char addr)
+{
+	return devCaps[addr] & protoCaps;
+}
+
+/**************************************************************************
+*	onSetGroup()
+*
+*	msgTable handler for registers. Stores the room group address and
+*	this register's ACK slot within it.
+*
+*	PARAMETERS:
+*		Input:	unsigned char source address
+*				int group address
+*				int ACK slot
+*				int type of device calling the getMessage
+*		Output: none
+*
+**************************************************************************/
+void onSetGroup(unsigned char source, int val1, int val2, int devType)
+{
+	myGroup = val1 & 0xFF;
+	mySlot = val2;
+	return;
+}
+
+/**************************************************************************
+*	onSubscribe()
+*
+*	msgTable handler for thermostats. Stores the report threshold and
+*	interval used by reportTemps().
+*
+*	PARAMETERS:
+*		Input:	unsigned char source address
+*				int temperature change that triggers a report
+*				int max seconds between reports
+*				int type of device calling the getMessage
+*		Output: none
+*
+**************************************************************************/
+void onSubscribe(unsigned char source, int val1, int val2, int devType)
+{
+	subDelta = val1;
+	subMax = val2;
+	lastPush = millis() - (subMax * 1000);	// report on the next sample
+	return;
+}
+
+/**************************************************************************
+*	onSleepUntil()
+*
+*	msgTable handler. Powers the radio down until shortly before the
+*	MC's next poll.
+*
+*	PARAMETERS:
+*		Input:	unsigned char source address
+*				int ms until the next poll
+*				int ms to be awake before the poll
+*				int type of device calling the getMessage
+*		Output: none
+*
+**************************************************************************/
+void onSleepUntil(unsigned char source, int val1, int val2, int devType)
+{
+	unsigned int now;
+	int window;
+	
+	now = millis();
+	window = sleepWindow(now, now + val1, val2);
+	if(window)
+	{
+		wakeAt = now + window;
+		powerDown(now);
+	}
+	return;
+}
+
+/**************************************************************************
+*	onTimeBeacon()
+*
+*	msgTable handler. Adjusts the local offset to the beacon, timed from
+*	when the frame was read.
+*
+*	PARAMETERS:
+*		Input:	unsigned char source address
+*				int network time
+*				int beacon interval
+*				int type of device calling the getMessage
+*		Output: none
+*
+**************************************************************************/
+void onTimeBeacon(unsigned char source, int val1, int val2, int devType)
+{
+	syncBeacon(lastRx, val1);
+	return;
+}
+
+/**************************************************************************
+*	onGetSyncStats()
+*
+*	msgTable handler. Answers with the clock error at the last beacon and
+*	the drift rate.
+*
+*	PARAMETERS:
+*		Input:	unsigned char source address
+*				int first data value (unused)
+*				int second data value (unused)
+*				int type of device calling the getMessage
+*		Output: none
+*
+**************************************************************************/
+void onGetSyncStats(unsigned char source, int val1, int val2, int devType)
+{
+	sendMessage(RETURN_SYNC_STATS, source, syncErr, driftPpm);
+	return;
+}
+
+/**************************************************************************
+*	onRelay()
+*
+*	msgTable handler. Thermostats forward the relayed message.
+*
+*	PARAMETERS:
+*		Input:	unsigned char source address
+*				int RELAY value 1
+*				int RELAY value 2
+*				int type of device calling the getMessage
+*		Output: none
+*
+**************************************************************************/
+void onRelay(unsigned char source, int val1, int val2, int devType)
+{
+	if(devType == typeTherm)
+	{
+		relayFrame(source, val1, val2);
+	}
+	return;
+}
+
+/**************************************************************************
+*	dispatchMessage()
+*
+*	For use by the Master Control. Routes a received frame that no
+*	request is waiting on by its msgTable entry. Pushed readings go to
+*	the telemetry handler; late replies and pairing frames outside of
+*	pairing are dropped.
+*
+*	PARAMETERS:
+*		Input:	unsigned char the type of message
+*				unsigned char source address
+*				int first data value
+*				int second data value
+*		Output: integer route the frame took (routeNone..routePairing)
+*
+**************************************************************************/
+int dispatchMessage(unsigned char msgType, unsigned char source, int val1, int val2)
+{
+	int route = msgTable[msgType].route;
+	
+	if((route == routeTelemetry) && (telemetryHandler != NULL))
+	{
+		telemetryHandler(msgType, source, val1, val2);
+	}
+	else if(route != routeNone)
+	{
+		printf("\nDropped %s from %#.2x", msgTable[msgType].name, source);
+	}
+	return route;
+}
+
+/**************************************************************************
+*	awaitReply()
+*
+*	Waits for one reply from a device. Every other frame received in the
+*	meantime is passed to dispatchMessage(), so readings pushed while
+*	waiting are not lost.
+*
+*	PARAMETERS:
+*		Input:	unsigned char pointer to the reply type wanted, (0) for
+*					any; set to the type received
+*				unsigned char address of the device
+*				int ms to wait
+*				int pointer to first data value
+*				int pointer to second data value
+*				int type of device calling the getMessage
+*		Output: integer (1) reply received (0) timed out
+*
+**************************************************************************/
+int awaitReply(unsigned char *msgType, unsigned char source, int ms, int *val1, int *val2, int devType)
+{
+	unsigned char type;
+	unsigned char from;
+	int data1;
+	int data2;
+	unsigned int start = millis();
+	
+	do
+	{
+		type = 0;
+		if(getMessage(&type, &from, &data1, &data2, devType))
+		{
+			answerMessage(devType);
+			if((from == source) && ((*msgType == 0) || (type == *msgType)))
+			{
+				*msgType = type;
+				*val1 = data1;
+				*val2 = data2;
+				return 1;
+			}
+			dispatchMessage(type, from, data1, data2);
+		}
+		else
+		{
+			delay(10);
+		}
+	}while((millis() - start) < ms);
+	
+	return 0;
+}
+
+/**************************************************************************
+*	awaitPairing()
+*
+*	For use by the Master Control after it sends SET_ADDR. Waits for the
+*	device to confirm or refuse the address.
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: integer (1) RECEIVED_ADDR (2) ADDR_NOT_SET (0) timed out
+*
+**************************************************************************/
+int awaitPairing(void)
+{
+	unsigned char msgCommand;
+	unsigned char source;
+	int data1;
+	int data2;
+	int j = 0;
+	
+	do
+	{
+		if(getSyncMessage(&msgCommand, &source, &data1, &data2))
+		{
+			printf("\nmsgCommand: %#.2x", msgCommand);
+			printf("\nsource: %#.2x", source);
+			printf("\ndata: %d %d", data1, data2);
+			if(msgCommand == RECEIVED_ADDR)
+			{
+				return 1;
+			}
+			else if(msgCommand == ADDR_NOT_SET)
+			{
+				return 2;
+			}
+			printf("\nWrong Packet");
+		}
+		j++;
+		delay(18);
+	}while(j < 250);
+	
+	return 0;
+}
+
+/**************************************************************************
+*	setTelemetryHandler()
+*
+*	Sets the function dispatchMessage() gives pushed readings to.
+*
+*	PARAMETERS:
+*		Input:	function pointer taking the type, source and values
+*		Output: none
+*
+**************************************************************************/
+void setTelemetryHandler(void (*handler)(unsigned char msgType, unsigned char source, int val1, int val2))
+{
+	telemetryHandler = handler;
+	return;
+}
+
+/**************************************************************************
+*	initButton()
+*
+*	For use by Thermostats and Registers. Installs syncButtonISR() on both
+*	edges of the SyncBtn GPIO, so getMessage() and pairOnButton() only
+*	have to look at the flags it sets, and starts blinking the SyncLED once if the device has
+*	no address yet.
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: none
+*
+**************************************************************************/
+void initButton(void)
+{
+	btnInit = 1;
+	if(wiringPiISR(SyncBtn, INT_EDGE_BOTH, &syncButtonISR) < 0)
+	{
+		printf("\nSync button interrupt failed");
+	}
+	if((myAddr == 0) && (LEDStatus != 0))
+	{
+		LEDStatus = 0;
+		piThreadCreate(SyncLEDPulse);
+	}
+	return;
+}
+
+/**************************************************************************
+*	syncButtonISR()
+*
+*	Runs on each edge of the SyncBtn GPIO. The button pulls the pin low,
+*	so a low level is a press and a high level a release. A release after
+*	syncHold sets pairRequested for pairOnButton().
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: none
+*
+**************************************************************************/
+void syncButtonISR(void)
+{
+	if(!digitalRead(SyncBtn))
+	{
+		pressedAt = millis();
+		btnDown = 1;
+	}
+	else
+	{
+		if(btnDown && ((millis() - pressedAt) >= syncHold))
+		{
+			// Released after a long hold, pairOnButton() takes it from here
+			pairRequested = 1;
+		}
+		btnDown = 0;
+	}
+	return;
+}
+
+/**************************************************************************
+*	getLatency()
+*
+*	Adds one getMessage() call to the latency histogram.
+*
+*	PARAMETERS:
+*		Input:	unsigned int micros() when the call started
+*		Output: none
+*
+**************************************************************************/
+void getLatency(unsigned int start)
+{
+	unsigned int usec;
+	int i = 0;
+	
+	usec = micros() - start;
+	while((i < getLatBuckets - 1) && (usec >= (1U << i)))
+	{
+		i++;
+	}
+	getLatHist[i]++;
+	if(usec > getLatMax)
+	{
+		getLatMax = usec;
+	}
+	return;
+}
+
+/**************************************************************************
+*	printGetLatency()
+*
+*	Prints the getMessage() latency histogram, one line per power of two
+*	microseconds, after the count of TX timeouts.
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: none
+*
+**************************************************************************/
+void printGetLatency(void)
+{
+	int i;
+	
+	printf("\nTX timeouts: %d", txTimeouts);
+	printf("\ngetMessage() latency, max %uus:", getLatMax);
+	for(i = 0; i < getLatBuckets; i++)
+	{
+		if(getLatHist[i] && (i == getLatBuckets - 1))
+		{
+			printf("\n  >=%7uus %u", 1U << (i - 1), getLatHist[i]);	// the last bucket takes every longer call
+		}
+		else if(getLatHist[i])
+		{
+			printf("\n  < %7uus %u", 1U << i, getLatHist[i]);
+		}
+	}
+	printf("\n");
+	return;
+}
+
+/**************************************************************************
+*	txWait()
+*
+*	Waits for the frame just pulsed out to finish (TX_DS or MAX_RT). The
+*	wait sleeps txPoll us between checks instead of spinning, and gives
+*	up after txTimeout us. A radio that never finishes is wedged or
+*	missing, so it is set up again with initRF() and the send fails.
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: unsigned char STATUS register contents, (0) timed out
+*
+**************************************************************************/
+unsigned char txWait(void)
+{
+	unsigned char data[11];
+	unsigned char stat;
+	unsigned int start = micros();
+	
+	do
+	{
+		stat = writeReadRF((unsigned char)(NOP), data, 1);
+		if(stat & 0x30)
+		{
+			return stat;
+		}
+		delayMicroseconds(txPoll);
+	}while((micros() - start) < txTimeout);
+	
+	txTimeouts++;
+	printf("\nTX did not complete (STATUS %#.2x), resetting the radio", stat);
+	digitalWrite(CE, LOW);
+	initRF();
+	return 0;
+}
+
+/**************************************************************************
+*	packTemps()
+*
+*	Packs the current and set temperatures into one value, 16 bits each,
+*	for RETURN_TELEMETRY.
+*
+*	PARAMETERS:
+*		Input:	int current temperature
+*				int set temperature
+*		Output: integer [ current (16 bits) | set (16 bits) ]
+*
+**************************************************************************/
+int packTemps(int curr, int set)
+{
+	return ((curr & 0xFFFF) << 16)|(set & 0xFFFF);
+}
+
+/**************************************************************************
+*	unpackTemps()
+*
+*	Reverses packTemps(), keeping the sign of each temperature.
+*
+*	PARAMETERS:
+*		Input:	int packed value
+*				int pointer to the current temperature
+*				int pointer to the set temperature
+*		Output: none
+*
+**************************************************************************/
+void unpackTemps(int val, int *curr, int *set)
+{
+	*curr = (short)((val >> 16) & 0xFFFF);
+	*set = (short)(val & 0xFFFF);
+	return;
+}
+
+/**************************************************************************
+*	setTelemetry()
+*
+*	To be called by the thermostat after each sample, before
+*	reportTemps(). Keeps the readings GET_TELEMETRY is answered with.
+*
+*	PARAMETERS:
+*		Input:	int current temperature
+*				int set temperature
+*				int humidity in %
+*		Output: none
+*
+**************************************************************************/
+void setTelemetry(int curr, int set, int hum)
+{
+	telCurr = curr;
+	telSet = set;
+	telHum = hum;
+	telValid = 1;
+	return;
+}
+
+/**************************************************************************
+*	onGetTelemetry()
+*
+*	msgTable handler for thermostats. Answers with the temperatures and
+*	humidity of the last sample in one RETURN_TELEMETRY.
+*
+*	PARAMETERS:
+*		Input:	unsigned char source address
+*				int first data value (unused)
+*				int second data value (unused)
+*				int type of device calling the getMessage
+*		Output: none
+*
+**************************************************************************/
+void onGetTelemetry(unsigned char source, int val1, int val2, int devType)
+{
+	if((devType == typeTherm) && telValid)
+	{
+		sendMessage(RETURN_TELEMETRY, source, packTemps(telCurr, telSet), telHum);
+	}
+	return;
+}
+
+/**************************************************************************
+*	batchSample()
+*
+*	To be called by the thermostat every batchPeriod ms. Buffers the
+*	sample until the MC collects it with GET_BATCH; when the buffer is
+*	full the oldest sample is dropped.
+*
+*	PARAMETERS:
+*		Input:	int current temperature in 0.1F
+*		Output: none
+*
+**************************************************************************/
+void batchSample(int tenths)
+{
+	if(batchCount == batchMax)
+	{
+		memmove(batchBuf, batchBuf + 1, (batchMax - 1) * sizeof(int));
+		memmove(batchAt, batchAt + 1, (batchMax - 1) * sizeof(unsigned int));
+		batchCount--;
+	}
+	batchBuf[batchCount] = tenths;
+	batchAt[batchCount] = millis();
+	batchCount++;
+	return;
+}
+
+/**************************************************************************
+*	packBatch()
+*
+*	Delta encodes samples, oldest first, into the values of one
+*	RETURN_BATCH (layout in messaging.h). Packing stops after batchFrame
+*	samples or at the first change too large for 4 bits, which then
+*	starts the next frame.
+*
+*	PARAMETERS:
+*		Input:	int pointer to the samples in 0.1F
+*				unsigned int pointer to the millis() each was taken
+*				int number of samples
+*				unsigned int millis() now
+*				int pointer to value 2
+*				int pointer to the number of samples packed
+*		Output: integer value 1
+*
+**************************************************************************/
+int packBatch(int *samples, unsigned int *at, int count, unsigned int now, int *val2, int *packed)
+{
+	int n;
+	int delta;
+	unsigned int age;
+	unsigned int deltas = 0;	// packed unsigned, the top nibble would overflow an int
+	
+	*val2 = 0;
+	*packed = 0;
+	if(count <= 0)
+	{
+		return 0;
+	}
+	for(n = 1; (n < count) && (n < batchFrame); n++)
+	{
+		delta = samples[n] - samples[n - 1];
+		if((delta < -8) || (delta > 7))
+		{
+			break;
+		}
+		deltas |= (unsigned int)(delta & 0x0F) << (4 * (8 - n));
+	}
+	*val2 = (int)deltas;
+	*packed = n;
+	age = (now - at[n - 1]) / 1000;
+	if(age > 255)
+	{
+		age = 255;
+	}
+	return (int)(((unsigned int)(samples[0] & 0xFFFF) << 16)|(age << 8)|((unsigned int)n << 4)|(unsigned int)(n < count));
+}
+
+/**************************************************************************
+*	unpackBatch()
+*
+*	Reverses packBatch().
+*
+*	PARAMETERS:
+*		Input:	int value 1
+*				int value 2
+*				int pointer to batchFrame samples in 0.1F, oldest first
+*				int pointer to the age of the last sample in s
+*				int pointer set to (1) if the device has more samples
+*		Output: integer number of samples
+*
+**************************************************************************/
+int unpackBatch(int val1, int val2, int *samples, int *age, int *more)
+{
+	int count = ((unsigned int)val1 >> 4) & 0x0F;
+	int n;
+	int delta;
+	
+	*age = ((unsigned int)val1 >> 8) & 0xFF;
+	*more = val1 & 0x0F;
+	if(count > batchFrame)
+	{
+		return 0;
+	}
+	if(count)
+	{
+		samples[0] = (short)(((unsigned int)val1 >> 16) & 0xFFFF);
+	}
+	for(n = 1; n < count; n++)
+	{
+		delta = ((unsigned int)val2 >> (4 * (8 - n))) & 0x0F;
+		samples[n] = samples[n - 1] + ((delta & 0x08) ? (delta - 16) : delta);
+	}
+	return count;
+}
+
+/**************************************************************************
+*	onGetBatch()
+*
+*	msgTable handler for thermostats. Answers with the oldest buffered
+*	samples in one RETURN_BATCH and drops them once it is ACKed.
+*
+*	PARAMETERS:
+*		Input:	unsigned char source address
+*				int first data value (unused)
+*				int second data value (unused)
+*				int type of device calling the getMessage
+*		Output: none
+*
+**************************************************************************/
+void onGetBatch(unsigned char source, int val1, int val2, int devType)
+{
+	int batchVal1;
+	int batchVal2;
+	int packed;
+	
+	if(devType != typeTherm)
+	{
+		return;
+	}
+	batchVal1 = packBatch(batchBuf, batchAt, batchCount, millis(), &batchVal2, &packed);
+	if(sendMessage(RETURN_BATCH, source, batchVal1, batchVal2) && packed)
+	{
+		batchCount -= packed;
+		memmove(batchBuf, batchBuf + packed, batchCount * sizeof(int));
+		memmove(batchAt, batchAt + packed, batchCount * sizeof(unsigned int));
+	}
+	return;
+}
+
+/**************************************************************************
+*	SyncLEDPulse
+*
+*	Used by the initialization functions. A separate thread blinks the
+*	SyncLED until LEDStatus changes. The LED is left ON for successful
+*	initialization and OFF for failed initialization.
+*
+*	PARAMETERS:
+*		Input:	none
+*		Output: none
+*
+**************************************************************************/
+
+PI_THREAD(SyncLEDPulse)
+{
+	do
+	{
+        
+        digitalWrite(SyncLED, HIGH);
+        delay( 500);
+
+        
+        digitalWrite(SyncLED, LOW);
+        delay( 500);
+		
+		if(LEDStatus==1)
+		{
+			digitalWrite(SyncLED, LOW);
+			//printf("Sync LED ON");
+			break;
+		}
+		else if(LEDStatus==2)
+		{
+			digitalWrite(SyncLED, HIGH);
+			//printf("Sync LED OFF");
+			break;
+		}
+    }while(LEDStatus == 0);
+	return 0;
 }
\ No newline at end of file
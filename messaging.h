@@ -1,128 +1,325 @@
-/**************************************************************************
-*	messaging.h
-*		by Eric Ceballos, LeValle Bradix, and Robert Young
-*
-*	OBJECTIVE:
-*	This file will be used to define the nRF24L01 functions and registers
-*	for use by the C file messaging.c.
-*
-*	DEFINITIONS:
-*	This section defines the nRF24L01's register maps and SPI command
-*	structure.
-*
-**************************************************************************/
-
-// nRF24L01 Register Map
-#define CONFIG			0x00
-#define EN_AA			0x01
-#define EN_RXADDR		0x02
-#define SETUP_AW		0x03
-#define SETUP_RETR		0x04
-#define RF_CH			0x05
-#define RF_SETUP		0x06
-#define STATUS			0x07
-#define OBSERVE_TX		0x08
-#define CD				0x09
-#define RX_ADDR_P0		0x0A
-#define RX_ADDR_P1		0x0B
-#define RX_ADDR_P2		0x0C
-#define RX_ADDR_P3		0x0D
-#define RX_ADDR_P4		0x0E
-#define RX_ADDR_p5		0x0F
-#define TX_ADDR			0x10
-#define RX_PW_P0		0x11
-#define RX_PW_P1		0x12
-#define RX_PW_P2		0x13
-#define RX_PW_P3		0x14
-#define RX_PW_P4		0x15
-#define RX_PW_P5		0x16
-#define FIFO_STATUS		0x17
-#define DYNPD			0x1C
-#define FEATURE			0x1D
-
-// nRF24L01 SPI Commands
-#define R_REGISTER		0x00 // Mask w/ Register you wish to read
-#define W_REGISTER		0x20 // Mask w/ Register you wish to write to
-#define R_RX_PAYLOAD	0x61
-#define W_TX_PAYLOAD	0xA0
-#define FLUSH_TX		0xE1
-#define FLUSH_RX		0xE2
-#define REUSE_TX_PL		0xE3
-#define NOP				0xFF
-
-// Messaging Reserved Addresses
-#define BROADCAST		0x00
-#define SYNC			0xFF
-
-// Messaging Command Constants
-#define SEND_BYTE		0x01
-#define RETURN_BYTE		0x02
-#define ACK				0x03
-#define SET_TEMP		0x10
-#define GET_TEMPS		0x11
-#define RETURN_TEMPS	0x12
-#define GET_HUM			0x13
-#define RETURN_HUM		0x14
-#define GET_FLOW		0x15
-#define RETURN_FLOW		0x16
-#define SET_FLOW		0x17
-#define CREATE_ADDR		0x29
-#define SET_ADDR		0x2A
-#define REJECT_ADDR		0x2B
-#define RECEIVED_ADDR	0x2C
-#define ADDR_NOT_SET	0x2D
-
-// GPIO to be used
-#define CE				12
-#define CSN				8
-#define MOSI			10
-#define MISO			9
-#define SCK				11
-#define SyncBtn			17
-#define SyncLED			23
-
-// Constants used in functions
-#define Chan 			0
-#define Speed			8000000
-#define thermoID		0x80
-#define regID			0x00
-#define typeMC			0
-#define typeTherm		1
-#define typeReg			2
-
-
-/**************************************************************************
-*
-*	FUNCTION DEFINITIONS:
-*	This section lays out prototypes for the functions to be used by the 
-*	C file messaging.c
-*
-*	FUNCTIONS:
-*		initRF()		- initializes the nRF24L01 module
-*		writeReadRF()	- writes to or reads from the nRF24L01 registers
-*		rxMode()		- sets the nRF24L01 into receiver mode
-*		txMode()		- sets the nRf24L01 into transmitter mode
-*		initMC()		- initialization routine for Master Controller
-*		initThermo()	- initialization routine for Thermostats
-*		initReg()		- initialization routine for Registers
-*		getMessage()	- receives message from another device
-*		getSyncMessage()- used to receive messages during syncing
-*		sendMessage()	- sends a message to another device
-*		SyncLEDPulse	- defined thread for blinking LED
-*		ButtonHold()	- Function used in ProtocolA.c to control buttons
-*
-**************************************************************************/
-
-int initRF(void);
-unsigned char writeReadRF(unsigned char command, unsigned char *data, int length);
-void rxMode(void);
-void txMode(void);
-int initMC(int *devNumber, unsigned char *devArray);
-int initThermo(unsigned char *MCAddr);
-int initReg(unsigned char *MCAddr);
-int addDevice(unsigned char *devAddr, int type);
-int getMessage(unsigned char *msgType, unsigned char *msgSourceAddr, int *msgVal1, int *msgVal2, int devType);
-int getSyncMessage(unsigned char *syncType, unsigned char *syncSource, int *syncVal1, int *syncVal2);
-int sendMessage(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2);
-PI_THREAD(SyncLEDPulse);
+/**************************************************************************
+*	messaging.h
+*		by Eric Ceballos, LeValle Bradix, and Robert Young
+*
+*	OBJECTIVE:
+*	This file will be used to define the nRF24L01 functions and registers
+*	for use by the C file messaging.c.
+*
+*	DEFINITIONS:
+*	This section defines the nRF24L01's register maps and SPI command
+*	structure.
+*
+**************************************************************************/
+
+// nRF24L01 Register Map
+#define CONFIG			0x00
+#define EN_AA			0x01
+#define EN_RXADDR		0x02
+#define SETUP_AW		0x03
+#define SETUP_RETR		0x04
+#define RF_CH			0x05
+#define RF_SETUP		0x06
+#define STATUS			0x07
+#define OBSERVE_TX		0x08
+#define CD				0x09
+#define RX_ADDR_P0		0x0A
+#define RX_ADDR_P1		0x0B
+#define RX_ADDR_P2		0x0C
+#define RX_ADDR_P3		0x0D
+#define RX_ADDR_P4		0x0E
+#define RX_ADDR_p5		0x0F
+#define TX_ADDR			0x10
+#define RX_PW_P0		0x11
+#define RX_PW_P1		0x12
+#define RX_PW_P2		0x13
+#define RX_PW_P3		0x14
+#define RX_PW_P4		0x15
+#define RX_PW_P5		0x16
+#define FIFO_STATUS		0x17
+#define DYNPD			0x1C
+#define FEATURE			0x1D
+
+// nRF24L01 SPI Commands
+#define R_REGISTER		0x00 // Mask w/ Register you wish to read
+#define W_REGISTER		0x20 // Mask w/ Register you wish to write to
+#define R_RX_PAYLOAD	0x61
+#define W_TX_PAYLOAD	0xA0
+#define FLUSH_TX		0xE1
+#define FLUSH_RX		0xE2
+#define REUSE_TX_PL		0xE3
+#define NOP				0xFF
+
+// Messaging Reserved Addresses
+#define BROADCAST		0x00
+#define SYNC			0xFF
+
+// Messaging Command Constants
+#define SEND_BYTE		0x01
+#define RETURN_BYTE		0x02
+#define ACK				0x03
+#define SET_TEMP		0x10
+#define GET_TEMPS		0x11
+#define RETURN_TEMPS	0x12
+#define GET_HUM			0x13
+#define RETURN_HUM		0x14
+#define GET_FLOW		0x15
+#define RETURN_FLOW		0x16
+#define SET_FLOW		0x17
+#define SET_GROUP		0x18
+#define GROUP_FLOW		0x19
+#define SUBSCRIBE		0x1A
+#define SLEEP_UNTIL		0x1B
+#define TIME_BEACON		0x1C
+#define GET_SYNC_STATS	0x1D
+#define RETURN_SYNC_STATS	0x1E
+#define RELAY			0x1F
+#define RELAY_RESULT	0x20
+#define GET_TELEMETRY	0x21
+#define RETURN_TELEMETRY	0x22
+#define GET_BATCH		0x23
+#define RETURN_BATCH	0x24
+#define CREATE_ADDR		0x29
+#define SET_ADDR		0x2A
+#define REJECT_ADDR		0x2B
+#define RECEIVED_ADDR	0x2C
+#define ADDR_NOT_SET	0x2D
+
+// GPIO to be used
+#define CE				12
+#define CSN				8
+#define MOSI			10
+#define MISO			9
+#define SCK				11
+#define SyncBtn			17
+#define SyncLED			23
+#define RFIRQ			-1		// nRF24L01 IRQ, (-1) not wired, see radioNap() on the MC
+
+// Constants used in functions
+#define Chan 			0
+#define Speed			8000000
+#define thermoID		0x80
+#define regID			0x00
+#define typeMC			0
+#define typeTherm		1
+#define typeReg			2
+#define groupAckReq		0x100	// GROUP_FLOW value 1 flag requesting member ACKs
+#define groupSlot		40		// ms between member ACKs of a GROUP_FLOW
+
+// Outgoing message queue classes, most urgent first
+#define prioAct			0		// register actuation
+#define prioUser		1		// user/menu actions
+#define prioPoll		2		// routine polling
+#define queueSize		256		// max frames waiting in the queue
+#define queueLock		0		// piLock() key guarding the queue
+
+// msgQueue[][] column reference constants
+#define qPrio			0
+#define qType			1
+#define qAddr			2
+#define qVal1			3
+#define qVal2			4
+#define qTime			5		// micros() when the frame was queued
+#define qSeq			6		// order the frame was queued in
+
+// Duty cycling, all times in ms
+#define wakeGuard		200		// nodes wake this long before the next poll
+#define minSleep		50		// shorter windows are not worth powering down
+#define maxSleep		60000	// longest sleep, so a node that misses the MC wakes
+#define wakeLate		5		// wakes later than this are counted as late
+
+// Network time
+#define beaconDefault	30000	// ms between TIME_BEACON broadcasts
+
+// Protocol version and capabilities exchanged during pairing
+#define protoVersion	1
+#define capGroup		0x0001	// SET_GROUP and GROUP_FLOW
+#define capSubscribe	0x0002	// SUBSCRIBE and pushed RETURN_TEMPS
+#define capSleep		0x0004	// SLEEP_UNTIL
+#define capBeacon		0x0008	// TIME_BEACON and GET_SYNC_STATS
+#define capRelay		0x0010	// forwards RELAY frames
+#define capTelemetry	0x0020	// GET_TELEMETRY and RETURN_TELEMETRY
+#define capBatch		0x0040	// GET_BATCH and RETURN_BATCH
+#define capDynPayload	0x0080	// reserved: nRF24L01 dynamic payload length
+#define capHwAck		0x0100	// reserved: nRF24L01 auto acknowledgement
+#define protoCaps		(capGroup|capSubscribe|capSleep|capBeacon|capRelay|capTelemetry|capBatch)
+
+// One entry per message type
+struct msgInfo
+{
+	char *name;
+	unsigned char flags;	// msgNoAck, msgRawVal1, msgQuiet
+	unsigned char route;	// routeNone..routePairing
+	void (*handler)(unsigned char source, int val1, int val2, int devType);	// run by answerMessage() once ACKed
+};
+extern const struct msgInfo msgTable[256];
+
+// msgTable[] flags
+#define msgNoAck		0x01	// the sender does not wait for an ACK
+#define msgRawVal1		0x02	// a value 1 of 0 is sent as is, not replaced by rand()
+#define msgQuiet		0x04	// receivers never ACK, every node would answer at once
+
+// msgTable[] routes for frames the MC is not waiting on
+#define routeNone		0
+#define routeReply		1		// answer to a request, taken by awaitReply()
+#define routeTelemetry	2		// readings pushed by a device, given to the telemetry handler
+#define routePairing	3		// pairing frames, taken by awaitPairing()
+#define replyWait		150		// ms to wait for a device's reply
+
+#define syncHold		3000	// ms the sync button is held to pair
+#define getLatBuckets	20		// getMessage() latency histogram, powers of two us
+#define txTimeout		50000	// us a frame may take to send before the radio is reset
+#define txPoll			100		// us slept between TX status checks
+
+// Relaying through thermostats
+#define relayHyst		20		// % more direct loss than relayed loss before relaying
+#define relayProbe		16		// every this many relayed sends, try direct again
+#define relayWait		1500	// ms the MC waits for a RELAY_RESULT
+
+// Buffered temperature samples (thermostats), sent as RETURN_BATCH:
+//	value 1: [ first sample, 0.1F (16 bits) | age of last sample, s (8 bits) | count (4 bits) | more (4 bits) ]
+//	value 2: up to 8 deltas from the sample before, 0.1F, 4 bits signed each, first delta highest
+#define batchPeriod		15000	// ms between the samples a thermostat buffers
+#define batchMax		32		// samples a thermostat buffers
+#define batchFrame		9		// most samples in one RETURN_BATCH
+
+
+/**************************************************************************
+*
+*	FUNCTION DEFINITIONS:
+*	This section lays out prototypes for the functions to be used by the 
+*	C file messaging.c
+*
+*	FUNCTIONS:
+*		initRF()		- initializes the nRF24L01 module
+*		writeReadRF()	- writes to or reads from the nRF24L01 registers
+*		rxMode()		- sets the nRF24L01 into receiver mode
+*		txMode()		- sets the nRf24L01 into transmitter mode
+*		initMC()		- initialization routine for Master Controller
+*		initThermo()	- initialization routine for Thermostats
+*		initReg()		- initialization routine for Registers
+*		getMessage()	- receives message from another device
+*		answerMessage()	- ACKs and handles the frame getMessage() read
+*		pairOnButton()	- pairs once the sync button asks for it
+*		getSyncMessage()- used to receive messages during syncing
+*		sendMessage()	- sends a message to another device
+*		sendGroupFlow()	- sends one flow value to a room's group address
+*		reportTemps()	- pushes temperatures to a subscribed MC
+*		queueMessage()	- queues a message by priority class
+*		sendQueue()		- sends queued messages of a class or higher
+*		setQueueHandler()- sets the function told of each queued send result
+*		setQueueYield()	- sets the function called between queued frames
+*		printQueueStats()- prints queue latency per class
+*		traceOpen()		- maps the binary frame trace file
+*		traceFrame()	- records one frame in the trace
+*		powerDown()		- powers the nRF24L01 down
+*		wakeRadio()		- powers the nRF24L01 back up into RX mode
+*		sleepWindow()	- works out how long the radio may sleep
+*		wakeDue()		- tells if a wake time has been reached
+*		dutyAccount()	- adds up the time the radio spent awake and asleep
+*		sleepNetwork()	- tells the nodes to sleep, then sleeps the MC radio
+*		printDutyStats()- prints radio awake time and late wakes
+*		sendBeacon()	- broadcasts the network time when it is due
+*		syncBeacon()	- adjusts the local offset to a received beacon
+*		netTime()		- returns the network time in ms
+*		msToPhase()		- ms until the network time reaches a phase
+*		setParent()		- sets the thermostat that relays to a register
+*		sendRouted()	- sends directly or through a relay, by link loss
+*		sendRelay()		- sends a message through a thermostat
+*		relayFrame()	- forwards a relayed message (thermostats only)
+*		identVal()		- builds the pairing value with version and caps
+*		storeIdent()	- stores a device's protocol version and caps
+*		linkCaps()		- capabilities shared with a device
+*		onSetGroup()	- takes a SET_GROUP (registers)
+*		onSubscribe()	- takes a SUBSCRIBE (thermostats)
+*		onSleepUntil()	- takes a SLEEP_UNTIL
+*		onTimeBeacon()	- takes a TIME_BEACON
+*		onGetSyncStats()- answers a GET_SYNC_STATS
+*		onRelay()		- takes a RELAY (thermostats)
+*		dispatchMessage()- routes a frame no one is waiting on
+*		awaitReply()	- waits for one reply, dispatching other frames
+*		awaitPairing()	- waits for a device to confirm its address
+*		setTelemetryHandler()- sets the function given pushed readings
+*		initButton()	- installs the sync button edge interrupt
+*		syncButtonISR()	- tracks sync button presses
+*		getLatency()	- adds a getMessage() call to its histogram
+*		printGetLatency()- prints the getMessage() latency histogram
+*		txWait()		- bounded wait for a frame to finish sending
+*		packTemps()		- packs two temperatures into one value
+*		unpackTemps()	- unpacks two temperatures from one value
+*		setTelemetry()	- keeps the thermostat's last sample
+*		onGetTelemetry()- answers a GET_TELEMETRY (thermostats)
+*		batchSample()	- buffers one temperature sample (thermostats)
+*		packBatch()		- delta encodes buffered samples into one frame
+*		unpackBatch()	- decodes the samples of a RETURN_BATCH
+*		onGetBatch()	- answers a GET_BATCH (thermostats)
+*		SyncLEDPulse	- defined thread for blinking LED
+*		ButtonHold()	- Function used in ProtocolA.c to control buttons
+*
+**************************************************************************/
+
+int initRF(void);
+unsigned char writeReadRF(unsigned char command, unsigned char *data, int length);
+void rxMode(void);
+void txMode(void);
+int initMC(int *devNumber, unsigned char *devArray);
+int initThermo(unsigned char *MCAddr);
+int initReg(unsigned char *MCAddr);
+int addDevice(unsigned char *devAddr, int type);
+int getMessage(unsigned char *msgType, unsigned char *msgSourceAddr, int *msgVal1, int *msgVal2, int devType);
+int answerMessage(int devType);
+int pairOnButton(int devType);
+int getSyncMessage(unsigned char *syncType, unsigned char *syncSource, int *syncVal1, int *syncVal2);
+int sendMessage(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2);
+int sendGroupFlow(unsigned char groupAddr, int flow, unsigned char *members, int count, int ackReq, int *acked);
+int reportTemps(int curr, int set);
+int queueMessage(int prio, unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2);
+int sendQueue(int prio);
+void setQueueHandler(void (*handler)(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2, int success));
+void setQueueYield(int (*yield)(void));
+void printQueueStats(void);
+int traceOpen(char *path);
+void traceFrame(int dir, unsigned char *frame, unsigned char stat, int retry);
+void powerDown(unsigned int now);
+void wakeRadio(unsigned int now);
+int sleepWindow(unsigned int now, unsigned int nextPoll, int guard);
+int wakeDue(unsigned int now, unsigned int wake);
+void dutyAccount(unsigned int now, int awake);
+unsigned int sleepNetwork(int untilPoll);
+void printDutyStats(void);
+int sendBeacon(int interval);
+void syncBeacon(unsigned int now, unsigned int mcTime);
+unsigned int netTime(void);
+int msToPhase(unsigned int t, int period, int phase);
+void setParent(unsigned char child, unsigned char parent);
+int sendRouted(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2);
+int sendRelay(unsigned char parent, unsigned char child, unsigned char msgType, int msgVal1, int msgVal2, int *rType, int *rVal1, int *rVal2);
+int relayFrame(unsigned char source, int relayVal1, int relayVal2);
+int identVal(unsigned char low);
+void storeIdent(unsigned char addr, int val);
+int linkCaps(unsigned char addr);
+void onSetGroup(unsigned char source, int val1, int val2, int devType);
+void onSubscribe(unsigned char source, int val1, int val2, int devType);
+void onSleepUntil(unsigned char source, int val1, int val2, int devType);
+void onTimeBeacon(unsigned char source, int val1, int val2, int devType);
+void onGetSyncStats(unsigned char source, int val1, int val2, int devType);
+void onRelay(unsigned char source, int val1, int val2, int devType);
+int dispatchMessage(unsigned char msgType, unsigned char source, int val1, int val2);
+int awaitReply(unsigned char *msgType, unsigned char source, int ms, int *val1, int *val2, int devType);
+int awaitPairing(void);
+void setTelemetryHandler(void (*handler)(unsigned char msgType, unsigned char source, int val1, int val2));
+void initButton(void);
+void syncButtonISR(void);
+void getLatency(unsigned int start);
+void printGetLatency(void);
+unsigned char txWait(void);
+int packTemps(int curr, int set);
+void unpackTemps(int val, int *curr, int *set);
+void setTelemetry(int curr, int set, int hum);
+void onGetTelemetry(unsigned char source, int val1, int val2, int devType);
+void batchSample(int tenths);
+int packBatch(int *samples, unsigned int *at, int count, unsigned int now, int *val2, int *packed);
+int unpackBatch(int val1, int val2, int *samples, int *age, int *more);
+void onGetBatch(unsigned char source, int val1, int val2, int devType);
+PI_THREAD(SyncLEDPulse);
 int ButtonHold(void);
\ No newline at end of file
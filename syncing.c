@@ -1,1336 +1,2534 @@
-/*****************************************************************************************
-syncing.c
-	by group 2: Raul Rojas, Christa McDaniel, Alex Fotso
-	
-	Objective: 
-	This file contains all functions needed to perfom the background computations and 
-	logic required to control the system. It is comprised of many functions which 
-	range in functionality from initializations, communications, data management, and 
-	computation.
-	
-	Functions:
-		initArray()
-		populateArrays()
-		addTherm()
-		addReg()
-		dispMatrix()
-		rmDevAddr()
-		initTempsArr()
-		initFailedCon()
-		retrieveTemps()
-		initRegFlow()
-		setReg()
-		countErrors()
-		initRocArray()
-		calcDiff()
-		hvacControl()
-		adjustReg()
-		updateStatus()
-		
-*****************************************************************************************/
-#include <wiringPi.h>
-#include <lcd.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <mcp23017.h>
-#include "finalHeader.h"
-#include "messaging.h"
-
-#define ROW_COUNT  126
-#define COLUMN_COUNT  11
-
-int changeWarnCount; //count to determine if user should change hvac setting.
-					//used in auto setting to determine if system should change hvacSetting
-unsigned char devices[rows][columns];//This Array contains the organized addresses of all devices. 
-extern int lcdhdl;//This variable contains the lcd handle returned from lcd initialization. 
-extern int page;//this variable contains the current page that is being displayed on the LCD.
-extern int line;//this variable contains the current cursor position for menu navigation in the lcd.
-extern int set;//this variable contains the current item being edited by the user in set time.
-unsigned char addresses[126];//This array contains the addresses returned from initMC();
-extern int rtTimes[126][2];//This array contains the start times of the timers used. 
-int conStatus = 0;
-int failedCon[126][126];	//number of times failed to connect with devices
-							//[0][0] == connections errors
-							//[0][1] == incorrect hvac setting warning
-int temps[126][5];	//[Current temp | Set temp | Current Humidity | temp difference | startDiff]
-					//temps[0][3]: 1 if hvac needs to turn on. 0 if temps are at desired.
-					//use temps[0][hvacOut] "hvacOut" is the defined constant for this.
-
-int regFlow[126][126][2];//first two dimensions orginize the data the same way the 
-						//registers address is stored. in the third dimension
-						//the 0 index will store the sending airflow, while the 
-						//1 index will store the receiving current airflow (in pressure).
-
-
-float rateOfChange[ROW_COUNT][COLUMN_COUNT];//this array contains the rates of change for each therm.
-
-int hvacSetting = 0;	//user setting.
-						//not set: 0 (auto)
-						//cooling: 1
-						//heating: 2
-						//Fan only:3
-int hvacAuto; //variable for hvacSetting = auto (3). 0 for cooling, 1 for heating.
-int hvacStatus; //current hvac status. 0 for off, 1 for on.
-
-//unsigned char thermoID = 0x80;
-
-/****************************************************************************************
-void initArray(void)
-	This function initializes the 1 dimensional and 2 dimensional arrays which are used 
-	to store device addresses. The purpose of the 1 dimensional array is to provide a 
-	data structure for the protocol function to store the acquired addresses. Moreover, 
-	the 2 dimensional array is used to organize the 1 dimensional array addresses into 
-	a format that is easier to access and work with. The method in which the arrays will 
-	be organized can be seen below in the comment header for function populateArrays().
-****************************************************************************************/
-void initArray(void)
-{
-	int i;
-	int j;
-	//int p;
-	
-	//using max number of devices as conditions.
-	int r = rows;
-	int c = columns;
-	
-	for(i = 0; i < r; i++)//row loop.
-	{
-		for(j = 0; j < c; j++)//column loop.
-		{
-			devices[i][j] = 0x00;
-			//p = devices[i][j];
-			//printf("Row: %d, Column: %d, Content: %d\n", i, j, p);	//for testing.
-		}
-	}
-	
-	//filling in 1 dim. array with zero's
-	for(i = 0; i<126; i++)
-	{
-		addresses[i] = 0x00;
-	}
-	/* //===THE FOLLOWING ASSIGNMENTS ARE USED FOR TESTING PURPOSES ===
-	//test addresses
-	addresses[0]=0x81;
-	addresses[1]=0x7E;
-	
-	addresses[2]=0x7D;
-	
-	addresses[3]=0x82;
-	addresses[4]=0x7C;
-	addresses[5]=0x7B;
-	*/ //===END OF TEST ASSIGNMENTS ===
-	
-	//for debugging, printing the values in in the 1 dim. array. 
-	for(i = 0; i<10; i++)
-	{
-		printf("addresses[%d]: %#.2x\n\n", i, addresses[i]);
-	}
-	return;
-}
-
-
-/****************************************************************************************
-void poulateArrays(void)
-	Description: 
-	This funcion organizes the addresses stored in the 1 dimensional array
-	addresses[], which has been populated by the initMC() protocol function, into a 
-	2 dimensional array called devices[][]. This 2 dimensional array is orginized in a 
-	specific manner to allow for easy access and array address information to be acquired
-	by the MC. The method for organization is as follows:
-	
-	index [0][0] contains the total number of thermostats contained within the array. 
-	this number changes whenever the user adds or removes thermostats from the MC. 
-	every subsequent column within row 0 contains the number of registers per thermostat 
-	where the column number represents the thermostat number (or room #). 
-
-	Beginning from index [1][0], every row index within column 0 contains a thermostat 
-	address. For example, index [1][0] = thermostat 1, index [2][0] = thermostat 2, 
-	etc. We will indirectly label each thermostat its own room number for later reference
-	(thermostat 1 is room 1, thermostat 2 is room 2, etc).
-	
-	Finally every column index within a row, beginning with [1][1], will contain a 
-	register address which is associated with that rows thermostat.
-	
-	Below, an example is shown on how the 1 and 2 dimensional arrays are organized. 
-	
-	1 dim: [Therm A | Reg A1 | Reg A2 | Reg An | Therm B | Reg B1 | Reg Bn | Therm X]
-			.. and so on. where n is any number of registers or thermostats below 128 
-			
-	2 dim: 	[Therm t | #RegA | #RegB | #RegN] 
-			[Therm A | RegA1 | RegA2 | RegAN]			
-			[Therm B | RegB1 | RegB2 | RegBN]			
-			[Therm X | RegXN | RegXN | RegXN]	
-****************************************************************************************/
-void populateArrays(void)
-{
-	int i;
-	int tempCount=0;	//Start the temp count at 0
-	int registerCount=0;		//Start the registerCount at 1
-	
-	
-	for(i=0; i<126; i++)
-	{
-		
-		if(!(addresses[i]&thermoID) && addresses[i] != 0)	//If the address is less than 0x80 it's a register 1000 0000
-		{
-			registerCount++;                                //Incriment Register Count
-			//printf("registerCount = %d\n", registerCount);
-			devices[tempCount][registerCount]=addresses[i];	//Add the device to the temp row on the Second Column
-			devices[0][tempCount]=registerCount;			//Place the registerCount in the first row but equivanent column index of the Temp Row
-		}
-		else if((addresses[i]&thermoID) && addresses[i] != 0)					//If the address is greater than 0x80 it's a Tempurature Sensor
-		{
-			registerCount=0;								//Set RegisterCount back to zero
-			tempCount++;									//increment tempCount
-			//printf("tempCount: %d\n", tempCount);
-			devices[tempCount][registerCount]=addresses[i];	//Place temp address into Column 0 and corresponding row
-
-			devices[0][0]=tempCount;						//Place total Tempurature count in index [0][0]
-		}
-	}
-	
-	//display the matrix to console.
-	dispMatrix();
-	return;
-}
-
-/****************************************************************************************
-int addTherm(void)
-	Description: This function adds a thermostat address to the two dimensional array
-	devices[][]. The function first calls the protocol function addDevice() to acquire
-	connection with the new device and generate an address, then stores that address
-	into a variable. It then incriments the thermostat count in index [0][0] and moves
-	the address into the index slot after the the last thermostat address in column 0.
-	This function returns a (1) if connection was established and an address was created
-	successfully by the protocol function: addDevice(). If the process is unsuccessful, 
-	the function returns a 0. 
-****************************************************************************************/
-int addTherm(void)
-{
-	unsigned char devAddr;	//declarin variable where the address will be store. 
-	if(addDevice(&devAddr, 1))	//calling protocol function to add a new device.
-	{
-		//add device successfull.
-		int r = devices[0][0];	//increment the thermostat count in the 2d array.
-		r++;
-		devices[0][0] = r;
-		devices[r][0] = devAddr;	//store the new address in the next availble location
-		dispMatrix();	//display the 2d array with new address.
-		return 1;
-	}
-	else
-	{
-		//add device unsuccessful.
-		printf("\nadd Thermo function unsuccessful.\n");
-		return 0;
-	}
-}
-
-
-
-/****************************************************************************************
-void addReg(unsigned char addToRoom)
-	Description: This function adds a new register address to the two dimensional array 
-	devices[][]. This function stores the address in its corresponding thermostat row 
-	which is predifined by the user through menu selection.
-****************************************************************************************/
-int addReg(int addToRoom)
-{
-	unsigned char devAddr;	//declaring the variable that will store new address.
-	if(addDevice(&devAddr, 2))	//call the protocol function to add new device.
-	{
-		//add device successfull
-		//the next three lines increments the register count to the desired room.
-		int c = devices[0][addToRoom];
-		c++;
-		devices[0][addToRoom] = c;
-		
-		devices[addToRoom][c] = devAddr;	//stores the new address in an availble slot.
-		dispMatrix();	//display the 2d array with the new address. 
-		return 1;
-	}
-	else
-	{
-		//add device unsuccessful
-		printf("\nadd Register function unsuccessful.\n");
-		return 0;
-	}
-	//dispMatrix();
-}
-
-/****************************************************************************************
-void dispMatrix(void)
-	Description: This function is used for developer feedback and debugging purposes. 
-	The function calculates a properly sized matrix of the array devices[][]. It only 
-	displays a sized matrix that will fit all values that are non zero in the array. 
-****************************************************************************************/
-void dispMatrix(void)
-{
-	
-	int i;
-	int j;
-	
-	//the following for loop looks for the largest column to be displayed. 
-	int check=0;
-	int largestC = 0;
-	for(i = 1; i <= devices[0][0]; i++)
-	{
-		check = devices[0][i];
-		if(check > largestC)
-		{
-			largestC = check;
-		}
-	}
-	largestC++;
-	//the following prints the array with adjustable size depending on how many 
-	//devices are connected.
-	if(devices[0][0]) //make sure there is at least 1 reg, ad 1 therm synced
-	{
-		for(i = 0; i <= devices[0][0]; i++)
-		{
-			for(j = 0; j<=largestC; j++)
-			{
-				if(j == 0)
-				{
-					printf("[");//the start of a new row
-				}
-				
-				if(i == 0)
-				{
-					printf("   %d ", devices[i][j]); //variables in row 0 will be displayed as integers. 
-				}
-				else
-				{
-					printf("%#.2x ", devices[i][j]); //variables in all rows != 0 will be displayed as hex values.
-				}
-				
-				if(j == largestC)
-				{
-					printf("]\n"); //end of a row.
-				}
-				
-			}
-			
-		}
-	}
-	else	//if there isnt a minimum of 1 therm, and 1 reg, then dont display.
-	{
-		printf("Matrix is Empty. No Addresses stored.\n");
-	}
-	
-	
-	return;
-}
-
-/****************************************************************************************
-void rmDevAddr(unsigned char address)
-	Description: This function is used to remove an address from the 2 dimensional array
-	devices[][]. This function is called when the user selects the option from the LCD 
-	menu. The function requires an input unsigned char value of the address. The function
-	then determines whether that address is a thermostat or register then removes it 
-	and readjusts the array so that the addresses are shifted accordingly in place of 
-	the deleted address. If the address removed is for a register, the function shifts 
-	all other registers in that row after the column of the address to be removed to the 
-	left. If the address is for a thermostat, the whole row including all registers 
-	associated with that thermostat are removed and the last occupied row in the array
-	is moved into its place. 
-****************************************************************************************/
-void rmDevAddr(unsigned char address)
-{
-	int i;
-	int j;
-	int x;
-	int acc;
-	int locR;	//the row location of the address.
-	int locC;	//the column location of the address.
-	int devType; //1 for therm, 0 for reg.
-	
-	
-	/*
-	int check;
-	int largestC = 0;
-	//determine the largest column in the 2d array.
-	for(i = 1; i <= devices[0][0]; i++)
-	{
-		check = devices[0][i];
-		if(check > largestC)
-		{
-			largestC = check;
-		}
-	}
-	*/
-	
-	//find the location of the device. 
-	for(i=0;i<=devices[0][0];i++)
-	{
-		for(j=0;j<=devices[0][i];j++)
-		{
-			if(devices[i][j] == address)
-			{
-				locR = i;
-				locC = j;
-				printf("address location: [%d][%d]\n",i,j);
-				
-			}
-		}
-	}
-	
-	//record what type of device this is.
-	if(address & thermoID)	
-	{
-		devType = 1;
-		
-	}
-	else	
-	{
-		devType = 0;
-		//acc = devices[0][locR];
-		//devices[0][locR] = acc - 1;
-	}
-	
-	if(devType) //if devType = 1 = therm. if devType = 0 = reg.
-	{
-		int lastTherm = devices[0][0];//the last therm = total number of therms.
-		if(locR == devices[0][0])
-		{
-			for(j = locC; j <= devices[0][locR]; j++)
-			{
-				//if removing the last therm. remove all addresses in that row. 
-				devices[locR][j] = 0x00;
-				failedCon[locR][j] = 0;
-				
-			}
-			rtTimes[locR][thermTimer] = 0;
-			for(x = 0; x < COLUMN_COUNT; x++)
-			{
-				rateOfChange[locR][x] = 0;
-				if(x < 4)
-				{
-					temps[locR][x] = 0;
-				}
-			}
-		}
-		else
-		{
-			int y;
-			if(devices[0][lastTherm]>devices[0][locR])
-			{
-				y = devices[0][lastTherm];
-			}
-			else
-			{
-				y = devices[0][locR];
-			}
-			for(j = locC; j<= y; j++)
-			{
-				//if not removing the last therm, copy the last therm into this removed 
-				//addresses row and replace the last row with 0's
-				//do this for all arrays containing data for that thermostat.
-				devices[locR][j] = devices[lastTherm][j];
-				devices[lastTherm][j] = 0x00;
-				
-				failedCon[locR][j] = failedCon[lastTherm][j];
-				failedCon[lastTherm][j] = 0;
-				
-				regFlow[locR][j][sendingAF] = regFlow[lastTherm][j][sendingAF];
-				regFlow[lastTherm][j][sendingAF] = 0;
-				
-				regFlow[locR][j][receivingAF] = regFlow[lastTherm][j][receivingAF];
-				regFlow[lastTherm][j][receivingAF] = 0;
-			}
-			rtTimes[locR][thermTimer] = rtTimes[lastTherm][thermTimer];
-			rtTimes[lastTherm][thermTimer] = 0;
-			for(x = 0; x<COLUMN_COUNT; x++)
-			{
-				rateOfChange[locR][x] = rateOfChange[lastTherm][x];
-				rateOfChange[lastTherm][x] = 0;
-				if(x < 4)
-				{
-					temps[locR][x] = temps[lastTherm][x];
-					temps[lastTherm][x] = 0;
-				}
-			}
-		}
-		//decriment the therm count. 
-		acc = devices[0][0];
-		devices[0][0] = acc - 1;
-		//shift the column values in row 0.
-		devices[0][locR] = devices[0][lastTherm];
-		devices[0][lastTherm] = 0;
-	}
-	else
-	{
-		//if the address is a reg. remove the reg. and shift all reg in that row 
-		//(after the removed reg), to the left.
-		for(j = locC; j <= devices[0][locR]; j++)
-		{
-			devices[locR][j] = devices[locR][j+1];
-			
-			failedCon[locR][j] = failedCon[locR][j+1];
-			
-			regFlow[locR][j][sendingAF] = regFlow[locR][j+1][sendingAF];
-			
-			regFlow[locR][j][receivingAF] = regFlow[locR][j+1][receivingAF];
-		}
-		//decriment the register count for that row. 
-		acc = devices[0][locR];
-		devices[0][locR] = acc - 1;
-	}
-	
-	
-	dispMatrix();
-	return;
-}
-
-/****************************************************************************************
-void initTempsArr(void)
-	description: This function initializes the temps[][] array with predefined values. 
-	These values can change for testnig purposes however, the default value will be 0.
-****************************************************************************************/
-void initTempsArr(void)
-{
-	int i;
-	int j;
-	
-	//fill the array with 0's
-	for(i = 0; i<126; i++)
-	{
-		for(j = 0; j < 5; j++)
-		{
-			temps[i][j] = 0;
-			//failedCon[i][j] = 0;
-		}
-	}
-	//printf("done initTempsArr, temps[1][tempDiff]: %d\n",temps[1][tempDiff]);
-	initFailedCon();
-	return;
-}
-
-/****************************************************************************************
-void initFailedCon(void)
-	description: This function initializes the failedCon array to contain 0's.
-****************************************************************************************/
-void initFailedCon(void)
-{
-	int i;
-	int j;
-	
-	for(i = 0; i < 126; i++)
-	{
-		for(j = 0; j < 126; j++)
-		{
-			failedCon[i][j] = 0;
-		}
-	}
-	return;
-}
-/****************************************************************************************
-void retrieveTemps(void)
-	Description: This function uses protocol functions to send a request to the 
-	thermostats to retrieve their current and desired temperatures. It then waits 
-	for their reply and stores the data into the temps[][] array. If there is an error 
-	when attempting to communicate a counter is incremented in an array where the row
-	indexes correspond to the thermostat number. 
-****************************************************************************************/
-void retrieveTemps(void)
-{
-	//printf("in retriveTemps();\n");
-	int data1 = 0;
-	int data2 = 0;
-	int i;
-	int j;
-	//int rooms = devices[0][0];
-	unsigned char toAddr;
-	unsigned char msgCommand;
-	unsigned char source;
-	int attempt = 0;
-	//int retData1;
-	//int retData2;
-	
-	for(i = 1; i <= devices[0][0]; i++)//only do this loop as many times as there are synced therms
-	{
-		
-		data1 = 0;
-		data2 = 0;
-		//retrieve the address to send to which is stored in the 2d array. 
-		toAddr = devices[i][0];
-		//use protocol function to send data retrieval request.
-		if((attempt = sendMessage(GET_TEMPS, toAddr, data1, data2))) 
-		{
-			failedCon[i][0] = 0;
-			j=0;
-			//wait for their message, an iteration timeout is included here. 
-			while(!(attempt = getMessage(&msgCommand, &source, &data1, &data2, typeMC)))
-			{
-				printf("waiting for therm reply(Temps).\n");
-				
-				
-				if(j >= 10)	//if 20 consecutive connection attemps fail.
-				{
-					break;
-				}
-				delay(10);
-				j++;
-				
-				//if(smartDelay(20))
-				//{
-				//	return;
-					//updateDisplay();
-				//}
-			}
-			
-		}
-		if((msgCommand == RETURN_TEMPS && attempt && data1 > -150 && data1 < 150 && data2 > -150 && data2 < 150))
-		{//store data for temps in temporary variables since GET_HUM command will 
-		//overide the data.
-			printf("\nSuccessfull connection to therm: %d\n", i);
-			temps[i][retCurrTemp] = data1;
-			temps[i][retSetTemp] = data2;
-		}
-		else
-		{//-999 will be an indicator that the values are out of range (impractical) or
-		//no conneciton was established so no meaningful data was gathered.
-			if(!attempt)
-			{
-				printf("\nUnsuccessfull communication with therm: %d\n\n", i);
-			}
-			temps[i][retCurrTemp] = -999;
-			temps[i][retSetTemp] = -999;
-		}
-		msgCommand = 0x00;
-		source = 0x00;
-		
-		data1 = 0;
-		data2 = 0;
-		/*
-		delay(500);
-		//now retrieving humidity.
-		if((attempt = sendMessage(GET_HUM, toAddr, data1, data2)))
-		{
-			j=0;
-			//wait for reply from thermostat.
-			while(!(attempt = getMessage(&msgCommand, &source, &data1, &data2, typeMC)))
-			{
-				//printf("waiting for therm reply (Humidity).\n");
-				
-				
-				if(j >= 10)
-				{
-					break;
-				}
-				delay(10);
-				j++;
-				//if(smartDelay(20))
-				//{
-				//	return;
-					//updateDisplay();
-				//}
-			}
-				//store the data that was retrieved.
-		}
-		*/
-		if(attempt)
-		{
-			
-			//store retrieved data.
-			
-			//temps[i][2] = data1;
-			
-			printf("retCurrTemp: %d\n", temps[i][retCurrTemp]);
-			printf("retSetTemp: %d\n", temps[i][retSetTemp]);
-			printf("retHum: %d\n\n", temps[i][retHum]);
-			
-			failedCon[i][0] = 0;
-			
-		}
-		else if(failedCon[i][0] != 1)
-		{
-			printf("\nUnsuccessfull communication with therm: %d\n\n", i);
-			//we decriment this 10 times before we consider it an error
-			if(failedCon[i][0] <= 0 && (failedCon[i][0] > -5))
-			{
-				failedCon[i][0]--;
-				
-			}
-			else if(failedCon[i][0] <= -5)
-			{
-				failedCon[i][0] = 1;
-				printf("\nfailedCon: %d in i=%d\n", failedCon[i][0], i);
-				printf("error: unable to re-establish connection with therm: %d\n\n", i);
-			}
-			printf("retCurrTemp: %d\n", temps[i][retCurrTemp]);
-			printf("retSetTemp: %d\n", temps[i][retSetTemp]);
-			printf("retHum: %d\n\n", temps[i][retHum]);
-		}
-		//printf("failedCon for therm: %d, value: %d",i,failedCon[i][0]);
-		delay(500);
-	}
-	if(page == 0 && ((failedCon[0][0] == 1) || failedCon[0][1]))
-	{
-		conStatus = 1;
-		display(page, line, set);
-	}
-	else
-	{
-		updateStatus();
-	}
-	
-}
-
-/****************************************************************************************
-void initRegFlow(void)
-	Description: This function initializes the regFlow[] array with predefined values. 
-	The values should be 0 but can be changed for testing purposes. 
-****************************************************************************************/
-void initRegFlow(void)
-{
-	int i;
-	int j;
-	int z;
-	//fill array with 0's
-	for(i = 0; i<126; i++)
-	{
-		for(j = 0; j<126; j++)
-		{
-			for(z = 0; z < 2; z++)
-			{
-				regFlow[i][j][z] = 0;
-			}
-			
-		}
-		
-	}
-	
-	//The following assignments are for testing purposes.
-	//comment these out for real assignments.
-	//regFlow[1] = 80;
-	//regFlow[2] = 50;
-	
-	return;
-}
-
-/****************************************************************************************
-void setReg(void)
-	Description: This function uses the "sendMessage()" protocol function to send data 
-	to the synced registers. The values being sent are just a percentage value that 
-	ranges from 0 to 100. 
-****************************************************************************************/
-void setReg(void)
-{
-	//printf("Enter setReg();\n");
-	int data1;
-	int data2;
-	int i;
-	int j;
-	unsigned char toAddr;
-	unsigned char msgCommand;
-	unsigned char source;
-	int attempt;
-	int k;
-	
-	//go through each row where there are thermostats
-	for(i = 1; i<=devices[0][0]; i++)
-	{
-		//go through each column (register address) in the current row. 
-		for(j = 1; j<=devices[0][i]; j++)
-		{
-			//get the address we're sending to.
-			toAddr = devices[i][j];
-			printf("sending to register: %#.2x \n",toAddr);
-			//use protocol function to send the GET_FLOW request.
-			/*			
-			if((attempt = sendMessage(GET_FLOW, toAddr, data1, data2)))
-			{
-				k=0;
-				//wait for a reply from the reg. iteration timeout included.
-				while(!(attempt = getMessage(&msgCommand, &source, &data1, &data2, typeMC)))
-				{
-					//printf("waiting for reg reply (Pressure).\n");
-					k++;
-					
-					if(k >= 10)
-					{
-						break;
-					}
-					if(smartDelay(20))
-					{
-						updateDisplay();
-					}
-				}
-				
-				
-			}
-			
-			if(attempt)
-			{
-				//store the retrieved data. 
-				regFlow[i][j][receivingAF] = data1;
-				//printf("Pressure recieved from reg: %d\n",regFlow[i][j][receivingAF]);
-				//printf("Successful. sent: data1: %d data2: %d, to Address: %#.2x \n", data1, data2, toAddr);
-			*/
-			//printf("IJregFlow[%d][%d][sendingAF]: %d\n",i,j,regFlow[i][j][sendingAF]);
-			data1 = (regFlow[i][j][sendingAF])*10;
-			data2 = data1;
-			//delay(500);
-			printf("DATA SENT TO REGISTER[%d][%d]: %d\n",i,j,data1);
-
-			if((attempt = sendMessage(SET_FLOW, toAddr, data1, data2)))
-			{
-				failedCon[i][j] = 0;
-				//printf("SET_FLOW send successfull. sent D1: %d D2: %d to Address: %#.2x \n",data1, data2, toAddr);
-
-			}
-			
-			if(failedCon[i][j] != 1 && !attempt)
-			{
-				printf("\nUnsuccessfull communication with reg: %d in room: %d\n\n", j,i);
-				//we decriment this 10 times before we consider it an error
-				if(failedCon[i][j] <= 0 && (failedCon[i][j] > -5))
-				{
-					failedCon[i][j]--;
-				}
-				else if(failedCon[i][j] <= -5)
-				{
-					failedCon[i][j] = 1;
-					printf("failedCon: %d where i=%d,j=%d",failedCon[i][j],i,j);
-					printf("error: unable to re-establish connection with Reg: %d in room: %d\n\n",j, i);
-				}
-			}
-			//printf("failedCon for reg: %d, room: %d, value: %d",i,j,failedCon[i][0]);
-			delay(500);
-		}
-		
-	}
-	return;
-}
-
-/****************************************************************************************
-int countErrors(void)
-	Description: This funciton reads through the stored temperatures retrieved from 
-	retrieveTemps() and counts all the errors from each thermostat. 
-****************************************************************************************/
-int countErrors(void)
-{
-	failedCon[0][0] = 0;
-	//failedCon[0][1] = 0;
-	int i;
-	int j;
-	for(i = 1; i <= devices[0][0]; i++)
-	{
-		for(j = 0; j <= devices[0][i]; j++)
-		{
-			if(failedCon[i][j] == 1)
-			{
-				printf("\nIn countErrors before increment\nfailedCon[%d][%d]: %d\n",i,j,failedCon[i][j]);
-				failedCon[0][0]++;//this array location contains the total number of connection errors.
-				printf("\nIn countErrors after increment\nfailedCon[%d][%d]: %d\n",i,j,failedCon[i][j]);
-			}
-		}
-	}
-	int failed = failedCon[0][0];
-	//int failedReg = failedCon[0][1];
-	printf("\nFAILURES: %d\n",failed);
-	//delay(2000);
-	return failed;
-}
-
-/****************************************************************************************
-void initRocArray(void)
-	This function initializes the 2
-	dimensional array that is used to
-	store rate of change values. The 
-	array is initially populated with 
-	all zeros.
-****************************************************************************************/
-void initRocArray(void)
- {
-	int row, column;
- 
-	for (row = 0;row < ROW_COUNT; row++) 
-	{
-		for (column = 0;column < COLUMN_COUNT; column++) 
-		{
-			if(row == 0)
-			{
-				rateOfChange[row][column] = column*10;//The first row will contain the percentages being sent.
-			}
-			else
-			{
-				rateOfChange[row][column] = 0;// all other rows will contain 0's
-			}
-			
-		}
-	}  
-}
-
-/****************************************************************************************
-void calcDiff(void)
-	Description: This function reads through the stored data in the temps[][] array 
-	and calculates the difference between the set temperature and the current temperature. 
-	it then stores this result into its own column in the same array. This function only
-	calculates an absolute difference of the temperatures since the state of the hvac 
-	will be determined in the hvacControl() array. 
-****************************************************************************************/
-void calcDiff(void)
-{
-	int i; 
-	//int settingCount; //counter to determine if hvac setting should be changed. 
-	//int diff;
-	changeWarnCount = 0;
-	failedCon[0][1] = 0;
-	int heatingCount = 0;
-	int coolingCount = 0;
-	int diffTotal = 0;
-	temps[0][hvacOut] = 0;
-	printf("current hvac setting: %d\n",hvacSetting);
-	
-
-	for(i = 1; i <= devices[0][0]; i++)
-	{
-		//printf("temps[i][currTemp]: %d\ntemps[i][setTemp]: %d\n",temps[i][currTemp],temps[i][setTemp]);
-		if(temps[i][currTemp] != -999)
-		{
-			
-			if(hvacSetting == 2)//heating
-			{
-				
-				temps[i][tempDiff] = (temps[i][setTemp]) - temps[i][currTemp];
-				printf("\ntemp Diff for heating: %d\n", temps[i][tempDiff]);
-				if(temps[i][currTemp] < (temps[i][setTemp] - 1))
-				{
-					temps[0][hvacOut] = 1;	//hvac needs to turn on.
-				}
-				else if(temps[i][currTemp] > (temps[i][setTemp] + 1))
-				{
-					printf("incrementing changeWarnCount in heating.\n");
-					changeWarnCount++;
-				}
-			}
-			else if(hvacSetting == 1)//cooling
-			{
-				
-				temps[i][tempDiff] = temps[i][currTemp] - temps[i][setTemp];
-				//printf("in calcDiff(); in hvacSetting 1, currTemp: %d, setTemp: %d\n", temps[i][currTemp], temps[i][setTemp]);
-				printf("\ntemp Diff for cooling: %d\n", temps[i][tempDiff]);
-				if(temps[i][currTemp] > (temps[i][setTemp] + 1))
-				{
-					temps[0][hvacOut] = 1;
-				}
-				else if(temps[i][currTemp] < (temps[i][setTemp] - 1))
-				{
-					changeWarnCount++;
-				}
-			}
-			else if(hvacSetting == 0)//auto
-			{
-				temps[i][tempDiff] = temps[i][setTemp] - temps[i][currTemp];
-				printf("in auto setting temps[%d][tempDiff]: %d\n",i,temps[i][tempDiff]);
-				if(0 < temps[i][tempDiff])//if posative
-				{//heating
-					if(temps[i][tempDiff]>1)//if out of comfort range
-					{
-						printf("in auto setting(heating) temps[%d][tempDiff]: %d\n",i,temps[i][tempDiff]);
-						heatingCount++;
-						diffTotal = diffTotal + temps[i][tempDiff];
-					}
-				}
-				else if(0 > temps[i][tempDiff])
-				{//cooling
-					if(temps[i][tempDiff]<-1)//if out of comfort range
-					{
-						coolingCount++;
-						temps[i][tempDiff] = abs(temps[i][tempDiff]);
-						printf("in auto setting (cooling) temps[%d][tempDiff]: %d\n",i,temps[i][tempDiff]);
-						diffTotal = diffTotal - temps[i][tempDiff];
-					}
-					
-				}
-				
-			}
-		}
-		
-	}
-	//if most devices need to change setting (more than half)
-	if(hvacSetting != 3 && changeWarnCount > (devices[0][0]/2))
-	{
-		failedCon[0][1] = 1;
-	}
-	//printf("heatingCount: %d\ncoolingCount: %d\n", heatingCount, coolingCount);
-	int counts = heatingCount + coolingCount;
-	if(hvacSetting == 0 && counts)
-	{
-		
-		temps[0][hvacOut] = 1;
-		//printf("In auto and counts > 0. temps[0][hvacOut]: %d\n",temps[0][hvacOut]);
-		if(heatingCount > coolingCount)
-		{
-			hvacAuto = 1;
-		}
-		else if(coolingCount > heatingCount)
-		{
-			hvacAuto = 0;
-		}
-		else //heatingCount == coolingCount
-		{
-			if(diffTotal > 0)
-			{
-				hvacAuto = 1;
-			}
-			else if(diffTotal < 0)
-			{
-				hvacAuto = 0;
-			}
-			else
-			{
-			//diffTotal == 0; temperature difference totals are equal. (rare stalemate)
-				hvacAuto = -1;//this will turn on the fan to cycle air out and hopefully change temps out of stalemate
-			}
- 
-		}
-	}
-	
-	printf("failedCon[0][1]: %d\nchangWarnCount: %d\ntemps[0][hvacOut]: %d\nhvacAuto: %d\n", failedCon[0][1],changeWarnCount,temps[0][hvacOut],hvacAuto);
-	return;
-}
-
-/****************************************************************************************
-void hvacControl(void)
-	Description: This function controls the state of the hvac system. it also handles 
-	timers for each room to determine the amount of time it will take for the system 
-	to reach the desired temperature for that room. This is necessary information for 
-	calculating rate of changes and to attempt to reach all desired temperatures at the 
-	same time. 
-****************************************************************************************/
-void hvacControl(void)
-{
-	int i;
-	int j;
-	float maxTime = 0;
-	int maxTimeIndex;
-	int flowIndex;
-	int regPerc;
-	//the following assignments are for testing purposes.
-	/*
-	//rateOfChange[1][10] = 1.6;
-	//rateOfChange[2][6] = 1.2;
-	//rateOfChange[2][7] = 1.3;
-	//rateOfChange[2][8] = 1.6;
-	//rateOfChange[2][9] = 1.7;
-	//rateOfChange[2][10] = 1.8;
-	
-	rtTimes[1][thermTimer] = 46000;
-	rtTimes[2][thermTimer] = 46100;
-	regFlow[1][1][sendingAF] = 10;
-	regFlow[2][1][sendingAF] = 10;
-	temps[1][startDiff] = 2;
-	temps[2][startDiff] = 2;
-	hvacStatus = 1;//currently on or off?
-	temps[0][hvacOut] = 0;//does a room need a temp change?
-	*/
-	//the above assignments are for testin purposes.
-	
-	if(hvacStatus) //hvac is currently on
-	{
-		printf("HVAC IS CURRETNLY ON\n");
-		if(1)//hvac should stay on <temps[0][hvacOut]> <- this was in if statement, replaced with 1 for testing.
-		{
-			int outOfRangeCount = 0;
-			//printf("HVAC SHOULD STAY ON\n");
-			for(i=1;i<=devices[0][0];i++)
-			{
-				printf("in for loop. room: %d, timer: %d, diff: %d\n",i,rtTimes[i][thermTimer],temps[i][tempDiff]);
-				if(rtTimes[i][thermTimer] && temps[i][tempDiff] <= 0)//check if temps were acquired
-				{//if temps were acquired for certain rooms, calculate their rate of change for that 
-				//flow rate.
-					//printf("in 2nd for loop.\n");
-					flowIndex = regFlow[i][1][sendingAF];//what index was used to set the regFlow.
-					if(rateOfChange[i][flowIndex] == 0.0 && flowIndex != 0)
-					{//if there is no rate of change data, we will fill its row with theoretical
-					//values from this real rate of change.
-						if(flowIndex == 10)
-						{
-							int endTime = rtTimerEnd(i,thermTimer);
-							printf("temps[%d][startDiff]: %d, endTime: %d\n",i,temps[i][startDiff],endTime);
-							rateOfChange[i][flowIndex] = (float)(temps[i][startDiff]*60)/(float)(endTime);
-							//printf("roc[%d][flowIndex]: %f\n",i,rateOfChange[i][flowIndex]);
-						}
-						else
-						{
-							int endTime = rtTimerEnd(i,thermTimer);
-							printf("endTime: %d\n",endTime);
-							rateOfChange[i][flowIndex] = (float)(temps[i][startDiff]*60)/(float)(endTime);
-							float modifier = (float)(flowIndex)/(float)(10);
-							rateOfChange[i][10] = (rateOfChange[i][flowIndex])/modifier;
-						}
-						rtTimes[i][thermTimer] = 0;//reset the timer for this room. 
-						printf("calculating theoretical RoC data:\n");
-						for(j = 1; j < COLUMN_COUNT; j++)
-						{
-							if(j != flowIndex && j != 10)
-							{
-								//printf("IM HERE!!!\n");
-								float modifier = (float)(j)/(float)(10);//get percentage to calculate theoretical rates.
-								rateOfChange[i][j] = rateOfChange[i][flowIndex]*modifier;
-							}
-							printf("rateOfChange[%d][%d]: %f\n",i,j,rateOfChange[i][j]);
-						}
-					}
-					else//if there is rate of change data.
-					{
-						rateOfChange[i][flowIndex] = (float)(temps[i][startDiff]*60)/(float)(rtTimerEnd(i,thermTimer));
-						rtTimes[i][thermTimer] = 0;
-					}
-					adjustReg(i, 0);
-					setReg();//close the registers for the rooms that have reached their desired temp. 
-				}
-				else if(rtTimes[i][thermTimer] && temps[i][tempDiff] > 0)
-				{//if temps have not been reached (this might happen if the temp diff is == 1)
-					//we want to reach a temp difference = 0 to satisfy user expectations.
-					outOfRangeCount++;
-					printf("room: %d, still out of temp range\n", i);
-				}
-				else if(rtTimes[i][thermTimer] == 0 && temps[i][tempDiff] > 1)
-				{
-					rtTimerStart(i, thermTimer);
-					adjustReg(i, 10);
-					setReg();
-				}
-			}
-			if(!outOfRangeCount)
-			{//if all desired temperatures have been reached, turn off hvac system. 
-				printf("turning off system. \n");
-				digitalWrite(COOL, 1);
-				digitalWrite(FAN, 1);
-				digitalWrite(HEAT, 1);
-				hvacStatus = 0;
-			}
-		}
-		//testing if below is needed (moving it above)
-		/*
-		else //hvac should turn off.
-		{
-			printf("HVAC SHOULD TURN OFF\n");
-			int outOfRangeCount = 0;
-			for(i=1;i<devices[0][0];i++)
-			{
-				//we will only turn off hvac once all temps have reached the desired temp 
-				if(rtTimes[i][thermTimer] && temps[i][tempDiff] <= 0)
-				{
-					flowIndex = regFlow[i][1][sendingAF];//what index was used to set the regFlow.
-					rateOfChange[i][flowIndex] = (float)(temps[i][startDiff]*60)/(float)(rtTimerEnd(i,thermTimer));
-					
-					adjustReg(i,0);//close registers for the rooms that have reached their desired temps
-					rtTimes[i][thermTimer] = 0;//reset the timer for this room. 
-				}
-				else if(rtTimes[i][thermTimer] && temps[i][tempDiff] > 0)
-				{//if temps have not been reached (this might happen if the temp diff is == 1)
-					//we want to reach a temp difference = 0 to satisfy user expectations.
-					outOfRangeCount++;
-					printf("room: %d, still out of temp range\n", i);
-				}
-				
-				if(!outOfRangeCount)
-				{//if all desired temperatures have been reached, turn off hvac system. 
-					printf("turning off system. \n");
-					digitalWrite(COOL, 1);
-					digitalWrite(FAN, 1);
-					digitalWrite(HEAT, 1);
-				}
-			}
-		}
-		*/
-	}
-	else //hvac is currently off
-	{
-		printf("HVAC IS CURRENTLY OFF\n");
-		if(temps[0][hvacOut])//hvac should turn on
-		{
-			printf("HVAC SHOULD TURN ON\n");
-			int onTime;
-			for(i = 1; i <= devices[0][0]; i++)//calc maxTime the system should stay on
-			{
-				if(temps[i][tempDiff] > 1 && rateOfChange[i][10])
-				{
-					onTime = (temps[i][tempDiff]*60)/rateOfChange[i][10];
-					if(onTime>maxTime)
-					{
-						maxTimeIndex = i;																							
-						maxTime = onTime;
-					}
-				}
-			}//what happens if no therms have data? ================================
-			printf("maxTime: %f\n",maxTime);
-			if(hvacSetting == 1 || hvacSetting == 2 || hvacSetting == 0)//cooling, heating, auto
-			{
-				printf("hvac setting is 1, 2, or 0.\n");
-				for(i =1; i <= devices[0][0]; i++)//set registers i=room #
-				{
-					if(temps[i][tempDiff]>1)//if this room needs a temp change
-					{
-						printf("room: %d, needs a temp change.\n", i);
-						if(rateOfChange[i][10] == 0)
-						{//if no RoC data for that room
-							printf("room: %d, has no ROC data\n", i);
-							adjustReg(i,10); //adjust regesters for this room to 100 percent.
-							//start timer? =============================================
-						}
-						else//we have RoC data to use for this room.
-						{
-							printf("room: %d, has ROC data\n",i);
-							float timeLow;
-							float timeHigh;
-							
-							
-							for(j = 0; j < COLUMN_COUNT; j++)
-							{
-								timeLow = ((temps[i][tempDiff]*60)/rateOfChange[i][j]);
-								timeHigh = ((temps[i][tempDiff]*60)/rateOfChange[i][(j+1)]);
-								if(i == maxTimeIndex)
-								{
-									regPerc = 10;
-									break;
-								}
-								else if(timeLow >= maxTime && timeHigh <= maxTime)
-								{
-									printf("timeLow: %f\ntimeHigh: %f\nmaxTime: %f\n",timeLow, timeHigh, maxTime);
-									if(timeLow == maxTime || timeHigh == maxTime)
-									{
-										if(timeLow == maxTime)
-										{
-											regPerc = j;
-										}
-										else
-										{
-											regPerc = j+1;
-										}
-									}
-									else if((abs(maxTime - timeLow)) < (abs(timeHigh - maxTime)))
-									{
-										printf("using low index: %d\n", j);
-										//use low index (j)
-										regPerc = j;
-										break;
-									}
-									else 
-									{
-										printf("using high index: %d\n", (j+1));
-										//use high index (j+1)
-										regPerc = j+1;
-										if(regPerc > 10)
-										{
-											printf("regPerc out of range. = 10\n");
-											regPerc = 10;
-										}
-										
-										break;
-									}
-									
-								}
-							}
-							int tempval = regPerc;
-							printf("regesters in room: %d, using %d percent\n", i, tempval);
-							
-							//regPerc = 10;
-							
-							
-							adjustReg(i,regPerc);
-						}
-						rtTimerStart(i,thermTimer);	//start timer for this room which needs a temp change. 
-						temps[i][startDiff] = temps[i][tempDiff];
-						printf("started timer for room %d, start time: %d\n", i, rtTimes[i][thermTimer]);
-					}
-					
-				}
-				//regPerc = 10;
-				adjustReg(i,regPerc);
-				printf("setting Registers and turning on system\n");
-				setReg();//physically set registers
-				
-				if(hvacSetting == 0)//auto
-				{
-					printf("hvacSetting on auto.\n");
-					if(hvacAuto == 1)//heating
-					{
-						printf("auto will use heating\n");
-						digitalWrite(COOL, 1);
-						digitalWrite(FAN, 0);
-						digitalWrite(HEAT, 0);
-					}
-					else if(hvacAuto == 0)//cooling
-					{
-						printf("auto will use cooling\n");
-						digitalWrite(COOL, 0);
-						digitalWrite(FAN, 0);
-						digitalWrite(HEAT, 1);
-					}
-					else if(hvacAuto == -1)//fan
-					{
-						printf("auto will use fan\n");
-						digitalWrite(COOL, 1);
-						digitalWrite(FAN, 0);
-						digitalWrite(HEAT, 1);
-					}
-				}
-				else if(hvacSetting == 1)//cooling 
-				{
-					printf("hvacSetting on cooling.\n");
-					digitalWrite(COOL, 0);
-					digitalWrite(FAN, 0);
-					digitalWrite(HEAT, 1);
-				}
-				else if(hvacSetting == 2)//heating
-				{
-					printf("hvacSetting on heating.\n");
-					digitalWrite(COOL, 1);
-					digitalWrite(FAN, 0);
-					digitalWrite(HEAT, 0);
-				}
-				
-			}
-			else if(hvacSetting == 3) //Fan only.
-			{
-				printf("hvacSetting on fan.\n");
-				digitalWrite(COOL, 1);
-				digitalWrite(FAN, 0);
-				digitalWrite(HEAT, 1);
-			}
-			hvacStatus = 1;
-		}
-		else//hvac should stay off.
-		{
-			printf("HVAC SHOULD STAY OFF\n");
-		}
-	}
-	
-	return; 
-}
-
-/****************************************************************************************
-void adjustReg(int i, int flowIndex)
-	Description: this function adjusts all registers in a room to a specific flow rate.
-****************************************************************************************/
-void adjustReg(int i, int flowIndex)
-{
-	int j;
-	for(j = 0; j <= devices[0][i]; j++)
-	{
-		regFlow[i][j][sendingAF] = flowIndex;
-	}
-	return;
-}
-
-/****************************************************************************************
-void updateStatus(void)
-	Description: This funciton checks the current status of errors and warnings and 
-	displays the status to the user on the lcd home screen. 
-****************************************************************************************/
-void updateStatus(void)
-{
-	if(conStatus)
-	{
-		conStatus = 0;
-		display(page, line, set);
-	}
-
-	return;
-}
+/*****************************************************************************************
+syncing.c
+	by group 2: Raul Rojas, Christa McDaniel, Alex Fotso
+	
+	Objective: 
+	This file contains all functions needed to perfom the background computations and 
+	logic required to control the system. It is comprised of many functions which 
+	range in functionality from initializations, communications, data management, and 
+	computation.
+	
+	Functions:
+		initArray()
+		populateArrays()
+		addTherm()
+		addReg()
+		dispMatrix()
+		rmDevAddr()
+		initTempsArr()
+		initFailedCon()
+		roomOf()
+		devSynced()
+		storeTemps()
+		takeTelemetry()
+		storeBatch()
+		pollBatch()
+		roomSlope()
+		runRate()
+		ingestTemps()
+		dutyRest()
+		pollRoom()
+		pollNext()
+		pollWait()
+		pollInterval()
+		pollSoon()
+		printPollStats()
+		flowActed()
+		printActStats()
+		refreshStatus()
+		collectSyncStats()
+		printSyncStats()
+		initRegFlow()
+		setReg()
+		setRoomReg()
+		queueDone()
+		countErrors()
+		initRocArray()
+		markRoom()
+		markFlow()
+		markAllRooms()
+		voteSet()
+		roomDiff()
+		voteResult()
+		calcDiff()
+		roomUpdate()
+		roomControl()
+		hvacRelays()
+		hvacStart()
+		hvacRun()
+		hvacStop()
+		hvacEnter()
+		hvacEvent()
+		hvacControl()
+		hvacTrip()
+		adjustReg()
+		pushGroup()
+		updateRoutes()
+		fleetCaps()
+		updateStatus()
+		
+*****************************************************************************************/
+#include <wiringPi.h>
+#include <lcd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <mcp23017.h>
+#include "finalHeader.h"
+#include "messaging.h"
+
+#define ROW_COUNT  126
+#define COLUMN_COUNT  11
+
+int changeWarnCount; //count to determine if user should change hvac setting.
+					//used in auto setting to determine if system should change hvacSetting
+unsigned char devices[rows][columns];//This Array contains the organized addresses of all devices. 
+extern int lcdhdl;//This variable contains the lcd handle returned from lcd initialization. 
+extern int page;//this variable contains the current page that is being displayed on the LCD.
+extern int line;//this variable contains the current cursor position for menu navigation in the lcd.
+extern int set;//this variable contains the current item being edited by the user in set time.
+unsigned char addresses[126];//This array contains the addresses returned from initMC();
+extern unsigned int rtTimes[126][2];//This array contains the start times of the timers used. 
+int conStatus = 0;
+int failedCon[126][126];	//number of times failed to connect with devices
+							//[0][0] == connections errors
+							//[0][1] == incorrect hvac setting warning
+int temps[126][5];	//[Current temp | Set temp | Current Humidity | temp difference | startDiff]
+					//temps[0][3]: 1 if hvac needs to turn on. 0 if temps are at desired.
+					//use temps[0][hvacOut] "hvacOut" is the defined constant for this.
+
+int regFlow[126][126][3];//first two dimensions orginize the data the same way the 
+						//registers address is stored. in the third dimension
+						//the 0 index will store the sending airflow, while the 
+						//1 index will store the receiving current airflow (in pressure).
+						//the 2 index stores the last airflow the register acknowledged.
+int regRefreshCount = 0;	//setReg() calls modulo regRefresh, picks the rooms refreshed by each call.
+int roomGrouped[126];	//1 if every register in the room acknowledged its group address.
+int regGrouped[126][126];	//1 once the register acknowledged its current group address and slot.
+int subStatus[126];		//1 if the room's thermostat accepted a SUBSCRIBE and pushes its temps.
+unsigned int lastReport[126];	//millis() of the last temperatures received from each room.
+int syncErrOf[256];	//ms each device's clock was off at its last beacon, by address.
+int worstErrOf[256];	//largest of those errors seen, by address.
+int driftOf[256];	//clock drift in ppm reported by each device, by address.
+int syncSeen[256];	//number of sync reports received from each device, by address.
+extern volatile int radioWanted;//set by the menu thread when it needs the radio (adding devices).
+extern volatile int wdTripped;//set by the watchdog thread when it turned the hvac off.
+short histTemp[126][histLen];	//buffered temperature samples of each room in 0.1F, a ring.
+unsigned int histAt[126][histLen];	//millis() each sample was taken, as estimated by storeBatch().
+int histHead[126];	//next slot of the ring to be written.
+int histCount[126];	//samples held in the ring.
+unsigned int lastBatch[126];	//millis() of the last GET_BATCH sent to each room.
+unsigned int nextPoll[126];	//millis() each room is next due to be polled, see pollNext().
+int roomVote[126][voteCols];	//each room's part in calcDiff()'s decisions, row 0 holds the totals.
+int voteSetting = -1;	//hvacSetting the votes were taken for.
+int evalDirty[126];	//1 while the room is waiting in evalList[] to be looked at by roomControl().
+int evalList[126];	//rooms whose readings, setpoints or timers changed, see markRoom().
+int evalCount = 0;
+int flowDirty[126];	//1 while the room is waiting in flowList[] for setReg().
+int flowList[126];	//rooms with register flows to send, see markFlow().
+int flowCount = 0;
+unsigned int pollEvery[126];	//ms between polls of each room, see pollInterval().
+int pollTemp[126];	//temperature of each room at its last poll, -999 if unknown.
+int pollCount[126];	//polls of each room since the last printPollStats().
+int flowTimed[126];	//1 while a flow adjustReg() decided on waits to be acknowledged.
+unsigned int flowAt[126];	//millis() of that decision.
+unsigned int actCount = 0;	//flow changes acknowledged since the last printActStats().
+unsigned int actTotal = 0;	//their summed decision to actuation time in ms.
+unsigned int actMax = 0;
+extern int pollStale;
+extern int msgPriority;//1 to send queued messages by class, see sendQueue().
+int netAsleep = 0;	//1 while the devices were told to sleep by dutyRest().
+unsigned int netWake;	//millis() the MC radio is due to wake after dutyRest().
+
+
+float rateOfChange[ROW_COUNT][COLUMN_COUNT];//this array contains the rates of change for each therm.
+
+int hvacSetting = 0;	//user setting.
+						//not set: 0 (auto)
+						//cooling: 1
+						//heating: 2
+						//Fan only:3
+int hvacAuto; //variable for hvacSetting = auto (3). 0 for cooling, 1 for heating.
+int hvacStatus; //current hvac status. 0 for off, 1 for on.
+int hvacState = hvacOff;	//state of the hvac state machine, see hvacEvent().
+unsigned int hvacSince;	//millis() hvacState was entered.
+int hvacMode = -1;	//hvacSetting the state machine last saw.
+char *hvacStateName[5] = {"off", "starting", "conditioning", "settling", "fan only"};
+
+//unsigned char thermoID = 0x80;
+
+/****************************************************************************************
+void initArray(void)
+	This function initializes the 1 dimensional and 2 dimensional arrays which are used 
+	to store device addresses. The purpose of the 1 dimensional array is to provide a 
+	data structure for the protocol function to store the acquired addresses. Moreover, 
+	the 2 dimensional array is used to organize the 1 dimensional array addresses into 
+	a format that is easier to access and work with. The method in which the arrays will 
+	be organized can be seen below in the comment header for function populateArrays().
+****************************************************************************************/
+void initArray(void)
+{
+	int i;
+	int j;
+	//int p;
+	
+	//using max number of devices as conditions.
+	int r = rows;
+	int c = columns;
+	
+	for(i = 0; i < r; i++)//row loop.
+	{
+		for(j = 0; j < c; j++)//column loop.
+		{
+			devices[i][j] = 0x00;
+			//p = devices[i][j];
+			//printf("Row: %d, Column: %d, Content: %d\n", i, j, p);	//for testing.
+		}
+	}
+	
+	//filling in 1 dim. array with zero's
+	for(i = 0; i<126; i++)
+	{
+		addresses[i] = 0x00;
+	}
+	/* //===THE FOLLOWING ASSIGNMENTS ARE USED FOR TESTING PURPOSES ===
+	//test addresses
+	addresses[0]=0x81;
+	addresses[1]=0x7E;
+	
+	addresses[2]=0x7D;
+	
+	addresses[3]=0x82;
+	addresses[4]=0x7C;
+	addresses[5]=0x7B;
+	*/ //===END OF TEST ASSIGNMENTS ===
+	
+	//for debugging, printing the values in in the 1 dim. array. 
+	for(i = 0; i<10; i++)
+	{
+		printf("addresses[%d]: %#.2x\n\n", i, addresses[i]);
+	}
+	return;
+}
+
+
+/****************************************************************************************
+void poulateArrays(void)
+	Description: 
+	This funcion organizes the addresses stored in the 1 dimensional array
+	addresses[], which has been populated by the initMC() protocol function, into a 
+	2 dimensional array called devices[][]. This 2 dimensional array is orginized in a 
+	specific manner to allow for easy access and array address information to be acquired
+	by the MC. The method for organization is as follows:
+	
+	index [0][0] contains the total number of thermostats contained within the array. 
+	this number changes whenever the user adds or removes thermostats from the MC. 
+	every subsequent column within row 0 contains the number of registers per thermostat 
+	where the column number represents the thermostat number (or room #). 
+
+	Beginning from index [1][0], every row index within column 0 contains a thermostat 
+	address. For example, index [1][0] = thermostat 1, index [2][0] = thermostat 2, 
+	etc. We will indirectly label each thermostat its own room number for later reference
+	(thermostat 1 is room 1, thermostat 2 is room 2, etc).
+	
+	Finally every column index within a row, beginning with [1][1], will contain a 
+	register address which is associated with that rows thermostat.
+	
+	Below, an example is shown on how the 1 and 2 dimensional arrays are organized. 
+	
+	1 dim: [Therm A | Reg A1 | Reg A2 | Reg An | Therm B | Reg B1 | Reg Bn | Therm X]
+			.. and so on. where n is any number of registers or thermostats below 128 
+			
+	2 dim: 	[Therm t | #RegA | #RegB | #RegN] 
+			[Therm A | RegA1 | RegA2 | RegAN]			
+			[Therm B | RegB1 | RegB2 | RegBN]			
+			[Therm X | RegXN | RegXN | RegXN]	
+****************************************************************************************/
+void populateArrays(void)
+{
+	int i;
+	int tempCount=0;	//Start the temp count at 0
+	int registerCount=0;		//Start the registerCount at 1
+	
+	
+	for(i=0; i<126; i++)
+	{
+		
+		if(!(addresses[i]&thermoID) && addresses[i] != 0)	//If the address is less than 0x80 it's a register 1000 0000
+		{
+			registerCount++;                                //Incriment Register Count
+			//printf("registerCount = %d\n", registerCount);
+			devices[tempCount][registerCount]=addresses[i];	//Add the device to the temp row on the Second Column
+			devices[0][tempCount]=registerCount;			//Place the registerCount in the first row but equivanent column index of the Temp Row
+		}
+		else if((addresses[i]&thermoID) && addresses[i] != 0)					//If the address is greater than 0x80 it's a Tempurature Sensor
+		{
+			registerCount=0;								//Set RegisterCount back to zero
+			tempCount++;									//increment tempCount
+			//printf("tempCount: %d\n", tempCount);
+			devices[tempCount][registerCount]=addresses[i];	//Place temp address into Column 0 and corresponding row
+
+			devices[0][0]=tempCount;						//Place total Tempurature count in index [0][0]
+		}
+	}
+	
+	//display the matrix to console.
+	dispMatrix();
+	
+	//give each room's registers their group address, and poll every room straight away.
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		pushGroup(i);
+		nextPoll[i] = millis();
+		pollEvery[i] = pollPeriod;
+		pollTemp[i] = -999;
+	}
+	markAllRooms();
+	updateRoutes();
+	return;
+}
+
+/****************************************************************************************
+int addTherm(void)
+	Description: This function adds a thermostat address to the two dimensional array
+	devices[][]. The function first calls the protocol function addDevice() to acquire
+	connection with the new device and generate an address, then stores that address
+	into a variable. It then incriments the thermostat count in index [0][0] and moves
+	the address into the index slot after the the last thermostat address in column 0.
+	This function returns a (1) if connection was established and an address was created
+	successfully by the protocol function: addDevice(). If the process is unsuccessful, 
+	the function returns a 0. 
+****************************************************************************************/
+int addTherm(void)
+{
+	unsigned char devAddr;	//declarin variable where the address will be store. 
+	if(addDevice(&devAddr, 1))	//calling protocol function to add a new device.
+	{
+		//add device successfull.
+		int r = devices[0][0];	//increment the thermostat count in the 2d array.
+		r++;
+		devices[0][0] = r;
+		devices[r][0] = devAddr;	//store the new address in the next availble location
+		nextPoll[r] = millis();	//poll the new room straight away.
+		pollEvery[r] = pollPeriod;
+		pollTemp[r] = -999;
+		markRoom(r);
+		dispMatrix();	//display the 2d array with new address.
+		return 1;
+	}
+	else
+	{
+		//add device unsuccessful.
+		printf("\nadd Thermo function unsuccessful.\n");
+		return 0;
+	}
+}
+
+
+
+/****************************************************************************************
+void addReg(unsigned char addToRoom)
+	Description: This function adds a new register address to the two dimensional array 
+	devices[][]. This function stores the address in its corresponding thermostat row 
+	which is predifined by the user through menu selection.
+****************************************************************************************/
+int addReg(int addToRoom)
+{
+	unsigned char devAddr;	//declaring the variable that will store new address.
+	if(addDevice(&devAddr, 2))	//call the protocol function to add new device.
+	{
+		//add device successfull
+		//the next three lines increments the register count to the desired room.
+		int c = devices[0][addToRoom];
+		c++;
+		devices[0][addToRoom] = c;
+		
+		devices[addToRoom][c] = devAddr;	//stores the new address in an availble slot.
+		regFlow[addToRoom][c][ackedAF] = -1;	//the new register has not been sent a flow yet.
+		markFlow(addToRoom);
+		pushGroup(addToRoom);	//the new register joins the room's group.
+		updateRoutes();	//the room's thermostat can relay to it.
+		dispMatrix();	//display the 2d array with the new address. 
+		return 1;
+	}
+	else
+	{
+		//add device unsuccessful
+		printf("\nadd Register function unsuccessful.\n");
+		return 0;
+	}
+	//dispMatrix();
+}
+
+/****************************************************************************************
+void dispMatrix(void)
+	Description: This function is used for developer feedback and debugging purposes. 
+	The function calculates a properly sized matrix of the array devices[][]. It only 
+	displays a sized matrix that will fit all values that are non zero in the array. 
+****************************************************************************************/
+void dispMatrix(void)
+{
+	
+	int i;
+	int j;
+	
+	//the following for loop looks for the largest column to be displayed. 
+	int check=0;
+	int largestC = 0;
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		check = devices[0][i];
+		if(check > largestC)
+		{
+			largestC = check;
+		}
+	}
+	largestC++;
+	//the following prints the array with adjustable size depending on how many 
+	//devices are connected.
+	if(devices[0][0]) //make sure there is at least 1 reg, ad 1 therm synced
+	{
+		for(i = 0; i <= devices[0][0]; i++)
+		{
+			for(j = 0; j<=largestC; j++)
+			{
+				if(j == 0)
+				{
+					printf("[");//the start of a new row
+				}
+				
+				if(i == 0)
+				{
+					printf("   %d ", devices[i][j]); //variables in row 0 will be displayed as integers. 
+				}
+				else
+				{
+					printf("%#.2x ", devices[i][j]); //variables in all rows != 0 will be displayed as hex values.
+				}
+				
+				if(j == largestC)
+				{
+					printf("]\n"); //end of a row.
+				}
+				
+			}
+			
+		}
+	}
+	else	//if there isnt a minimum of 1 therm, and 1 reg, then dont display.
+	{
+		printf("Matrix is Empty. No Addresses stored.\n");
+	}
+	
+	
+	return;
+}
+
+/****************************************************************************************
+void rmDevAddr(unsigned char address)
+	Description: This function is used to remove an address from the 2 dimensional array
+	devices[][]. This function is called when the user selects the option from the LCD 
+	menu. The function requires an input unsigned char value of the address. The function
+	then determines whether that address is a thermostat or register then removes it 
+	and readjusts the array so that the addresses are shifted accordingly in place of 
+	the deleted address. If the address removed is for a register, the function shifts 
+	all other registers in that row after the column of the address to be removed to the 
+	left. If the address is for a thermostat, the whole row including all registers 
+	associated with that thermostat are removed and the last occupied row in the array
+	is moved into its place. 
+****************************************************************************************/
+void rmDevAddr(unsigned char address)
+{
+	int i;
+	int j;
+	int x;
+	int acc;
+	int locR;	//the row location of the address.
+	int locC;	//the column location of the address.
+	int devType; //1 for therm, 0 for reg.
+	
+	
+	/*
+	int check;
+	int largestC = 0;
+	//determine the largest column in the 2d array.
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		check = devices[0][i];
+		if(check > largestC)
+		{
+			largestC = check;
+		}
+	}
+	*/
+	
+	//find the location of the device. 
+	for(i=0;i<=devices[0][0];i++)
+	{
+		for(j=0;j<=devices[0][i];j++)
+		{
+			if(devices[i][j] == address)
+			{
+				locR = i;
+				locC = j;
+				printf("address location: [%d][%d]\n",i,j);
+				
+			}
+		}
+	}
+	
+	//record what type of device this is.
+	if(address & thermoID)	
+	{
+		devType = 1;
+		
+	}
+	else	
+	{
+		devType = 0;
+		//acc = devices[0][locR];
+		//devices[0][locR] = acc - 1;
+	}
+	
+	if(devType) //if devType = 1 = therm. if devType = 0 = reg.
+	{
+		int lastTherm = devices[0][0];//the last therm = total number of therms.
+		for(x = 0; x < voteCols; x++)
+		{
+			voteSet(locR, x, 0);//take the room out of the vote totals.
+		}
+		if(locR == devices[0][0])
+		{
+			for(j = locC; j <= devices[0][locR]; j++)
+			{
+				//if removing the last therm. remove all addresses in that row. 
+				devices[locR][j] = 0x00;
+				failedCon[locR][j] = 0;
+				
+			}
+			rtTimes[locR][thermTimer] = 0;
+			roomGrouped[locR] = 0;
+			flowTimed[locR] = 0;
+			subStatus[locR] = 0;
+			histCount[locR] = 0;
+			histHead[locR] = 0;
+			for(x = 0; x < COLUMN_COUNT; x++)
+			{
+				rateOfChange[locR][x] = 0;
+				if(x < 4)
+				{
+					temps[locR][x] = 0;
+				}
+			}
+		}
+		else
+		{
+			int y;
+			if(devices[0][lastTherm]>devices[0][locR])
+			{
+				y = devices[0][lastTherm];
+			}
+			else
+			{
+				y = devices[0][locR];
+			}
+			for(j = locC; j<= y; j++)
+			{
+				//if not removing the last therm, copy the last therm into this removed 
+				//addresses row and replace the last row with 0's
+				//do this for all arrays containing data for that thermostat.
+				devices[locR][j] = devices[lastTherm][j];
+				devices[lastTherm][j] = 0x00;
+				
+				failedCon[locR][j] = failedCon[lastTherm][j];
+				failedCon[lastTherm][j] = 0;
+				
+				regFlow[locR][j][sendingAF] = regFlow[lastTherm][j][sendingAF];
+				regFlow[lastTherm][j][sendingAF] = 0;
+				
+				regFlow[locR][j][receivingAF] = regFlow[lastTherm][j][receivingAF];
+				regFlow[lastTherm][j][receivingAF] = 0;
+				
+				regFlow[locR][j][ackedAF] = regFlow[lastTherm][j][ackedAF];
+				regFlow[lastTherm][j][ackedAF] = -1;
+			}
+			rtTimes[locR][thermTimer] = rtTimes[lastTherm][thermTimer];
+			rtTimes[lastTherm][thermTimer] = 0;
+			roomGrouped[locR] = roomGrouped[lastTherm];
+			roomGrouped[lastTherm] = 0;
+			subStatus[locR] = subStatus[lastTherm];
+			subStatus[lastTherm] = 0;
+			lastReport[locR] = lastReport[lastTherm];
+			lastBatch[locR] = lastBatch[lastTherm];
+			nextPoll[locR] = nextPoll[lastTherm];
+			pollEvery[locR] = pollEvery[lastTherm];
+			pollTemp[locR] = pollTemp[lastTherm];
+			pollCount[locR] = pollCount[lastTherm];
+			pollCount[lastTherm] = 0;
+			flowTimed[locR] = flowTimed[lastTherm];
+			flowAt[locR] = flowAt[lastTherm];
+			flowTimed[lastTherm] = 0;
+			for(x = 0; x < voteCols; x++)
+			{
+				roomVote[locR][x] = roomVote[lastTherm][x];
+				roomVote[lastTherm][x] = 0;
+			}
+			for(x = 0; x < histLen; x++)
+			{
+				histTemp[locR][x] = histTemp[lastTherm][x];
+				histAt[locR][x] = histAt[lastTherm][x];
+			}
+			histHead[locR] = histHead[lastTherm];
+			histCount[locR] = histCount[lastTherm];
+			histCount[lastTherm] = 0;
+			histHead[lastTherm] = 0;
+			for(x = 0; x<COLUMN_COUNT; x++)
+			{
+				rateOfChange[locR][x] = rateOfChange[lastTherm][x];
+				rateOfChange[lastTherm][x] = 0;
+				if(x < 4)
+				{
+					temps[locR][x] = temps[lastTherm][x];
+					temps[lastTherm][x] = 0;
+				}
+			}
+		}
+		//decriment the therm count. 
+		acc = devices[0][0];
+		devices[0][0] = acc - 1;
+		//shift the column values in row 0.
+		devices[0][locR] = devices[0][lastTherm];
+		devices[0][lastTherm] = 0;
+	}
+	else
+	{
+		//if the address is a reg. remove the reg. and shift all reg in that row 
+		//(after the removed reg), to the left.
+		for(j = locC; j <= devices[0][locR]; j++)
+		{
+			devices[locR][j] = devices[locR][j+1];
+			
+			failedCon[locR][j] = failedCon[locR][j+1];
+			
+			regFlow[locR][j][sendingAF] = regFlow[locR][j+1][sendingAF];
+			
+			regFlow[locR][j][receivingAF] = regFlow[locR][j+1][receivingAF];
+			
+			regFlow[locR][j][ackedAF] = regFlow[locR][j+1][ackedAF];
+		}
+		//decriment the register count for that row. 
+		acc = devices[0][locR];
+		devices[0][locR] = acc - 1;
+	}
+	
+	//the registers in the affected row were reshuffled, so push their group slots again.
+	if(locR <= devices[0][0])
+	{
+		pushGroup(locR);
+	}
+	markAllRooms();//room numbers moved, look at every room again.
+	updateRoutes();
+	
+	dispMatrix();
+	return;
+}
+
+/****************************************************************************************
+void initTempsArr(void)
+	description: This function initializes the temps[][] array with predefined values. 
+	These values can change for testnig purposes however, the default value will be 0.
+****************************************************************************************/
+void initTempsArr(void)
+{
+	int i;
+	int j;
+	
+	//fill the array with 0's
+	for(i = 0; i<126; i++)
+	{
+		for(j = 0; j < 5; j++)
+		{
+			temps[i][j] = 0;
+			//failedCon[i][j] = 0;
+		}
+	}
+	//printf("done initTempsArr, temps[1][tempDiff]: %d\n",temps[1][tempDiff]);
+	initFailedCon();
+	return;
+}
+
+/****************************************************************************************
+void initFailedCon(void)
+	description: This function initializes the failedCon array to contain 0's.
+****************************************************************************************/
+void initFailedCon(void)
+{
+	int i;
+	int j;
+	
+	for(i = 0; i < 126; i++)
+	{
+		for(j = 0; j < 126; j++)
+		{
+			failedCon[i][j] = 0;
+		}
+	}
+	return;
+}
+/****************************************************************************************
+int roomOf(unsigned char address)
+	Description: This function returns the room number (row in devices[][]) of the 
+	thermostat with the given address, or 0 if no synced thermostat has that address. 
+****************************************************************************************/
+int roomOf(unsigned char address)
+{
+	int i;
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		if(devices[i][0] == address)
+		{
+			return i;
+		}
+	}
+	return 0;
+}
+
+/****************************************************************************************
+int devSynced(unsigned char address)
+	Description: This function returns 1 if a thermostat or register with the given 
+	address is in devices[][], 0 if it is not or was removed. 
+****************************************************************************************/
+int devSynced(unsigned char address)
+{
+	int i;
+	int j;
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		for(j = 0; j <= devices[0][i]; j++)
+		{
+			if(devices[i][j] == address)
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/****************************************************************************************
+void storeTemps(int room, int curr, int set)
+	Description: This function stores temperatures pushed by a subscribed thermostat 
+	into the temps[][] array. Values out of range are ignored since the room will be 
+	polled by pollRoom() once its reports go stale. 
+****************************************************************************************/
+void storeTemps(int room, int curr, int set)
+{
+	if(room && curr > -150 && curr < 150 && set > -150 && set < 150)
+	{
+		printf("\nPushed temps from therm: %d\n", room);
+		temps[room][retCurrTemp] = curr;
+		temps[room][retSetTemp] = set;
+		failedCon[room][0] = 0;
+		lastReport[room] = millis();
+		roomUpdate(room);//act on the room now rather than after the next poll round.
+	}
+	return;
+}
+
+/****************************************************************************************
+void takeTelemetry(unsigned char msgType, unsigned char source, int val1, int val2)
+	Description: This function is given every reading a device pushes while the MC is 
+	not waiting on that device (see dispatchMessage() in messaging.c) and stores it. 
+	RETURN_TELEMETRY pushes carry the humidity as well. 
+****************************************************************************************/
+void takeTelemetry(unsigned char msgType, unsigned char source, int val1, int val2)
+{
+	int curr;
+	int set;
+	int room;
+	
+	if(msgType == RETURN_TEMPS)
+	{
+		storeTemps(roomOf(source), val1, val2);
+	}
+	else if(msgType == RETURN_BATCH)
+	{
+		storeBatch(roomOf(source), val1, val2);
+	}
+	else if(msgType == RETURN_TELEMETRY)
+	{
+		room = roomOf(source);
+		unpackTemps(val1, &curr, &set);
+		storeTemps(room, curr, set);
+		if(room && val2 >= 0 && val2 <= 100)
+		{
+			temps[room][retHum] = val2;
+		}
+	}
+	return;
+}
+
+/****************************************************************************************
+int storeBatch(int room, int val1, int val2)
+	Description: This function decodes a RETURN_BATCH and adds its samples to the room's 
+	history ring. The thermostat samples every batchPeriod ms, so each sample is dated 
+	back from the age of the last one. Samples not newer than the last one stored are 
+	skipped, those are a batch sent again after its ACK was lost. Returns 1 if the 
+	thermostat has more samples buffered. 
+****************************************************************************************/
+int storeBatch(int room, int val1, int val2)
+{
+	int samples[batchFrame];
+	int count;
+	int age;
+	int more;
+	int n;
+	int last;
+	unsigned int at;
+	unsigned int newest = millis();
+	
+	count = unpackBatch(val1, val2, samples, &age, &more);
+	if(!room || !count)
+	{
+		return more;
+	}
+	newest -= age * 1000;
+	for(n = 0; n < count; n++)
+	{
+		at = newest - ((count - 1 - n) * batchPeriod);
+		last = (histHead[room] + histLen - 1) % histLen;
+		if((histCount[room] && (int)(at - histAt[room][last]) < (batchPeriod / 2)) || samples[n] <= -1500 || samples[n] >= 1500)
+		{
+			continue;
+		}
+		histTemp[room][histHead[room]] = samples[n];
+		histAt[room][histHead[room]] = at;
+		histHead[room] = (histHead[room] + 1) % histLen;
+		if(histCount[room] < histLen)
+		{
+			histCount[room]++;
+		}
+	}
+	return more;
+}
+
+/****************************************************************************************
+void pollBatch(int room)
+	Description: This function collects the samples a thermostat buffered since the last 
+	call, at most once every batchEvery ms. It asks again while the thermostat reports 
+	more samples, up to the number of frames its buffer can fill. 
+****************************************************************************************/
+void pollBatch(int room)
+{
+	unsigned char toAddr = devices[room][0];
+	unsigned char msgCommand;
+	int data1;
+	int data2;
+	int more = 1;
+	int tries;
+	
+	if(!(linkCaps(toAddr) & capBatch) || (millis() - lastBatch[room]) < batchEvery)
+	{
+		return;
+	}
+	lastBatch[room] = millis();
+	for(tries = 0; more && tries < ((batchMax + batchFrame - 1) / batchFrame); tries++)
+	{
+		if(!sendMessage(GET_BATCH, toAddr, 0, 0))
+		{
+			return;
+		}
+		msgCommand = RETURN_BATCH;
+		if(!awaitReply(&msgCommand, toAddr, replyWait, &data1, &data2, typeMC))
+		{
+			return;
+		}
+		more = storeBatch(room, data1, data2);
+	}
+	return;
+}
+
+/****************************************************************************************
+float roomSlope(int room, int secs, int *n)
+	Description: This function fits a least squares line through the room's samples of 
+	the last secs seconds and returns its slope in F per minute. n is set to the number 
+	of samples used; with fewer than 2 (or all taken at once) the slope is 0. 
+****************************************************************************************/
+float roomSlope(int room, int secs, int *n)
+{
+	int k;
+	int slot;
+	unsigned int now = millis();
+	unsigned int first = 0;
+	double t;
+	double y;
+	double sumT = 0;
+	double sumY = 0;
+	double sumTT = 0;
+	double sumTY = 0;
+	double den;
+	
+	*n = 0;
+	for(k = 0; k < histCount[room]; k++)
+	{
+		slot = (histHead[room] + histLen - histCount[room] + k) % histLen;
+		if((now - histAt[room][slot]) > (unsigned int)secs * 1000)
+		{
+			continue;
+		}
+		if(*n == 0)
+		{
+			first = histAt[room][slot];
+		}
+		t = (histAt[room][slot] - first) / 60000.0;//minutes from the first sample used.
+		y = histTemp[room][slot] / 10.0;
+		sumT += t;
+		sumY += y;
+		sumTT += t * t;
+		sumTY += t * y;
+		(*n)++;
+	}
+	den = (*n * sumTT) - (sumT * sumT);
+	if(*n < 2 || den <= 0)
+	{
+		return 0;
+	}
+	return (float)(((*n * sumTY) - (sumT * sumY)) / den);
+}
+
+/****************************************************************************************
+float runRate(int room, int secs)
+	Description: This function returns the rate (F per minute) a room changed at during 
+	an hvac run of secs seconds. With at least fitMin buffered samples over the run it 
+	is the fitted slope, otherwise the start difference over the run time as before. 
+****************************************************************************************/
+float runRate(int room, int secs)
+{
+	int n;
+	float slope = roomSlope(room, secs, &n);
+	
+	if(n >= fitMin)
+	{
+		printf("room: %d, rate fitted from %d samples: %f\n", room, n, slope);
+		return (slope < 0) ? -slope : slope;
+	}
+	return (float)(temps[room][startDiff]*60)/(float)(secs);
+}
+
+/****************************************************************************************
+void ingestTemps(int ms)
+	Description: This function listens for RETURN_TEMPS frames pushed by subscribed 
+	thermostats for the given number of milliseconds and stores them as they arrive. 
+	With ms = 0 it only takes the frames that are already waiting. A menu request for 
+	the radio (radioTake()) ends the wait early. Between frames it naps in radioNap() 
+	for ingestPoll ms, so with the nRF24L01 IRQ not wired (RFIRQ) a pushed frame waits 
+	up to ingestPoll ms to be read. With it wired, the nap ends when the frame arrives. 
+****************************************************************************************/
+void ingestTemps(int ms)
+{
+	int data1;
+	int data2;
+	int count = 0;
+	unsigned char msgCommand;
+	unsigned char source;
+	unsigned int start = millis();
+	
+	do
+	{
+		msgCommand = 0;
+		if(getMessage(&msgCommand, &source, &data1, &data2, typeMC))
+		{
+			answerMessage(typeMC);
+			dispatchMessage(msgCommand, source, data1, data2);//pushed temperatures go to takeTelemetry().
+		}
+		if(msgCommand == 0)
+		{
+			radioNap(ingestPoll);//nothing waiting.
+		}
+		else
+		{
+			count++;
+		}
+	}while((((millis() - start) < ms) && !radioWanted) || ((msgCommand != 0) && (count < 2*devices[0][0])));
+	return;
+}
+
+/****************************************************************************************
+void dutyRest(unsigned int until)
+	Description: This function is used by the main loop when dutyMode is set and there 
+	is no radio work until the given time. It tells the devices to power their radios 
+	down until shortly before then and powers the MC radio down for the same window, 
+	then returns so the other tasks keep running. getMessage() wakes the MC radio once 
+	the window is over. Nothing is done while the network is still asleep or if some 
+	devices cannot sleep. 
+****************************************************************************************/
+void dutyRest(unsigned int until)
+{
+	unsigned int now = millis();
+	int left = (int)(until - now);
+	
+	if((netAsleep && !wakeDue(now, netWake)) || left <= 0 || !(fleetCaps() & capSleep))
+	{
+		return;
+	}
+	netWake = sleepNetwork(left);
+	netAsleep = !wakeDue(millis(), netWake);
+	return;
+}
+
+/****************************************************************************************
+int pollRoom(int i)
+	Description: This function uses protocol functions to send a request to the room's 
+	thermostat to retrieve its current and desired temperatures. It then waits for the 
+	reply and stores the data into the temps[][] array. If there is an error when 
+	attempting to communicate a counter is incremented in an array where the row 
+	indexes correspond to the thermostat number. Thermostats that answer are sent a 
+	SUBSCRIBE so they push their temperatures on change; subscribed rooms are only 
+	polled again once their reports go stale. Thermostats with capTelemetry are sent 
+	GET_TELEMETRY instead and their humidity is stored in temps[i][retHum] as well. 
+	Thermostats with capBatch are also asked for their buffered samples by pollBatch(). 
+	Returns 1 if the thermostat answered. 
+****************************************************************************************/
+int pollRoom(int i)
+{
+	int data1 = 0;
+	int data2 = 0;
+	unsigned char toAddr;
+	unsigned char msgCommand = 0;
+	int attempt = 0;
+	int telemetry;
+	int hum = -1;
+	
+	//collect the samples the thermostat buffered, subscribed or not.
+	pollBatch(i);
+	
+	//subscribed rooms push their own temperatures, poll them only once their reports go stale.
+	if(subStatus[i])
+	{
+		if((millis() - lastReport[i]) < (reportMax * 2000))
+		{
+			return 1;
+		}
+		subStatus[i] = 0;
+	}
+	
+	//retrieve the address to send to which is stored in the 2d array. 
+	toAddr = devices[i][0];
+	//thermostats that know GET_TELEMETRY return temperatures and humidity in one exchange.
+	telemetry = linkCaps(toAddr) & capTelemetry;
+	//use protocol function to send data retrieval request.
+	if((attempt = sendMessage(telemetry ? GET_TELEMETRY : GET_TEMPS, toAddr, data1, data2))) 
+	{
+		failedCon[i][0] = 0;
+		//wait for their reply, temperatures other thermostats push meanwhile are 
+		//stored by takeTelemetry().
+		msgCommand = telemetry ? RETURN_TELEMETRY : RETURN_TEMPS;
+		attempt = awaitReply(&msgCommand, toAddr, replyWait, &data1, &data2, typeMC);
+		if(!attempt)
+		{
+			printf("no therm reply(Temps).\n");
+		}
+		else if(telemetry)
+		{
+			hum = data2;
+			unpackTemps(data1, &data1, &data2);
+			msgCommand = RETURN_TEMPS;
+		}
+	}
+	if((msgCommand == RETURN_TEMPS && attempt && data1 > -150 && data1 < 150 && data2 > -150 && data2 < 150))
+	{
+		printf("\nSuccessfull connection to therm: %d\n", i);
+		temps[i][retCurrTemp] = data1;
+		temps[i][retSetTemp] = data2;
+		if(hum >= 0 && hum <= 100)
+		{
+			temps[i][retHum] = hum;
+		}
+		lastReport[i] = millis();
+		//ask the thermostat to push its temperatures from now on, if it knows how.
+		if(linkCaps(toAddr) & capSubscribe)
+		{
+			subStatus[i] = sendMessage(SUBSCRIBE, toAddr, reportDelta, reportMax);
+		}
+	}
+	else
+	{//-999 will be an indicator that the values are out of range (impractical) or
+	//no conneciton was established so no meaningful data was gathered.
+		if(!attempt)
+		{
+			printf("\nUnsuccessfull communication with therm: %d\n\n", i);
+		}
+		temps[i][retCurrTemp] = -999;
+		temps[i][retSetTemp] = -999;
+	}
+	
+	if(attempt)
+	{
+		printf("retCurrTemp: %d\n", temps[i][retCurrTemp]);
+		printf("retSetTemp: %d\n", temps[i][retSetTemp]);
+		printf("retHum: %d\n\n", temps[i][retHum]);
+		
+		failedCon[i][0] = 0;
+	}
+	else if(failedCon[i][0] != 1)
+	{
+		//we decriment this 10 times before we consider it an error
+		if(failedCon[i][0] <= 0 && (failedCon[i][0] > -5))
+		{
+			failedCon[i][0]--;
+			
+		}
+		else if(failedCon[i][0] <= -5)
+		{
+			failedCon[i][0] = 1;
+			printf("\nfailedCon: %d in i=%d\n", failedCon[i][0], i);
+			printf("error: unable to re-establish connection with therm: %d\n\n", i);
+		}
+	}
+	return attempt;
+}
+
+/****************************************************************************************
+int pollNext(unsigned int now)
+	Description: This function polls the room that has been due the longest, if any, 
+	and makes it due again after the interval pollInterval() picks from the reading. 
+	Only one room is polled per call so the main loop can run its other tasks on time 
+	however many rooms there are; with more rooms due than can be polled each room is 
+	polled late rather than the control period stretching. Queued user actions go out 
+	first. The menu may take the radio while they do, so the room is found again by its 
+	thermostat's address before it is polled. Returns 1 if a room was polled. 
+****************************************************************************************/
+int pollNext(unsigned int now)
+{
+	int i;
+	int room = 0;
+	unsigned char therm;
+	
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		if((int)(now - nextPoll[i]) >= 0 && (!room || (int)(nextPoll[room] - nextPoll[i]) > 0))
+		{
+			room = i;
+		}
+	}
+	if(!room)
+	{
+		return 0;
+	}
+	
+	therm = devices[room][0];
+	ingestTemps(0);//take any temperatures that were pushed since the last poll.
+	//actuations and user actions queued meanwhile go out before the poll.
+	sendQueue(prioUser);
+	room = roomOf(therm);//the menu may have removed or moved the room meanwhile.
+	if(!room)
+	{
+		return 0;
+	}
+	pollRoom(room);
+	pollCount[room]++;
+	roomUpdate(room);//the reading goes straight into the room's decision.
+	pollEvery[room] = pollInterval(room);
+	nextPoll[room] = now + pollEvery[room];
+	return 1;
+}
+
+/****************************************************************************************
+int pollWait(unsigned int now)
+	Description: This function returns the ms until the next room is due to be polled, 
+	0 if one is due already, or pollPeriod if there are no rooms. 
+****************************************************************************************/
+int pollWait(unsigned int now)
+{
+	int i;
+	int left;
+	int wait = pollPeriod;
+	
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		left = (int)(nextPoll[i] - now);
+		if(left < wait)
+		{
+			wait = left;
+		}
+	}
+	return (wait > 0) ? wait : 0;
+}
+
+/****************************************************************************************
+unsigned int pollInterval(int room)
+	Description: This function picks how long to wait before polling the room again, 
+	from the reading just taken. Rooms that did not answer, are out of their comfort 
+	range, have their registers open while the hvac runs, or whose temperature moved 
+	since the last poll (or is sloping over the buffered samples) are polled every 
+	pollMin ms. A stable room's interval doubles with each poll up to pollStale. 
+****************************************************************************************/
+unsigned int pollInterval(int room)
+{
+	int n;
+	float slope;
+	int active = 0;
+	unsigned int every = pollEvery[room] * 2;
+	
+	if(temps[room][currTemp] == -999 || pollTemp[room] == -999)
+	{
+		active = 1;//no reading, or nothing to compare it to yet.
+	}
+	else if(abs(temps[room][currTemp] - temps[room][setTemp]) > 1)
+	{
+		active = 1;//out of its comfort range, the hvac is or will be working on it.
+	}
+	else if(hvacStatus && regFlow[room][0][sendingAF])
+	{
+		active = 1;//still being conditioned.
+	}
+	else if(temps[room][currTemp] != pollTemp[room])
+	{
+		active = 1;
+	}
+	else
+	{
+		slope = roomSlope(room, 300, &n);
+		if(n >= fitMin && (slope > moveRate || slope < -moveRate))
+		{
+			active = 1;
+		}
+	}
+	pollTemp[room] = temps[room][currTemp];
+	
+	if(active || every < pollMin)
+	{
+		return pollMin;
+	}
+	return (every > (unsigned int)pollStale) ? (unsigned int)pollStale : every;
+}
+
+/****************************************************************************************
+void pollSoon(int room)
+	Description: This function is called when a room's registers are changed. It brings 
+	the room's next poll forward to within pollMin ms so the effect is followed closely. 
+****************************************************************************************/
+void pollSoon(int room)
+{
+	unsigned int now = millis();
+	
+	if(room < 1 || room > devices[0][0])
+	{
+		return;
+	}
+	pollEvery[room] = pollMin;
+	if((int)(nextPoll[room] - (now + pollMin)) > 0)
+	{
+		nextPoll[room] = now + pollMin;
+	}
+	return;
+}
+
+/****************************************************************************************
+void printPollStats(void)
+	Description: This function prints each room's poll interval and the number of polls 
+	since it was last called, then clears those counts. 
+****************************************************************************************/
+void printPollStats(void)
+{
+	int i;
+	int total = 0;
+	
+	printf("\nPolls: room | interval ms | polls\n");
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		printf("  %d | %u | %d\n", i, pollEvery[i], pollCount[i]);
+		total += pollCount[i];
+		pollCount[i] = 0;
+	}
+	printf("  total polls: %d\n", total);
+	return;
+}
+
+/****************************************************************************************
+void flowActed(int i)
+	Description: This function is called whenever registers of room i acknowledge a 
+	flow. Once every register holds the flow adjustReg() last decided on, the time 
+	since that decision is added to the actuation latency printActStats() reports. 
+****************************************************************************************/
+void flowActed(int i)
+{
+	int j;
+	unsigned int took;
+	
+	if(!flowTimed[i])
+	{
+		return;
+	}
+	for(j = 1; j <= devices[0][i]; j++)
+	{
+		if(regFlow[i][j][ackedAF] != regFlow[i][j][sendingAF])
+		{
+			return;//still waiting on this register.
+		}
+	}
+	flowTimed[i] = 0;
+	if(devices[0][i] < 1)
+	{
+		return;//nothing was actuated.
+	}
+	took = millis() - flowAt[i];
+	actCount++;
+	actTotal += took;
+	if(took > actMax)
+	{
+		actMax = took;
+	}
+	return;
+}
+
+/****************************************************************************************
+void printActStats(void)
+	Description: This function prints the average and worst time from a flow decision 
+	in adjustReg() to every register of the room acknowledging it, then clears them. 
+****************************************************************************************/
+void printActStats(void)
+{
+	printf("\nActuation latency (%s): %u changes, avg %u ms, max %u ms\n", 
+		msgPriority ? "by priority" : "in order", actCount, 
+		actCount ? actTotal/actCount : 0, actMax);
+	actCount = 0;
+	actTotal = 0;
+	actMax = 0;
+	return;
+}
+
+/****************************************************************************************
+void refreshStatus(void)
+	Description: This function shows the connection error on the main page if a 
+	thermostat stopped answering or the hvac setting looks wrong, otherwise it updates 
+	the LCD status normally. 
+****************************************************************************************/
+void refreshStatus(void)
+{
+	if(page == 0 && ((failedCon[0][0] == 1) || failedCon[0][1]))
+	{
+		conStatus = 1;
+		display(page, line, set);
+	}
+	else
+	{
+		updateStatus();
+	}
+	return;
+}
+
+/****************************************************************************************
+void collectSyncStats(void)
+	Description: This function asks every synced device for its time sync statistics 
+	with GET_SYNC_STATS and stores the reply by address: the ms its clock was off at the 
+	last beacon and the drift rate in ppm. Temperatures pushed while waiting are kept by 
+	takeTelemetry(). The addresses are taken before any is asked, since the menu may 
+	change devices[][] while it has the radio between devices. 
+****************************************************************************************/
+void collectSyncStats(void)
+{
+	int data1;
+	int data2;
+	int i;
+	int j;
+	int k;
+	int count = 0;
+	unsigned char addrs[256];
+	unsigned char toAddr;
+	unsigned char msgCommand;
+	
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		for(j = 0; j <= devices[0][i]; j++)//the thermostat, then the room's registers.
+		{
+			addrs[count++] = devices[i][j];
+		}
+	}
+	for(k = 0; k < count; k++)
+	{
+		toAddr = addrs[k];
+		if(!devSynced(toAddr) || !(linkCaps(toAddr) & capBeacon) || !sendMessage(GET_SYNC_STATS, toAddr, 0, 0))
+		{
+			continue;
+		}
+		msgCommand = RETURN_SYNC_STATS;
+		if(awaitReply(&msgCommand, toAddr, replyWait, &data1, &data2, typeMC))
+		{
+			syncErrOf[toAddr] = data1;
+			driftOf[toAddr] = data2;
+			if(abs(data1) > worstErrOf[toAddr])
+			{
+				worstErrOf[toAddr] = abs(data1);
+			}
+			syncSeen[toAddr]++;
+		}
+		radioPass();//the menu may take the radio between devices.
+	}
+	return;
+}
+
+/****************************************************************************************
+void printSyncStats(void)
+	Description: This function prints the time sync statistics gathered by 
+	collectSyncStats() for every device that has answered. 
+****************************************************************************************/
+void printSyncStats(void)
+{
+	int i;
+	
+	printf("\nTime sync: addr | last error ms | worst error ms | drift ppm | reports\n");
+	for(i = 0; i < 256; i++)
+	{
+		if(syncSeen[i])
+		{
+			printf("  %#.2x | %d | %d | %d | %d\n", i, syncErrOf[i], worstErrOf[i], driftOf[i], syncSeen[i]);
+		}
+	}
+	return;
+}
+
+/****************************************************************************************
+void initRegFlow(void)
+	Description: This function initializes the regFlow[] array with predefined values. 
+	The values should be 0 but can be changed for testing purposes. The acknowledged 
+	airflow is set to -1 so that every register is sent its flow on the first pass.
+****************************************************************************************/
+void initRegFlow(void)
+{
+	int i;
+	int j;
+	int z;
+	//fill array with 0's
+	for(i = 0; i<126; i++)
+	{
+		for(j = 0; j<126; j++)
+		{
+			for(z = 0; z < 2; z++)
+			{
+				regFlow[i][j][z] = 0;
+			}
+			regFlow[i][j][ackedAF] = -1;
+			
+		}
+		
+	}
+	
+	//The following assignments are for testing purposes.
+	//comment these out for real assignments.
+	//regFlow[1] = 80;
+	//regFlow[2] = 50;
+	
+	return;
+}
+
+/****************************************************************************************
+void setReg(void)
+	Description: This function sends the register flows that need sending. Only the 
+	rooms in flowList[], whose flows were changed by adjustReg() or not acknowledged, 
+	are gone through, so the work follows what changed rather than the building size. 
+	Each call also refreshes every regRefresh'th room in turn, so every register is 
+	sent its flow again once every regRefresh calls in case it lost its state. The menu 
+	may change devices[][] while it has the radio between rooms, so the listed rooms are 
+	kept by their thermostat's address and found again before each is sent. 
+****************************************************************************************/
+void setReg(void)
+{
+	int i;
+	int k;
+	int count = flowCount;
+	unsigned char therms[126];
+	
+	//take the list, rooms marked while sending are kept for the next call.
+	for(k = 0; k < count; k++)
+	{
+		therms[k] = devices[flowList[k]][0];
+		flowDirty[flowList[k]] = 0;
+	}
+	flowCount = 0;
+	
+	regRefreshCount = (regRefreshCount + 1) % regRefresh;
+	for(k = 0; k < count; k++)
+	{
+		i = roomOf(therms[k]);
+		if(i && (i % regRefresh) != regRefreshCount)
+		{
+			setRoomReg(i, 0);
+			radioPass();//the menu may take the radio after a room's group frame.
+		}
+	}
+	//this call's share of the refresh. i only counts through the rows, a row the menu 
+	//moved meanwhile is refreshed in its new place.
+	for(i = regRefreshCount ? regRefreshCount : regRefresh; i <= devices[0][0]; i += regRefresh)
+	{
+		setRoomReg(i, 1);
+		radioPass();
+	}
+	//send the queued flows along with anything else that is waiting.
+	sendQueue(prioPoll);
+	hvacEvent(hvacEvFlows, 0);
+	return;
+}
+
+/****************************************************************************************
+void setRoomReg(int i, int refresh)
+	Description: This function uses the "sendMessage()" protocol function to send data 
+	to the synced registers of room i. The values being sent are just a percentage value 
+	that ranges from 0 to 100. Only registers whose sending airflow differs from the last 
+	airflow they acknowledged are sent a SET_FLOW, or every register with refresh set. 
+****************************************************************************************/
+void setRoomReg(int i, int refresh)
+{
+	int data1;
+	int data2;
+	int j;
+	unsigned char toAddr;
+	int send;
+	unsigned char members[126];
+	int handled[126];
+	
+	//if the registers in this room share a group address, set them all with 
+	//one GROUP_FLOW frame. registers that did not ACK are sent a SET_FLOW below.
+	send = 0;
+	for(j = 1; j<=devices[0][i]; j++)
+	{
+		handled[j] = 0;
+		members[j-1] = devices[i][j];
+		if(send != -1 && (refresh || regFlow[i][j][ackedAF] != regFlow[i][j][sendingAF]))
+		{
+			send = 1;
+		}
+		if(regFlow[i][j][sendingAF] != regFlow[i][1][sendingAF])
+		{
+			send = -1;	//mixed flows in one room cannot be sent as a group.
+		}
+	}
+	if(roomGrouped[i] && devices[0][i] > 1 && send == 1)
+	{
+		data1 = (regFlow[i][1][sendingAF])*10;
+		printf("DATA SENT TO ROOM %d GROUP: %d\n",i,data1);
+		sendGroupFlow(devices[i][0], data1, members, devices[0][i], groupAcks, &handled[1]);
+		for(j = 1; j<=devices[0][i]; j++)
+		{
+			if(!groupAcks)
+			{
+				handled[j] = 1;
+			}
+			if(handled[j])
+			{
+				failedCon[i][j] = 0;
+				regFlow[i][j][ackedAF] = regFlow[i][j][sendingAF];
+			}
+		}
+	}
+	
+	//go through each column (register address) in the current row. 
+	for(j = 1; j<=devices[0][i]; j++)
+	{
+		//skip registers which already have this flow unless this is a refresh pass.
+		if(handled[j] || (!refresh && regFlow[i][j][ackedAF] == regFlow[i][j][sendingAF]))
+		{
+			continue;
+		}
+		//get the address we're sending to.
+		toAddr = devices[i][j];
+		printf("sending to register: %#.2x \n",toAddr);
+		//printf("IJregFlow[%d][%d][sendingAF]: %d\n",i,j,regFlow[i][j][sendingAF]);
+		data1 = (regFlow[i][j][sendingAF])*10;
+		data2 = data1;
+		//delay(500);
+		printf("DATA SENT TO REGISTER[%d][%d]: %d\n",i,j,data1);
+		
+		//queue the actuation, queueDone() records the result once it is sent.
+		queueMessage(prioAct, SET_FLOW, toAddr, data1, data2);
+	}
+	flowActed(i);//the group frame or an earlier ACK may have finished the change.
+	return;
+}
+
+/****************************************************************************************
+void queueDone(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2, 
+int success)
+	Description: This function is called by sendQueue() with the result of every queued 
+	message. It finds the register by its address, since devices[][] may have been 
+	reshuffled while the message waited, then records the acknowledged flow or counts 
+	the failed connection. A room is only grouped once every one of its registers has 
+	acknowledged its SET_GROUP. 
+****************************************************************************************/
+void queueDone(unsigned char msgType, unsigned char msgAddr, int msgVal1, int msgVal2, int success)
+{
+	int i;
+	int j;
+	int locR = 0;
+	int locC = 0;
+	
+	//find the register this message was sent to.
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		for(j = 1; j <= devices[0][i]; j++)
+		{
+			if(devices[i][j] == msgAddr)
+			{
+				locR = i;
+				locC = j;
+			}
+		}
+	}
+	if(!locR)
+	{
+		return;
+	}
+	i = locR;
+	j = locC;
+	
+	if(msgType == SET_FLOW)
+	{
+		if(success)
+		{
+			failedCon[i][j] = 0;
+			regFlow[i][j][ackedAF] = msgVal1/10;
+			flowActed(i);
+			//printf("SET_FLOW send successfull. sent D1: %d D2: %d to Address: %#.2x \n",msgVal1, msgVal2, msgAddr);
+		}
+		else
+		{
+			markFlow(i);//retry on the next setReg().
+		}
+		if(!success && failedCon[i][j] != 1)
+		{
+			printf("\nUnsuccessfull communication with reg: %d in room: %d\n\n", j,i);
+			//we decriment this 10 times before we consider it an error
+			if(failedCon[i][j] <= 0 && (failedCon[i][j] > -5))
+			{
+				failedCon[i][j]--;
+			}
+			else if(failedCon[i][j] <= -5)
+			{
+				failedCon[i][j] = 1;
+				printf("failedCon: %d where i=%d,j=%d",failedCon[i][j],i,j);
+				printf("error: unable to re-establish connection with Reg: %d in room: %d\n\n",j, i);
+			}
+		}
+	}
+	else if(msgType == SET_GROUP && !success)
+	{
+		printf("register: %d in room: %d did not take its group.\n", j, i);
+		regGrouped[i][j] = 0;
+		roomGrouped[i] = 0;
+	}
+	else if(msgType == SET_GROUP && msgVal1 == devices[i][0] && msgVal2 == j-1)
+	{
+		//only the room's current group and slot count, the row may have been reshuffled.
+		regGrouped[i][j] = 1;
+		roomGrouped[i] = 1;
+		for(j = 1; j <= devices[0][i]; j++)
+		{
+			if(!regGrouped[i][j])
+			{
+				roomGrouped[i] = 0;
+			}
+		}
+	}
+	return;
+}
+
+/****************************************************************************************
+int countErrors(void)
+	Description: This funciton reads through the stored temperatures retrieved from 
+	pollRoom() and counts all the errors from each thermostat. 
+****************************************************************************************/
+int countErrors(void)
+{
+	failedCon[0][0] = 0;
+	//failedCon[0][1] = 0;
+	int i;
+	int j;
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		for(j = 0; j <= devices[0][i]; j++)
+		{
+			if(failedCon[i][j] == 1)
+			{
+				printf("\nIn countErrors before increment\nfailedCon[%d][%d]: %d\n",i,j,failedCon[i][j]);
+				failedCon[0][0]++;//this array location contains the total number of connection errors.
+				printf("\nIn countErrors after increment\nfailedCon[%d][%d]: %d\n",i,j,failedCon[i][j]);
+			}
+		}
+	}
+	int failed = failedCon[0][0];
+	//int failedReg = failedCon[0][1];
+	printf("\nFAILURES: %d\n",failed);
+	//delay(2000);
+	return failed;
+}
+
+/****************************************************************************************
+void initRocArray(void)
+	This function initializes the 2
+	dimensional array that is used to
+	store rate of change values. The 
+	array is initially populated with 
+	all zeros.
+****************************************************************************************/
+void initRocArray(void)
+ {
+	int row, column;
+ 
+	for (row = 0;row < ROW_COUNT; row++) 
+	{
+		for (column = 0;column < COLUMN_COUNT; column++) 
+		{
+			if(row == 0)
+			{
+				rateOfChange[row][column] = column*10;//The first row will contain the percentages being sent.
+			}
+			else
+			{
+				rateOfChange[row][column] = 0;// all other rows will contain 0's
+			}
+			
+		}
+	}  
+}
+
+/****************************************************************************************
+void markRoom(int i)
+	Description: This function adds room i to the rooms roomControl() has to look at 
+	again, if it is not waiting already. 
+****************************************************************************************/
+void markRoom(int i)
+{
+	if(i >= 1 && i <= devices[0][0] && !evalDirty[i])
+	{
+		evalDirty[i] = 1;
+		evalList[evalCount++] = i;
+	}
+	return;
+}
+
+/****************************************************************************************
+void markFlow(int i)
+	Description: This function adds room i to the rooms setReg() sends flows to, if it 
+	is not waiting already. 
+****************************************************************************************/
+void markFlow(int i)
+{
+	if(i >= 1 && i <= devices[0][0] && !flowDirty[i])
+	{
+		flowDirty[i] = 1;
+		flowList[flowCount++] = i;
+	}
+	return;
+}
+
+/****************************************************************************************
+void markAllRooms(void)
+	Description: This function rebuilds both lists with every room in them, for when 
+	rooms were added, removed or renumbered. 
+****************************************************************************************/
+void markAllRooms(void)
+{
+	int i;
+	
+	evalCount = 0;
+	flowCount = 0;
+	for(i = 0; i < 126; i++)
+	{
+		evalDirty[i] = 0;
+		flowDirty[i] = 0;
+	}
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		markRoom(i);
+		markFlow(i);
+	}
+	return;
+}
+
+/****************************************************************************************
+int voteSet(int i, int col, int val)
+	Description: This function sets room i's contribution to one of the roomVote[][] 
+	columns and keeps the total in row 0 up to date. Returns 1 if it changed. 
+****************************************************************************************/
+int voteSet(int i, int col, int val)
+{
+	int old = roomVote[i][col];
+	
+	roomVote[0][col] += val - old;
+	roomVote[i][col] = val;
+	return (val != old);
+}
+
+/****************************************************************************************
+void roomDiff(int i)
+	Description: This function calculates the difference between room i's set 
+	temperature and its current temperature for the hvac setting and stores it in 
+	temps[i][tempDiff], then replaces the room's earlier contribution to the vote 
+	totals calcDiff() decides from. Rooms without a reading contribute nothing and 
+	keep their last difference. If anything changed the room is marked for 
+	roomControl(). 
+****************************************************************************************/
+void roomDiff(int i)
+{
+	int old = temps[i][tempDiff];
+	int changed;
+	int heat = 0;
+	int cool = 0;
+	int diff = 0;
+	int warn = 0;
+	int out = 0;
+	
+	if(temps[i][currTemp] != -999)
+	{
+		if(hvacSetting == 2)//heating
+		{
+			temps[i][tempDiff] = (temps[i][setTemp]) - temps[i][currTemp];
+			printf("\ntemp Diff for heating: %d\n", temps[i][tempDiff]);
+			if(temps[i][currTemp] < (temps[i][setTemp] - 1))
+			{
+				out = 1;	//hvac needs to turn on.
+			}
+			else if(temps[i][currTemp] > (temps[i][setTemp] + 1))
+			{
+				printf("incrementing changeWarnCount in heating.\n");
+				warn = 1;
+			}
+		}
+		else if(hvacSetting == 1)//cooling
+		{
+			temps[i][tempDiff] = temps[i][currTemp] - temps[i][setTemp];
+			printf("\ntemp Diff for cooling: %d\n", temps[i][tempDiff]);
+			if(temps[i][currTemp] > (temps[i][setTemp] + 1))
+			{
+				out = 1;
+			}
+			else if(temps[i][currTemp] < (temps[i][setTemp] - 1))
+			{
+				warn = 1;
+			}
+		}
+		else if(hvacSetting == 0)//auto
+		{
+			temps[i][tempDiff] = temps[i][setTemp] - temps[i][currTemp];
+			printf("in auto setting temps[%d][tempDiff]: %d\n",i,temps[i][tempDiff]);
+			if(temps[i][tempDiff] > 1)//heating, out of comfort range
+			{
+				heat = 1;
+				diff = temps[i][tempDiff];
+			}
+			else if(temps[i][tempDiff] < -1)//cooling, out of comfort range
+			{
+				cool = 1;
+				temps[i][tempDiff] = abs(temps[i][tempDiff]);
+				printf("in auto setting (cooling) temps[%d][tempDiff]: %d\n",i,temps[i][tempDiff]);
+				diff = -temps[i][tempDiff];
+			}
+		}
+	}
+	changed = (temps[i][tempDiff] != old);
+	changed |= voteSet(i, voteHeat, heat);
+	changed |= voteSet(i, voteCool, cool);
+	changed |= voteSet(i, voteDiff, diff);
+	changed |= voteSet(i, voteWarn, warn);
+	changed |= voteSet(i, voteOut, out);
+	if(changed)
+	{
+		markRoom(i);
+	}
+	return;
+}
+
+/****************************************************************************************
+void voteResult(void)
+	Description: This function makes the decisions calcDiff() is responsible for from 
+	the totals in roomVote[0][]: whether the hvac needs to turn on, which way auto 
+	should run, and whether most rooms want the other hvac setting. It does not go 
+	through the rooms, so it is cheap enough to run after every reading. 
+****************************************************************************************/
+void voteResult(void)
+{
+	changeWarnCount = roomVote[0][voteWarn];
+	failedCon[0][1] = 0;
+	temps[0][hvacOut] = 0;
+	
+	if(hvacSetting == 1 || hvacSetting == 2)
+	{
+		temps[0][hvacOut] = (roomVote[0][voteOut] > 0);
+	}
+	//if most devices need to change setting (more than half)
+	if(hvacSetting != 3 && changeWarnCount > (devices[0][0]/2))
+	{
+		failedCon[0][1] = 1;
+	}
+	if(hvacSetting == 0 && (roomVote[0][voteHeat] + roomVote[0][voteCool]))
+	{
+		temps[0][hvacOut] = 1;
+		if(roomVote[0][voteHeat] > roomVote[0][voteCool])
+		{
+			hvacAuto = 1;
+		}
+		else if(roomVote[0][voteCool] > roomVote[0][voteHeat])
+		{
+			hvacAuto = 0;
+		}
+		else //heating count == cooling count
+		{
+			if(roomVote[0][voteDiff] > 0)
+			{
+				hvacAuto = 1;
+			}
+			else if(roomVote[0][voteDiff] < 0)
+			{
+				hvacAuto = 0;
+			}
+			else
+			{
+			//difference totals are equal. (rare stalemate)
+				hvacAuto = -1;//this will turn on the fan to cycle air out and hopefully change temps out of stalemate
+			}
+		}
+	}
+	return;
+}
+
+/****************************************************************************************
+void calcDiff(void)
+	Description: This function makes sure every room's temperature difference is up to 
+	date, then decides from the vote totals if the hvac needs to turn on. Each room's 
+	difference is normally calculated by roomUpdate() as its reading arrives, so the 
+	rooms are only gone through again when the hvac setting has changed. This function 
+	only calculates an absolute difference of the temperatures since the state of the 
+	hvac will be determined in the hvacControl() array. 
+****************************************************************************************/
+void calcDiff(void)
+{
+	int i;
+	printf("current hvac setting: %d\n",hvacSetting);
+	
+	if(voteSetting != hvacSetting)
+	{
+		voteSetting = hvacSetting;
+		for(i = 1; i <= devices[0][0]; i++)
+		{
+			roomDiff(i);
+		}
+	}
+	voteResult();
+	
+	printf("failedCon[0][1]: %d\nchangWarnCount: %d\ntemps[0][hvacOut]: %d\nhvacAuto: %d\n", failedCon[0][1],changeWarnCount,temps[0][hvacOut],hvacAuto);
+	return;
+}
+
+/****************************************************************************************
+void roomUpdate(int i)
+	Description: This function is called as each room's reading arrives, polled or 
+	pushed, so the room is acted on straight away rather than after the other rooms. 
+	Its difference and vote are updated and, while the hvac runs, its registers are 
+	decided by roomControl(), if anything changed, and sent by the actuation task 
+	right after. If the totals 
+	now call for the hvac to turn on, or no room is still out of range, the control 
+	task is made due so the decision for the whole system is not left for a period. 
+****************************************************************************************/
+void roomUpdate(int i)
+{
+	int flow;
+	
+	if(i < 1 || i > devices[0][0])
+	{
+		return;
+	}
+	if(voteSetting != hvacSetting)
+	{
+		taskKick(taskControl);//the setting changed, calcDiff() goes through every room.
+		return;
+	}
+	roomDiff(i);
+	voteResult();
+	flow = regFlow[i][0][sendingAF];
+	hvacEvent(hvacEvReading, i);//the hvac is switched on or off now if this reading calls for it.
+	if(regFlow[i][0][sendingAF] != flow)
+	{
+		taskKick(taskActuate);
+	}
+	return;
+}
+
+/****************************************************************************************
+int roomControl(int i)
+	Description: This function makes the register decision for room i while the hvac 
+	is on. A room that reached its temperature has its rate of change for the flow 
+	used calculated and its registers closed; a room that needs a temperature change 
+	and has no run going has its timer started and its registers opened fully. The 
+	room's voteBusy is set while its run has not reached the temperature, so the hvac 
+	can be turned off once roomVote[0][voteBusy] is 0. Returns that busy flag. 
+****************************************************************************************/
+int roomControl(int i)
+{
+	int j;
+	int flowIndex;
+	int busy = 0;
+	
+	evalDirty[i] = 0;//taken off evalList[], hvacControl() skips it there.
+	printf("roomControl. room: %d, timer: %u, diff: %d\n",i,rtTimes[i][thermTimer],temps[i][tempDiff]);
+	if(rtTimes[i][thermTimer] && temps[i][tempDiff] <= 0)//check if temps were acquired
+	{//if temps were acquired for certain rooms, calculate their rate of change for that 
+	//flow rate.
+		//printf("in 2nd for loop.\n");
+		flowIndex = regFlow[i][1][sendingAF];//what index was used to set the regFlow.
+		if(rateOfChange[i][flowIndex] == 0.0 && flowIndex != 0)
+		{//if there is no rate of change data, we will fill its row with theoretical
+		//values from this real rate of change.
+			if(flowIndex == 10)
+			{
+				int endTime = rtTimerEnd(i,thermTimer);
+				printf("temps[%d][startDiff]: %d, endTime: %d\n",i,temps[i][startDiff],endTime);
+				rateOfChange[i][flowIndex] = runRate(i, endTime);
+				//printf("roc[%d][flowIndex]: %f\n",i,rateOfChange[i][flowIndex]);
+			}
+			else
+			{
+				int endTime = rtTimerEnd(i,thermTimer);
+				printf("endTime: %d\n",endTime);
+				rateOfChange[i][flowIndex] = runRate(i, endTime);
+				float modifier = (float)(flowIndex)/(float)(10);
+				rateOfChange[i][10] = (rateOfChange[i][flowIndex])/modifier;
+			}
+			rtTimes[i][thermTimer] = 0;//reset the timer for this room. 
+			printf("calculating theoretical RoC data:\n");
+			for(j = 1; j < COLUMN_COUNT; j++)
+			{
+				if(j != flowIndex && j != 10)
+				{
+					//printf("IM HERE!!!\n");
+					float modifier = (float)(j)/(float)(10);//get percentage to calculate theoretical rates.
+					rateOfChange[i][j] = rateOfChange[i][flowIndex]*modifier;
+				}
+				printf("rateOfChange[%d][%d]: %f\n",i,j,rateOfChange[i][j]);
+			}
+		}
+		else//if there is rate of change data.
+		{
+			rateOfChange[i][flowIndex] = runRate(i, rtTimerEnd(i,thermTimer));
+			rtTimes[i][thermTimer] = 0;
+		}
+		adjustReg(i, 0);//close the registers, the actuation task sends them.
+	}
+	else if(rtTimes[i][thermTimer] && temps[i][tempDiff] > 0)
+	{//if temps have not been reached (this might happen if the temp diff is == 1)
+		//we want to reach a temp difference = 0 to satisfy user expectations.
+		busy = 1;
+		printf("room: %d, still out of temp range\n", i);
+	}
+	else if(rtTimes[i][thermTimer] == 0 && temps[i][tempDiff] > 1)
+	{
+		rtTimerStart(i, thermTimer);
+		adjustReg(i, 10);
+		busy = 1;
+	}
+	voteSet(i, voteBusy, busy);
+	return busy;
+}
+
+/****************************************************************************************
+void hvacRelays(int cool, int fan, int heat)
+	Description: This function switches the hvac relays, 1 turns a relay on. The relays 
+	are active low. The watchdog thread calls it as well, so the three writes are made 
+	under relayLock. While the watchdog has tripped, nothing is turned on: the stuck 
+	cycle may still go on to start the hvac before the main loop gets to hvacTrip(). 
+****************************************************************************************/
+void hvacRelays(int cool, int fan, int heat)
+{
+	piLock(relayLock);
+	if(wdTripped)
+	{
+		cool = 0;
+		fan = 0;
+		heat = 0;
+	}
+	digitalWrite(COOL, !cool);
+	digitalWrite(FAN, !fan);
+	digitalWrite(HEAT, !heat);
+	piUnlock(relayLock);
+	return;
+}
+
+/****************************************************************************************
+void hvacStart(void)
+	Description: This function sizes a new hvac run. From each room's rate of change it 
+	finds the room that will take the longest and opens the registers of every other 
+	room that needs a temperature change just enough to reach its temperature at about 
+	the same time. The timer of each of those rooms is started. The registers are sent 
+	by the actuation task. 
+****************************************************************************************/
+void hvacStart(void)
+{
+	int i;
+	int j;
+	float maxTime = 0;
+	int maxTimeIndex = 0;
+	int regPerc = 10;
+	int onTime;
+	
+	for(i = 1; i <= devices[0][0]; i++)//calc maxTime the system should stay on
+	{
+		if(temps[i][tempDiff] > 1 && rateOfChange[i][10])
+		{
+			onTime = (temps[i][tempDiff]*60)/rateOfChange[i][10];
+			if(onTime>maxTime)
+			{
+				maxTimeIndex = i;																							
+				maxTime = onTime;
+			}
+		}
+	}//what happens if no therms have data? ================================
+	printf("maxTime: %f\n",maxTime);
+	if(hvacSetting == 1 || hvacSetting == 2 || hvacSetting == 0)//cooling, heating, auto
+	{
+		printf("hvac setting is 1, 2, or 0.\n");
+		for(i =1; i <= devices[0][0]; i++)//set registers i=room #
+		{
+			if(temps[i][tempDiff]>1)//if this room needs a temp change
+			{
+				printf("room: %d, needs a temp change.\n", i);
+				if(rateOfChange[i][10] == 0)
+				{//if no RoC data for that room
+					printf("room: %d, has no ROC data\n", i);
+					adjustReg(i,10); //adjust regesters for this room to 100 percent.
+					//start timer? =============================================
+				}
+				else//we have RoC data to use for this room.
+				{
+					printf("room: %d, has ROC data\n",i);
+					float timeLow;
+					float timeHigh;
+					
+					
+					for(j = 0; j < COLUMN_COUNT; j++)
+					{
+						timeLow = ((temps[i][tempDiff]*60)/rateOfChange[i][j]);
+						timeHigh = ((temps[i][tempDiff]*60)/rateOfChange[i][(j+1)]);
+						if(i == maxTimeIndex)
+						{
+							regPerc = 10;
+							break;
+						}
+						else if(timeLow >= maxTime && timeHigh <= maxTime)
+						{
+							printf("timeLow: %f\ntimeHigh: %f\nmaxTime: %f\n",timeLow, timeHigh, maxTime);
+							if(timeLow == maxTime || timeHigh == maxTime)
+							{
+								if(timeLow == maxTime)
+								{
+									regPerc = j;
+								}
+								else
+								{
+									regPerc = j+1;
+								}
+							}
+							else if((abs(maxTime - timeLow)) < (abs(timeHigh - maxTime)))
+							{
+								printf("using low index: %d\n", j);
+								//use low index (j)
+								regPerc = j;
+								break;
+							}
+							else 
+							{
+								printf("using high index: %d\n", (j+1));
+								//use high index (j+1)
+								regPerc = j+1;
+								if(regPerc > 10)
+								{
+									printf("regPerc out of range. = 10\n");
+									regPerc = 10;
+								}
+								
+								break;
+							}
+							
+						}
+					}
+					int tempval = regPerc;
+					printf("regesters in room: %d, using %d percent\n", i, tempval);
+					
+					//regPerc = 10;
+					
+					
+					adjustReg(i,regPerc);
+				}
+				rtTimerStart(i,thermTimer);	//start timer for this room which needs a temp change. 
+				markRoom(i);
+				temps[i][startDiff] = temps[i][tempDiff];
+				printf("started timer for room %d, start time: %u\n", i, rtTimes[i][thermTimer]);
+			}
+			
+		}
+	}
+	return;
+}
+
+/****************************************************************************************
+void hvacRun(void)
+	Description: This function turns on the relays for the hvac setting, or for the way 
+	auto decided to run. 
+****************************************************************************************/
+void hvacRun(void)
+{
+	if(hvacSetting == 0)//auto
+	{
+		printf("hvacSetting on auto.\n");
+		if(hvacAuto == 1)//heating
+		{
+			printf("auto will use heating\n");
+			hvacRelays(0, 1, 1);
+		}
+		else if(hvacAuto == 0)//cooling
+		{
+			printf("auto will use cooling\n");
+			hvacRelays(1, 1, 0);
+		}
+		else if(hvacAuto == -1)//fan
+		{
+			printf("auto will use fan\n");
+			hvacRelays(0, 1, 0);
+		}
+	}
+	else if(hvacSetting == 1)//cooling 
+	{
+		printf("hvacSetting on cooling.\n");
+		hvacRelays(1, 1, 0);
+	}
+	else if(hvacSetting == 2)//heating
+	{
+		printf("hvacSetting on heating.\n");
+		hvacRelays(0, 1, 1);
+	}
+	return;
+}
+
+/****************************************************************************************
+void hvacStop(void)
+	Description: This function ends a run before every room reached its temperature 
+	(the hvac setting changed). The rooms' timers are dropped without a rate of change 
+	being taken and their registers are closed. 
+****************************************************************************************/
+void hvacStop(void)
+{
+	int i;
+	
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		if(rtTimes[i][thermTimer])
+		{
+			rtTimes[i][thermTimer] = 0;
+			adjustReg(i, 0);
+		}
+		voteSet(i, voteBusy, 0);
+	}
+	return;
+}
+
+/****************************************************************************************
+void hvacEnter(int state)
+	Description: This function moves the hvac state machine to the given state and 
+	does what entering it takes, switching the relays at once. 
+		hvacOff: 		relays off. 
+		hvacStarting: 	the run is sized and the registers sent, relays still off. 
+		hvacConditioning: heating, cooling or fan for auto's stalemate, on. 
+		hvacSettling: 	relays off, the hvac rests hvacRest ms before it may start again. 
+		hvacFanOnly: 	fan on. 
+****************************************************************************************/
+void hvacEnter(int state)
+{
+	printf("hvac state: %s -> %s\n", hvacStateName[hvacState], hvacStateName[state]);
+	hvacState = state;
+	hvacSince = millis();
+	if(state == hvacOff || state == hvacSettling)
+	{
+		hvacRelays(0, 0, 0);
+		hvacStatus = 0;
+	}
+	else if(state == hvacStarting)
+	{
+		hvacStart();
+		hvacStatus = 1;
+		taskKick(taskActuate);//open the registers before the air is turned on.
+	}
+	else if(state == hvacConditioning)
+	{
+		hvacRun();
+	}
+	else if(state == hvacFanOnly)
+	{
+		hvacRelays(0, 1, 0);
+		hvacStatus = 1;
+	}
+	return;
+}
+
+/****************************************************************************************
+void hvacEvent(int event, int room)
+	Description: This function runs the hvac state machine for one event: 
+		hvacEvReading: 	a new reading from room, already in its vote (roomUpdate()). 
+		hvacEvTarget: 	room reached its temperature. 
+		hvacEvMode: 	the user changed the hvac setting. 
+		hvacEvFlows: 	setReg() finished sending the register flows. 
+		hvacEvTick: 	the control task's periodic check (hvacControl()). 
+	Transitions happen on the event that causes them, so the relays follow a reading 
+	or a setting change straight away. 
+****************************************************************************************/
+void hvacEvent(int event, int room)
+{
+	int next = 0;	//event that follows from this one.
+	int i;
+	int count;
+	int rooms[126];
+	
+	switch(hvacState)
+	{
+		case hvacOff:
+			if(hvacSetting == 3)
+			{
+				hvacEnter(hvacFanOnly);
+			}
+			else if(temps[0][hvacOut])
+			{
+				hvacEnter(hvacStarting);
+			}
+			break;
+			
+		case hvacStarting:
+			if(event == hvacEvMode)
+			{
+				hvacStop();
+				hvacEnter(hvacSettling);
+			}
+			else if((event == hvacEvFlows && !flowCount) || (millis() - hvacSince) >= hvacStartMax)
+			{
+				hvacEnter(hvacConditioning);//the registers are open, or will not all answer.
+			}
+			break;
+			
+		case hvacConditioning:
+			if(event == hvacEvMode)
+			{
+				hvacStop();
+				hvacEnter(hvacSettling);
+			}
+			else if(event == hvacEvReading && evalDirty[room])
+			{
+				if(!roomControl(room) && !rtTimes[room][thermTimer])
+				{
+					next = hvacEvTarget;
+				}
+			}
+			else if(event == hvacEvTick)
+			{
+				//only rooms whose readings or timers changed since they were last looked at.
+				count = evalCount;
+				for(i = 0; i < count; i++)
+				{
+					rooms[i] = evalList[i];
+				}
+				evalCount = 0;
+				for(i = 0; i < count; i++)
+				{
+					if(evalDirty[rooms[i]])
+					{
+						roomControl(rooms[i]);
+					}
+				}
+				next = hvacEvTarget;
+			}
+			else if(event == hvacEvTarget && !roomVote[0][voteBusy])
+			{
+				printf("every room reached its temperature.\n");
+				hvacEnter(hvacSettling);
+			}
+			break;
+			
+		case hvacSettling:
+			if(event == hvacEvMode && hvacSetting == 3)
+			{
+				hvacEnter(hvacFanOnly);//only the compressor and heat need the rest.
+			}
+			else if((millis() - hvacSince) >= hvacRest)
+			{
+				hvacEnter(hvacOff);
+				next = hvacEvTick;//start again now if a room needs it.
+			}
+			break;
+			
+		case hvacFanOnly:
+			if(hvacSetting != 3)
+			{
+				hvacEnter(hvacOff);
+				next = hvacEvTick;
+			}
+			break;
+	}
+	if(next)
+	{
+		hvacEvent(next, room);
+	}
+	return;
+}
+
+/****************************************************************************************
+void hvacControl(void)
+	Description: This function is run by the control task after calcDiff(). It lets the 
+	hvac state machine look at the rooms that changed, and handles what only the passing 
+	of time causes: the end of the rest after a run, or registers that never answered 
+	when a run started. A changed hvac setting is passed on as hvacEvMode. 
+****************************************************************************************/
+void hvacControl(void)
+{
+	if(hvacMode != hvacSetting)
+	{
+		hvacMode = hvacSetting;
+		hvacEvent(hvacEvMode, 0);
+	}
+	hvacEvent(hvacEvTick, 0);
+	return; 
+}
+
+/****************************************************************************************
+void hvacTrip(void)
+	Description: This function is called by the main loop after the watchdog turned the 
+	relays off during an overrunning cycle. A run that was going is ended as on a setting 
+	change and the hvac rests before it may start again; fan only is switched back on. 
+****************************************************************************************/
+void hvacTrip(void)
+{
+	if(hvacState == hvacStarting || hvacState == hvacConditioning)
+	{
+		hvacStop();
+		hvacEnter(hvacSettling);
+	}
+	else if(hvacState == hvacFanOnly)
+	{
+		hvacEnter(hvacFanOnly);
+	}
+	return;
+}
+
+/****************************************************************************************
+void adjustReg(int i, int flowIndex)
+	Description: this function adjusts all registers in a room to a specific flow rate.
+****************************************************************************************/
+void adjustReg(int i, int flowIndex)
+{
+	int j;
+	if(regFlow[i][0][sendingAF] != flowIndex)
+	{
+		pollSoon(i);//follow the room closely while its flow changes.
+		markFlow(i);
+		if(!flowTimed[i])
+		{
+			flowTimed[i] = 1;//timed from the first change flowActed() has not seen through.
+			flowAt[i] = millis();
+		}
+	}
+	for(j = 0; j <= devices[0][i]; j++)
+	{
+		regFlow[i][j][sendingAF] = flowIndex;
+	}
+	return;
+}
+
+/****************************************************************************************
+void updateRoutes(void)
+	Description: This function rebuilds the relay routing table in messaging.c from 
+	devices[][]. Each register's parent is its room's thermostat, which is mains powered 
+	and usually closer to the register than the MC, if it reported capRelay during 
+	pairing. sendRouted() only relays through the parent when relayMode is set and the 
+	direct link is losing frames. 
+****************************************************************************************/
+void updateRoutes(void)
+{
+	int i;
+	int j;
+	unsigned char parent[256] = {0};
+	
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		if(!(linkCaps(devices[i][0]) & capRelay))
+		{
+			continue;//this thermostat cannot forward frames.
+		}
+		for(j = 1; j <= devices[0][i]; j++)
+		{
+			parent[devices[i][j]] = devices[i][0];
+		}
+	}
+	//registers that are no longer synced lose their parent.
+	for(i = 1; i < 256; i++)
+	{
+		setParent(i, parent[i]);
+	}
+	return;
+}
+
+/****************************************************************************************
+int fleetCaps(void)
+	Description: This function returns the capabilities every synced device shares with 
+	the MC. Broadcasts that every device has to understand, like SLEEP_UNTIL and 
+	TIME_BEACON, are only sent when the whole fleet supports them. 
+****************************************************************************************/
+int fleetCaps(void)
+{
+	int i;
+	int j;
+	int caps = protoCaps;
+	
+	for(i = 1; i <= devices[0][0]; i++)
+	{
+		for(j = 0; j <= devices[0][i]; j++)
+		{
+			caps = caps & linkCaps(devices[i][j]);
+		}
+	}
+	return caps;
+}
+
+/****************************************************************************************
+void pushGroup(int room)
+	Description: This function sends every register in a room its group address, which 
+	is the address of the room's thermostat, along with the register's ACK slot. Once 
+	every register has acknowledged, setReg() can set the whole room with one frame. 
+	The messages are queued as user actions, so the room is not grouped until 
+	queueDone() has seen every register's ACK. Rooms with a register that did not 
+	report capGroup during pairing are never grouped. 
+****************************************************************************************/
+void pushGroup(int room)
+{
+	int j;
+	
+	roomGrouped[room] = 0;//registers keep getting SET_FLOW until they all have the group.
+	for(j = 1; j <= devices[0][room]; j++)
+	{
+		regGrouped[room][j] = 0;
+		if(!(linkCaps(devices[room][j]) & capGroup))
+		{
+			continue;//an older register in the room only takes SET_FLOW.
+		}
+		queueMessage(prioUser, SET_GROUP, devices[room][j], devices[room][0], j-1);
+	}
+	return;
+}
+
+/****************************************************************************************
+void updateStatus(void)
+	Description: This funciton checks the current status of errors and warnings and 
+	displays the status to the user on the lcd home screen. 
+****************************************************************************************/
+void updateStatus(void)
+{
+	if(conStatus)
+	{
+		conStatus = 0;
+		display(page, line, set);
+	}
+
+	return;
+}
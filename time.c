@@ -1,248 +1,858 @@
-/****************************************************************************************
-time.c
-	by group 2: Raul Rojas, Christa McDaniel, Alex Fotso
-	
-	Objective: 
-	This file is meant to handle all functions which are time related for the Master 
-	Controller. The functions here provide the needed functionality for the system 
-	to keep up with current time and also provide some time related functions to the 
-	system for background computation purposes. 
-	
-	Functions:
-	getSec()
-	initTimeArr()
-	updateTime()
-	parseTime()
-	rtTimerStart()
-	rtTimerEnd()
-	
-****************************************************************************************/
-
-#include <wiringPi.h>
-#include <lcd.h>
-#include <stdio.h>
-#include <mcp23017.h>
-#include <time.h>
-#include "finalHeader.h"
-
-int seconds;
-int timeFlag = 0;
-extern int page;
-
-/****************************************************************************************
-int getSec(void)
-	Description: This function returns the current seconds from the time struct created 
-	by time_t provided by <time.h>. the function first retrieves the epoch time, then 
-	formats it into a structure containing hours, minutes, seconds, etc. This function 
-	only retrieves the seconds. 
-****************************************************************************************/
-int getSec(void)
-{
-	time_t rawtime;
-	struct tm *timestruct;
-	
-	time(&rawtime);	//retrieve epoch time. 
-	timestruct = gmtime(&rawtime);	//organize epoch time into a struct
-	seconds = timestruct->tm_sec;	//retrieve only the seconds of the struct.
-	
-	return seconds;
-}
-
-/****************************************************************************************
-void initTimeArr()
-	Description: This function initializes the array mcClock[3] which is created in the
-	global variables. This funciton will be used to keep track of real time.
-	It fills the array with predefined values (most likely 0's but these values can be 
-	changed for testing pursposes.)
-****************************************************************************************/
-int mcClock[4];	//array to store time. [hour(0) | minute(1) | seconds(2) | am/pm(3]
-
-/****************************************************************************************
-void initTimeArr()
-	Description: This function initializes the array, which will contain the values 
-	of the MC's real time clock, into a known state.
-****************************************************************************************/
-void initTimeArr()
-{
-	int i;
-	for(i=0;i<3;i++)
-	{
-		if(i==0)
-			mcClock[i] = 12;
-		else
-			mcClock[i] = 59;
-	}
-	mcClock[arrAP] = 0;
-	return;
-}
-
-/****************************************************************************************
-void updateTime(void)
-	Description: This function provides a quick single iteration method of updating the 
-	real time clock. It retrieves and compares the seconds count from getSec() function 
-	with the value stored in the seconds index in the array mcClock[]. If this value 
-	is equal to 0, than the minutes need to be incrimented. However, it only does this if
-	the value retrieved from getSec() is not equal to the stored seconds. This is done
-	so that it only incraments the minutes once. once the minute count re
-****************************************************************************************/
-void updateTime(void)
-{	
-	if(page == 4)//if we are setting the time, do not adjust time values 
-	{
-		return;
-	}
-	int currSec = getSec();//retrieve the current epoch seconds.
-	if(currSec == 0 && currSec != mcClock[arrSec])
-	{//if the seconds make a transition from 59 to 0 then the minute must be adjusted. 
-		
-		if(mcClock[arrMin] == 59)
-		{//if the minute makes a transition from 59 to 0, the hour must be adjusted
-			timeFlag = 1;//This flag signals that the lcd needs to be updated to reflect the new time. 
-			mcClock[arrMin] = 0;//reset minutes back to 0 if we incrimented from minute 59.
-			if(mcClock[arrHr] == 12)
-			{//if the hour is 12 we need to reset it back to 1 like in standard time. 
-				mcClock[arrHr] = 1;
-				
-			}
-			else//just incriment the hour if it is not 12. 
-			{
-				mcClock[arrHr]++;
-				if(currSec == 0 && currSec != mcClock[arrSec] && mcClock[arrHr] == 12)
-				{//if we are at hour 12 for the first time we need to adjust the am/pm setting.
-					mcClock[arrAP] = (mcClock[arrAP]+1)%2;
-				}
-			}
-		}
-		else//if the minute is not 59 then just increment it.
-		{
-			timeFlag = 1;//Flag which signals that the lcd needs to be updated to reflect the new time. 
-			mcClock[arrMin]++;
-		}
-		mcClock[arrSec] = currSec;//store the returned seconds from epoch time. 
-	}
-	else
-	{
-		mcClock[arrSec] = currSec;
-	}
-	
-	
-	//parseTime();
-	if(timeFlag && page == 0)//if the time changes (hour and/or minute) the lcd needs to be updated.
-	{
-		dispTime();
-		timeFlag = 0;
-	}
-	//printf("Current Time: %d:%d.%d %d\n", mcClock[arrHr], mcClock[arrMin], mcClock[arrSec], mcClock[arrAP]);
-	return;
-}
-
-/****************************************************************************************
-void parseTime(void)
-	Description: This function parses the hour and minute into individual single digit 
-	values so that they may be used for other conditions if necessary or to display 
-	the time as independant digits. 
-****************************************************************************************/
-int parsedTime[4];
-void parseTime(void)
-{
-	int hr = mcClock[arrHr];//get the current MC time.
-	int min = mcClock[arrMin];//get the current MC time. 
-	int hrT;
-	int hrO;
-	int minT;
-	int minO;
-	
-	if(hr >= 10)//if the hour is a double digit number.
-	{
-		hrT = 1;//store the tenths place.
-		hrO = hr % 10;//retrieve the one's place.
-	}
-	else//the hour is a single digit number. 
-	{
-		hrT = 0;//store the tenths place
-		hrO = hr;//store the one's place. 
-	}
-	
-	if(min >= 10)//if the minute is a double digit number. 
-	{
-		minT = min/10;//devide the minutes by ten to get the tenths place.
-		minO = min%10;//retrieve the one's place of the minute. 
-	}
-	else//the minute is a single digit number. 
-	{
-		minT = 0;//store the tenth's place.
-		minO = min;//store the one's place. 
-	}
-	
-	//store the parsed time. 
-	parsedTime[0] = hrT;
-	parsedTime[1] = hrO;
-	parsedTime[2] = minT;
-	parsedTime[3] = minO;
-	
-	//printf("mcClock hr: %d\n\n", mcClock[arrHr]);
-	printf("Parsed Time: %d%d:%d%d\n",parsedTime[0],parsedTime[1],parsedTime[2],parsedTime[3]);
-	
-	return;
-}
-
-/****************************************************************************************
-void rtTimerStart(int timerNum, int timerType)
-	Description: This function stores the current time into an array in total seconds
-	which will be used to determine the time passed (in real time) when the timer is 
-	stopped. 
-****************************************************************************************/
-int rtTimes[126][2];//column 1 is for thermostat timers, column 2 are for anything else.
-void rtTimerStart(int timerNum, int timerType)
-{
-	int startSec;
-	/*
-	rtTimes[0] = mcClock[arrHr];
-	rtTimes[1] = mcClock[arrMin];
-	rtTimes[2] = mcClock[arrSec];
-	rtTimes[3] = mcClock[arrAP];
-	*/
-	
-	//calculating the start time. 
-	startSec = (mcClock[arrHr]*3600)+(mcClock[arrMin]*60)+mcClock[arrSec];
-	if(mcClock[arrAP])
-	{//if the time of day is PM then add appropriate seconds. 
-		startSec = startSec + (mcClock[arrHr]*12);
-	}
-	rtTimes[timerNum][timerType] = startSec;//store the start time. 
-	return;
-}
-
-/****************************************************************************************
-int rtTimerEnd(int timerNum, int timerType)
-	Description: This function ends a timer. It takes the start time which was stored 
-	in the rtTimerStart() function and calculates how much time has passed since then. 
-	The array which contains the timers supports two types of timers, one for the 
-	temperature rate of changes, and the other for miscellaneous use. 
-****************************************************************************************/
-int rtTimerEnd(int timerNum, int timerType)
-{
-	int startSec;
-	int endSec;
-	int resultSec;
-	//3600 seconds in one hour.
-	startSec = rtTimes[timerNum][timerType];//retrieve the start time for this timer.
-	
-	endSec = (mcClock[arrHr]*3600)+(mcClock[arrMin]*60)+mcClock[arrSec];//calculate current time in seconds.  
-	if(mcClock[arrAP])//if the hour is passed 12, add 12 hours worth of seconds to the end time. 
-	{
-		endSec = endSec + (mcClock[arrHr]*12);
-	}
-	
-	//determine elapsed time. 
-	if(endSec > startSec)
-	{
-		resultSec = endSec-startSec;
-	}
-	else
-	{
-		resultSec = startSec - endSec;
-	}
-	//rtTimes[timerNum][timerType] = 0;//reset the timer to 0; 
-	return resultSec;
-}
\ No newline at end of file
+/****************************************************************************************
+time.c
+	by group 2: Raul Rojas, Christa McDaniel, Alex Fotso
+	
+	Objective: 
+	This file is meant to handle all functions which are time related for the Master 
+	Controller. The functions here provide the needed functionality for the system 
+	to keep up with current time and also provide some time related functions to the 
+	system for background computation purposes. 
+	
+	Functions:
+	getSec()
+	initTimeArr()
+	updateTime()
+	parseTime()
+	rtTimerStart()
+	rtTimerEnd()
+	taskInit()
+	taskDue()
+	taskStart()
+	taskKick()
+	taskLeft()
+	taskWait()
+	printTaskStats()
+	phaseBucket()
+	phaseBegin()
+	phaseEnd()
+	phasePct()
+	printPhaseStats()
+	wdCycle()
+	watchdog()
+	radioInit()
+	radioTake()
+	radioGive()
+	radioYield()
+	radioPass()
+	radioNap()
+	radioIrqISR()
+	initTasks()
+	mainCycle()
+	
+****************************************************************************************/
+
+#include <wiringPi.h>
+#include <lcd.h>
+#include <stdio.h>
+#include <mcp23017.h>
+#include <time.h>
+#include <pthread.h>
+#include "finalHeader.h"
+#include "messaging.h"
+#include "clockWait.h"
+
+int seconds;
+int timeFlag = 0;
+extern int page;
+
+//main loop scheduler, indexed by task (taskControl..taskStats).
+unsigned int taskPeriod[taskCount];	//ms between runs.
+unsigned int taskDeadline[taskCount];	//ms a run may start after it is due before it counts as missed.
+unsigned int taskNext[taskCount];	//millis() the task is next due.
+int taskRuns[taskCount];
+int taskMisses[taskCount];
+unsigned int taskWorst[taskCount];	//worst ms a run started after it was due.
+char *taskName[taskCount] = {"control", "actuate", "ui", "sync", "stats"};
+
+//latency histograms of the control cycle's phases, indexed by phase (phasePoll..phaseDisplay).
+unsigned int phaseHist[phaseCount][phaseBuckets];
+unsigned int phaseRuns[phaseCount];
+unsigned int phaseMax[phaseCount];	//longest run in us.
+char *phaseName[phaseCount + 1] = {"poll", "diff", "hvac", "setReg", "display", "other"};
+
+//control loop watchdog, see watchdog().
+volatile unsigned int wdStart;	//millis() the current main loop cycle started.
+volatile int wdPhase = phaseOther;	//phase the main loop is in.
+volatile int wdTripped = 0;	//1 once the current cycle overran, until the main loop has seen it.
+volatile int wdFlagged = 0;	//1 if the current cycle was counted as an overrun.
+int wdOverruns = 0;
+int wdPhaseMiss[phaseCount + 1];	//overruns by the phase the main loop was in.
+int wdLastPhase = phaseOther;
+unsigned int wdLastMs = 0;	//length of the last overrunning cycle.
+
+//radio handoff from the main loop to the menu thread, see radioTake().
+pthread_mutex_t radioMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t radioCond;	//set up by radioInit().
+volatile int radioWanted = 0;	//1 while the menu thread wants or holds the radio.
+volatile int radioHeld = 0;	//1 while the menu thread holds the radio and the main loop is parked.
+volatile int radioIrq = 0;	//1 once the nRF24L01 IRQ fell since the last radioNap().
+volatile unsigned int radioAskedAt;	//micros() the menu thread asked for the radio.
+unsigned int radioParked = 0;	//us the main loop has spent parked for the menu.
+unsigned int phaseParked;	//radioParked as the current main loop phase began.
+unsigned int handoffRuns = 0;
+unsigned int handoffLast = 0;	//us from the menu's request to the main loop handing the radio over.
+unsigned int handoffMax = 0;
+unsigned long long handoffTotal = 0;
+extern int dutyMode;
+extern int beaconInterval;
+
+/****************************************************************************************
+int getSec(void)
+	Description: This function returns the seconds count of millis(). All the MC's time 
+	is kept with the wiringPi time functions, delay() and millis(), so the clock on the 
+	LCD runs on the same clock as everything else: the Raspberry Pi's, or the virtual 
+	clock of the bench when the code is built on a host. 
+****************************************************************************************/
+int getSec(void)
+{
+	seconds = (millis() / 1000) % 60;
+	
+	return seconds;
+}
+
+/****************************************************************************************
+void initTimeArr()
+	Description: This function initializes the array mcClock[3] which is created in the
+	global variables. This funciton will be used to keep track of real time.
+	It fills the array with predefined values (most likely 0's but these values can be 
+	changed for testing pursposes.)
+****************************************************************************************/
+int mcClock[4];	//array to store time. [hour(0) | minute(1) | seconds(2) | am/pm(3]
+
+/****************************************************************************************
+void initTimeArr()
+	Description: This function initializes the array, which will contain the values 
+	of the MC's real time clock, into a known state.
+****************************************************************************************/
+void initTimeArr()
+{
+	int i;
+	for(i=0;i<3;i++)
+	{
+		if(i==0)
+			mcClock[i] = 12;
+		else
+			mcClock[i] = 59;
+	}
+	mcClock[arrAP] = 0;
+	return;
+}
+
+/****************************************************************************************
+void updateTime(void)
+	Description: This function provides a quick single iteration method of updating the 
+	real time clock. It counts every second that passed on millis() since it was last 
+	called into the seconds index in the array mcClock[]. When the seconds make a 
+	transition from 59 to 0, the minutes need to be incrimented. The seconds are 
+	counted one at a time so no minute is missed however late the function is called, 
+	which matters on the virtual clock where a delay() can jump far ahead. 
+****************************************************************************************/
+unsigned int secLast = 0;	//millis() of the last second counted into mcClock[].
+void updateTime(void)
+{	
+	unsigned int now = millis();
+	
+	if(page == 4)//if we are setting the time, do not adjust time values 
+	{
+		secLast = now;
+		return;
+	}
+	while((now - secLast) >= 1000)//count each second since the last call.
+	{
+		secLast += 1000;
+		mcClock[arrSec]++;
+		if(mcClock[arrSec] < 60)
+		{
+			continue;
+		}
+		//if the seconds make a transition from 59 to 0 then the minute must be adjusted. 
+		mcClock[arrSec] = 0;
+		timeFlag = 1;//This flag signals that the lcd needs to be updated to reflect the new time. 
+		if(mcClock[arrMin] == 59)
+		{//if the minute makes a transition from 59 to 0, the hour must be adjusted
+			mcClock[arrMin] = 0;//reset minutes back to 0 if we incrimented from minute 59.
+			if(mcClock[arrHr] == 12)
+			{//if the hour is 12 we need to reset it back to 1 like in standard time. 
+				mcClock[arrHr] = 1;
+			}
+			else//just incriment the hour if it is not 12. 
+			{
+				mcClock[arrHr]++;
+				if(mcClock[arrHr] == 12)
+				{//if we are at hour 12 for the first time we need to adjust the am/pm setting.
+					mcClock[arrAP] = (mcClock[arrAP]+1)%2;
+				}
+			}
+		}
+		else//if the minute is not 59 then just increment it.
+		{
+			mcClock[arrMin]++;
+		}
+	}
+	
+	
+	//parseTime();
+	if(timeFlag && page == 0)//if the time changes (hour and/or minute) the lcd needs to be updated.
+	{
+		dispTime();
+		timeFlag = 0;
+	}
+	//printf("Current Time: %d:%d.%d %d\n", mcClock[arrHr], mcClock[arrMin], mcClock[arrSec], mcClock[arrAP]);
+	return;
+}
+
+/****************************************************************************************
+void parseTime(void)
+	Description: This function parses the hour and minute into individual single digit 
+	values so that they may be used for other conditions if necessary or to display 
+	the time as independant digits. 
+****************************************************************************************/
+int parsedTime[4];
+void parseTime(void)
+{
+	int hr = mcClock[arrHr];//get the current MC time.
+	int min = mcClock[arrMin];//get the current MC time. 
+	int hrT;
+	int hrO;
+	int minT;
+	int minO;
+	
+	if(hr >= 10)//if the hour is a double digit number.
+	{
+		hrT = 1;//store the tenths place.
+		hrO = hr % 10;//retrieve the one's place.
+	}
+	else//the hour is a single digit number. 
+	{
+		hrT = 0;//store the tenths place
+		hrO = hr;//store the one's place. 
+	}
+	
+	if(min >= 10)//if the minute is a double digit number. 
+	{
+		minT = min/10;//devide the minutes by ten to get the tenths place.
+		minO = min%10;//retrieve the one's place of the minute. 
+	}
+	else//the minute is a single digit number. 
+	{
+		minT = 0;//store the tenth's place.
+		minO = min;//store the one's place. 
+	}
+	
+	//store the parsed time. 
+	parsedTime[0] = hrT;
+	parsedTime[1] = hrO;
+	parsedTime[2] = minT;
+	parsedTime[3] = minO;
+	
+	//printf("mcClock hr: %d\n\n", mcClock[arrHr]);
+	printf("Parsed Time: %d%d:%d%d\n",parsedTime[0],parsedTime[1],parsedTime[2],parsedTime[3]);
+	
+	return;
+}
+
+/****************************************************************************************
+void rtTimerStart(int timerNum, int timerType)
+	Description: This function stores the current millis() into an array which will be 
+	used to determine the time passed (in real time) when the timer is stopped. 
+	millis() is used rather than the time of day in mcClock[] so a timer running over 
+	midnight, or while the user sets the time, still measures what really passed. 
+****************************************************************************************/
+unsigned int rtTimes[126][2];//column 1 is for thermostat timers, column 2 are for anything else.
+void rtTimerStart(int timerNum, int timerType)
+{
+	rtTimes[timerNum][timerType] = millis();//store the start time. 
+	if(rtTimes[timerNum][timerType] == 0)
+	{
+		rtTimes[timerNum][timerType] = 1;//0 is kept for a timer that is not running.
+	}
+	return;
+}
+
+/****************************************************************************************
+int rtTimerEnd(int timerNum, int timerType)
+	Description: This function ends a timer. It takes the start time which was stored 
+	in the rtTimerStart() function and returns how many seconds have passed since then. 
+	The array which contains the timers supports two types of timers, one for the 
+	temperature rate of changes, and the other for miscellaneous use. 
+****************************************************************************************/
+int rtTimerEnd(int timerNum, int timerType)
+{
+	return (int)((millis() - rtTimes[timerNum][timerType]) / 1000);
+}
+
+/****************************************************************************************
+void taskInit(int task, unsigned int period, unsigned int deadline)
+	Description: This function sets a main loop task's period and deadline. The task is 
+	first due one period from now, so the rooms are polled before anything is decided. 
+****************************************************************************************/
+void taskInit(int task, unsigned int period, unsigned int deadline)
+{
+	taskPeriod[task] = period;
+	taskDeadline[task] = deadline;
+	taskNext[task] = millis() + period;
+	taskRuns[task] = 0;
+	taskMisses[task] = 0;
+	taskWorst[task] = 0;
+	return;
+}
+
+/****************************************************************************************
+int taskDue(int task, unsigned int now)
+	Description: This function returns 1 if the task is due at the given time. 
+****************************************************************************************/
+int taskDue(int task, unsigned int now)
+{
+	return ((int)(now - taskNext[task]) >= 0);
+}
+
+/****************************************************************************************
+void taskStart(int task, unsigned int now)
+	Description: This function is called as a due task starts. It counts the run, and a 
+	missed deadline if the run started too late, then moves the due time on by whole 
+	periods so the task keeps its phase. Periods that were missed entirely are skipped 
+	rather than run back to back. 
+****************************************************************************************/
+void taskStart(int task, unsigned int now)
+{
+	unsigned int late = now - taskNext[task];
+	
+	taskRuns[task]++;
+	if(late > taskDeadline[task])
+	{
+		taskMisses[task]++;
+	}
+	if(late > taskWorst[task])
+	{
+		taskWorst[task] = late;
+	}
+	while((int)(now - taskNext[task]) >= 0)
+	{
+		taskNext[task] += taskPeriod[task];
+	}
+	return;
+}
+
+/****************************************************************************************
+void taskKick(int task)
+	Description: This function makes a task due now, for work another task has just 
+	produced (new flows for the actuation task). 
+****************************************************************************************/
+void taskKick(int task)
+{
+	taskNext[task] = millis();
+	return;
+}
+
+/****************************************************************************************
+int taskLeft(int task, unsigned int now)
+	Description: This function returns the ms until the task is due, 0 if it is due. 
+****************************************************************************************/
+int taskLeft(int task, unsigned int now)
+{
+	int left = (int)(taskNext[task] - now);
+	
+	return (left > 0) ? left : 0;
+}
+
+/****************************************************************************************
+int taskWait(unsigned int now)
+	Description: This function returns the ms until the next task is due, 0 if one is 
+	due already. 
+****************************************************************************************/
+int taskWait(unsigned int now)
+{
+	int i;
+	int left;
+	int wait = taskLeft(0, now);
+	
+	for(i = 1; i < taskCount; i++)
+	{
+		left = taskLeft(i, now);
+		if(left < wait)
+		{
+			wait = left;
+		}
+	}
+	return wait;
+}
+
+/****************************************************************************************
+void printTaskStats(void)
+	Description: This function prints the runs, missed deadlines and worst start delay 
+	of every main loop task. 
+****************************************************************************************/
+void printTaskStats(void)
+{
+	int i;
+	
+	printf("\nTasks: name | period ms | deadline ms | runs | missed | worst start delay ms\n");
+	for(i = 0; i < taskCount; i++)
+	{
+		printf("  %s | %u | %u | %d | %d | %u\n", taskName[i], taskPeriod[i], taskDeadline[i], taskRuns[i], taskMisses[i], taskWorst[i]);
+	}
+	printf("Cycle overruns (over %d ms): %d, last in %s taking %u ms\n", wdDeadline, wdOverruns, phaseName[wdLastPhase], wdLastMs);
+	for(i = 0; i <= phaseOther; i++)
+	{
+		if(wdPhaseMiss[i])
+		{
+			printf("  in %s: %d\n", phaseName[i], wdPhaseMiss[i]);
+		}
+	}
+	pthread_mutex_lock(&radioMutex);
+	printf("Radio handoffs to the menu: %u, last %u us, mean %u us, worst %u us\n", handoffRuns, handoffLast, handoffRuns ? (unsigned int)(handoffTotal / handoffRuns) : 0, handoffMax);
+	pthread_mutex_unlock(&radioMutex);
+	return;
+}
+
+/****************************************************************************************
+int phaseBucket(unsigned int us)
+	Description: This function returns the histogram bucket of a duration. Below 4us 
+	each us has its own bucket; above, every doubling is split into 4 buckets, so a 
+	bucket is at most 25% wide whatever the duration. 
+****************************************************************************************/
+int phaseBucket(unsigned int us)
+{
+	int e = 2;
+	int b;
+	
+	if(us < 4)
+	{
+		return us;
+	}
+	while(e < 31 && (us >> (e + 1)) != 0)
+	{
+		e++;
+	}
+	b = (4 * (e - 1)) + ((us >> (e - 2)) & 3);
+	return (b < phaseBuckets) ? b : phaseBuckets - 1;
+}
+
+/****************************************************************************************
+unsigned int phaseBegin(int phase)
+	Description: This function is called by the main loop as a timed phase starts. It 
+	tells the watchdog which phase the loop is in and returns micros() for phaseEnd(). 
+	The display thread times its phase with micros() itself. 
+****************************************************************************************/
+unsigned int phaseBegin(int phase)
+{
+	wdPhase = phase;
+	phaseParked = radioParked;
+	return micros();
+}
+
+/****************************************************************************************
+void phaseEnd(int phase, unsigned int start)
+	Description: This function records a run of a control cycle phase that started at 
+	the given micros(). It only adds to a bucket, so it is cheap enough to leave on. 
+	Time the main loop spent parked in radioPass() during the phase is left out. 
+****************************************************************************************/
+void phaseEnd(int phase, unsigned int start)
+{
+	unsigned int us = micros() - start;
+	
+	if(wdPhase == phase)
+	{
+		us -= radioParked - phaseParked;
+	}
+	phaseHist[phase][phaseBucket(us)]++;
+	phaseRuns[phase]++;
+	if(us > phaseMax[phase])
+	{
+		phaseMax[phase] = us;
+	}
+	if(wdPhase == phase)
+	{
+		wdPhase = phaseOther;
+	}
+	return;
+}
+
+/****************************************************************************************
+unsigned int phasePct(int phase, int pct)
+	Description: This function returns the given percentile of a phase's run time in us, 
+	as the top of the bucket it falls in, but no more than the longest run. 
+****************************************************************************************/
+unsigned int phasePct(int phase, int pct)
+{
+	int b;
+	int e;
+	unsigned int top;
+	unsigned int seen = 0;
+	unsigned int want = ((phaseRuns[phase] * (unsigned long long)pct) + 99) / 100;
+	
+	if(!phaseRuns[phase])
+	{
+		return 0;
+	}
+	for(b = 0; b < phaseBuckets - 1; b++)
+	{
+		seen += phaseHist[phase][b];
+		if(seen >= want)
+		{
+			break;
+		}
+	}
+	if(b < 4)
+	{
+		top = b + 1;
+	}
+	else
+	{
+		e = (b / 4) + 1;
+		top = (unsigned int)(5 + (b % 4)) << (e - 2);
+	}
+	return (top < phaseMax[phase]) ? top : phaseMax[phase];
+}
+
+/****************************************************************************************
+void printPhaseStats(void)
+	Description: This function prints the run count and the p50, p95, p99 and longest 
+	run time of each control cycle phase since boot. 
+****************************************************************************************/
+void printPhaseStats(void)
+{
+	int i;
+	
+	printf("\nPhases: name | runs | p50 ms | p95 ms | p99 ms | max ms\n");
+	for(i = 0; i < phaseCount; i++)
+	{
+		printf("  %s | %u | %.1f | %.1f | %.1f | %.1f\n", phaseName[i], phaseRuns[i], phasePct(i, 50) / 1000.0, 
+		phasePct(i, 95) / 1000.0, phasePct(i, 99) / 1000.0, phaseMax[i] / 1000.0);
+	}
+	return;
+}
+
+/****************************************************************************************
+void wdCycle(void)
+	Description: This function is called by the main loop as each cycle starts, and 
+	once it gets the radio back from the menu. It tells the watchdog the loop is alive 
+	and records how long the last cycle took if it overran. 
+****************************************************************************************/
+void wdCycle(void)
+{
+	unsigned int now = millis();
+	
+	if(wdFlagged)
+	{
+		wdLastMs = now - wdStart;
+		printf("watchdog: the overrunning cycle took %u ms.\n", wdLastMs);
+		wdFlagged = 0;
+	}
+	wdStart = now;
+	wdPhase = phaseOther;
+	return;
+}
+
+/****************************************************************************************
+void watchdog(void)
+	Description: This function is run every wdCheck ms by the watchdog thread. If the 
+	main loop's cycle has gone on for more than wdDeadline ms, a thermostat or register 
+	that stopped answering is most likely holding it in the radio code, and the hvac 
+	would stay in whatever state it was last set to. The overrun is counted against the 
+	phase the loop is in, and the heating and cooling are turned off at once; the main 
+	loop ends the run properly through hvacTrip() once it gets going again. wdTripped is 
+	set first, so hvacRelays() keeps the relays off until then. 
+****************************************************************************************/
+void watchdog(void)
+{
+	if(wdFlagged || radioHeld || (millis() - wdStart) <= wdDeadline)
+	{
+		return;
+	}
+	wdFlagged = 1;
+	wdOverruns++;
+	wdLastPhase = wdPhase;
+	wdPhaseMiss[wdLastPhase]++;
+	printf("watchdog: main loop cycle overran in %s, turning the hvac off.\n", phaseName[wdLastPhase]);
+	wdTripped = 1;
+	hvacRelays(0, 0, 0);
+	return;
+}
+
+/****************************************************************************************
+void radioInit(void)
+	Description: This function sets up radioCond before the menu thread is started. On 
+	the Pi its timed waits run on CLOCK_MONOTONIC, so radioNap() is not stretched or cut 
+	short when the system time is set. If the nRF24L01 IRQ is wired (RFIRQ), 
+	radioIrqISR() is installed on it. 
+****************************************************************************************/
+void radioInit(void)
+{
+	clockCondInit(&radioCond);
+	if(RFIRQ >= 0 && wiringPiISR(RFIRQ, INT_EDGE_FALLING, &radioIrqISR) < 0)
+	{
+		printf("radio IRQ interrupt failed, radioNap() sleeps its full time.\n");
+	}
+	return;
+}
+
+/****************************************************************************************
+void radioTake(void)
+	Description: This function is called by the menu thread before it adds or removes 
+	devices, which needs the radio and the devices[][] topology to itself. It asks the 
+	main loop for the radio and sleeps until the main loop has parked at a safe point in 
+	radioYield(). The main loop is woken at once if it is idle in radioNap(); if it is 
+	sending, it parks in radioPass() after the exchange in progress; polls, hvac and 
+	the other tasks are only left at the start of the next cycle. 
+****************************************************************************************/
+void radioTake(void)
+{
+	pthread_mutex_lock(&radioMutex);
+	radioAskedAt = micros();
+	radioWanted = 1;
+	clockWake(&radioCond);
+	while(!radioHeld)
+	{
+		clockWait(&radioCond, &radioMutex, clockForever);
+	}
+	pthread_mutex_unlock(&radioMutex);
+	return;
+}
+
+/****************************************************************************************
+void radioGive(void)
+	Description: This function is called by the menu thread once it is done with the 
+	radio. It wakes the main loop, which carries on from where it parked. 
+****************************************************************************************/
+void radioGive(void)
+{
+	pthread_mutex_lock(&radioMutex);
+	radioWanted = 0;
+	radioHeld = 0;
+	clockWake(&radioCond);
+	pthread_mutex_unlock(&radioMutex);
+	return;
+}
+
+/****************************************************************************************
+int radioYield(void)
+	Description: This function is called by the main loop at the start of each cycle, 
+	where it does not hold the radio or the devices[][] topology, and through 
+	radioPass() between exchanges. If the menu thread asked for the radio, it is handed 
+	over and the main loop sleeps until radioGive(). The time from the request to the 
+	handoff is recorded for printTaskStats(). The waits go through the clock backend, so 
+	the bench runs this same handoff against its stand-in for the menu. Returns 1 if the 
+	radio was handed over. 
+****************************************************************************************/
+int radioYield(void)
+{
+	unsigned int parked;
+	
+	if(!radioWanted)
+	{
+		return 0;
+	}
+	pthread_mutex_lock(&radioMutex);
+	if(!radioWanted)
+	{
+		pthread_mutex_unlock(&radioMutex);
+		return 0;
+	}
+	parked = micros();
+	handoffLast = parked - radioAskedAt;
+	handoffRuns++;
+	handoffTotal += handoffLast;
+	if(handoffLast > handoffMax)
+	{
+		handoffMax = handoffLast;
+	}
+	printf("MAIN HALTED.\n");
+	radioHeld = 1;
+	clockWake(&radioCond);
+	while(radioHeld)
+	{
+		clockWait(&radioCond, &radioMutex, clockForever);
+	}
+	radioParked += micros() - parked;
+	pthread_mutex_unlock(&radioMutex);
+	return 1;
+}
+
+/****************************************************************************************
+int radioPass(void)
+	Description: This function is called by the main loop between radio exchanges in 
+	the middle of its work: by sendQueue() after each frame, and by setReg() and 
+	collectSyncStats() between devices. The menu thread so waits for the radio no 
+	longer than one exchange. The menu may change devices[][] while it has the radio, 
+	so no caller may hold a row or column index across the call: queued messages are 
+	found by address by queueDone(), setReg() and pollNext() find their room again by 
+	its thermostat's address, and collectSyncStats() works from a list of addresses. 
+	Neither the watchdog nor the phase being timed count the time parked. Returns 1 if 
+	the radio was handed over. 
+****************************************************************************************/
+int radioPass(void)
+{
+	int phase = wdPhase;
+	
+	if(radioHeld || !radioYield())
+	{
+		return 0;//never from the menu thread while it holds the radio.
+	}
+	wdCycle();//the time parked does not count against this cycle.
+	wdPhase = phase;
+	return 1;
+}
+
+/****************************************************************************************
+void radioNap(int ms)
+	Description: This function is used by the main loop in place of delay() while it 
+	waits for radio traffic. It sleeps for the given number of milliseconds, but returns 
+	at once when the menu thread asks for the radio, or when the nRF24L01 IRQ falls if 
+	it is wired. Without the IRQ a frame that arrives during the nap is only read once 
+	the nap is over. 
+****************************************************************************************/
+void radioNap(int ms)
+{
+	pthread_mutex_lock(&radioMutex);
+	if(!radioWanted && !radioIrq)
+	{
+		clockWait(&radioCond, &radioMutex, ms);
+	}
+	radioIrq = 0;
+	pthread_mutex_unlock(&radioMutex);
+	return;
+}
+
+/****************************************************************************************
+void radioIrqISR(void)
+	Description: This function runs when the nRF24L01 IRQ falls, a frame was received or 
+	sent. It wakes the main loop from radioNap(); a fall before the nap is kept in 
+	radioIrq so it is not missed. 
+****************************************************************************************/
+void radioIrqISR(void)
+{
+	pthread_mutex_lock(&radioMutex);
+	radioIrq = 1;
+	clockWake(&radioCond);
+	pthread_mutex_unlock(&radioMutex);
+	return;
+}
+
+/****************************************************************************************
+void initTasks(void)
+	Description: This function sets the period and deadline of every main loop task. 
+	Each task runs on its own period, whatever the number of rooms. 
+****************************************************************************************/
+void initTasks(void)
+{
+	taskInit(taskControl, controlPeriod, controlDeadline);
+	taskInit(taskActuate, actuatePeriod, actuateDeadline);
+	taskInit(taskUI, uiPeriod, uiDeadline);
+	taskInit(taskSync, syncPeriod, syncPeriod);
+	taskInit(taskStats, statsPeriod, statsPeriod);
+	return;
+}
+
+/****************************************************************************************
+void mainCycle(void)
+	Description: This function is one pass of the main loop. It runs the tasks that are 
+	due, then polls the next room that is due or, if none is, idles taking in pushed 
+	temperatures until something is. It is kept apart from main() so the bench can run 
+	the same pass on the virtual clock. 
+****************************************************************************************/
+void mainCycle(void)
+{
+	unsigned int now;
+	unsigned int start;
+	int wait;
+	int radioWait;
+	
+	wdCycle();//a new cycle, the watchdog times it from here.
+	if(wdTripped)
+	{
+		wdTripped = 0;
+		hvacTrip();//the watchdog turned the hvac off during the last cycle.
+	}
+	if(radioYield())//if the user initiated an "add device", the menu had the radio until done.
+	{
+		wdCycle();//the time parked does not count against this cycle.
+	}
+	
+	now = millis();
+	if(taskDue(taskControl, now))
+	{
+		taskStart(taskControl, now);
+		start = phaseBegin(phaseDiff);
+		calcDiff();//determine temperature difference and if the hvac needs to turn on. 
+		phaseEnd(phaseDiff, start);
+		start = phaseBegin(phaseHvac);
+		hvacControl();//turn on/off the hvac system if needed and calculate rates of change.
+		phaseEnd(phaseHvac, start);
+		taskKick(taskActuate);//send the new flows straight away.
+	}
+	if(taskDue(taskActuate, millis()))
+	{
+		taskStart(taskActuate, millis());
+		start = phaseBegin(phaseSetReg);
+		setReg();//set the registers where they need to be. 
+		phaseEnd(phaseSetReg, start);
+	}
+	if(taskDue(taskUI, millis()))
+	{
+		taskStart(taskUI, millis());
+		refreshStatus();//show connection errors or the normal status on the LCD.
+	}
+	if(taskDue(taskSync, millis()))
+	{
+		taskStart(taskSync, millis());
+		collectSyncStats();//ask each device how far its clock drifted.
+		printSyncStats();
+	}
+	if(taskDue(taskStats, millis()))
+	{
+		taskStart(taskStats, millis());
+		printTaskStats();//runs and missed deadlines of the tasks above.
+		printPhaseStats();//run time percentiles of each phase of the control cycle.
+		printPollStats();//how often each room is being polled.
+		printQueueStats();//decision to send latency for each message class.
+		printActStats();//decision to actuation latency of flow changes.
+		printGetLatency();//time spent in each radio read.
+		if(dutyMode)
+		{
+			printDutyStats();//share of time the radio was powered.
+		}
+	}
+	
+	now = millis();
+	if(pollWait(now) == 0)
+	{
+		if(fleetCaps() & capBeacon)
+		{
+			sendBeacon(beaconInterval);//align the devices' clocks while they are awake.
+		}
+		start = phaseBegin(phasePoll);
+		pollNext(now);//one room per pass so the tasks above keep their periods.
+		phaseEnd(phasePoll, start);
+	}
+	else
+	{
+		//idle until the next room or task is due, taking in temperatures pushed by 
+		//subscribed thermostats meanwhile.
+		wait = taskWait(now);
+		if(pollWait(now) < wait)
+		{
+			wait = pollWait(now);
+		}
+		if(dutyMode)
+		{
+			//only polls, control (which actuates) and sync statistics need the radio.
+			radioWait = pollWait(now);
+			if(taskLeft(taskControl, now) < radioWait)
+			{
+				radioWait = taskLeft(taskControl, now);
+			}
+			if(taskLeft(taskActuate, now) < radioWait)
+			{
+				radioWait = taskLeft(taskActuate, now);
+			}
+			if(taskLeft(taskSync, now) < radioWait)
+			{
+				radioWait = taskLeft(taskSync, now);
+			}
+			dutyRest(now + radioWait);//sleep the radios until then.
+		}
+		ingestTemps(wait);
+	}
+	return;
+}
@@ -0,0 +1,49 @@
+/**************************************************************************
+*	trace.h
+*
+*	OBJECTIVE:
+*	This file defines the layout of the radio frame trace written by
+*	messaging.c and read by the traceDecode tool.
+*
+*	DEFINITIONS:
+*	The trace file is one header followed by traceCapacity records. Each
+*	frame sent or received is written to the record at (seq % capacity),
+*	so the file always holds the most recent frames. Records with seq 0
+*	have not been written yet.
+*
+**************************************************************************/
+#ifndef		Trace_H
+#define		Trace_H
+
+#include <stdint.h>
+
+#define traceMagic		0x52544652	// "RFTR"
+#define traceVersion	1
+#define traceCapacity	8192		// records kept in the ring file
+#define traceFile		"/var/log/rftrace.bin"
+
+// Frame direction
+#define traceTX			1
+#define traceRX			2
+
+struct traceHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t recordSize;
+	uint32_t capacity;
+	uint32_t reserved[5];
+};
+
+struct traceRecord
+{
+	uint64_t usec;			// CLOCK_MONOTONIC microseconds
+	uint32_t seq;			// frame number, starting at 1
+	uint8_t dir;			// traceTX or traceRX
+	uint8_t stat;			// nRF24L01 STATUS
+	uint8_t retry;			// earlier unACKed sends to the same address
+	uint8_t frame[11];		// raw payload: dest, source, type, val1, val2
+	uint8_t reserved[6];
+};
+
+#endif
@@ -0,0 +1,358 @@
+/**************************************************************************
+*	traceDecode.c
+*
+*	OBJECTIVE:
+*	Offline tool that reads the binary radio frame trace written by
+*	traceFrame() in messaging.c. It prints the frames in order, filters
+*	them, and computes per-device ACK latency and loss. It runs on any
+*	host, not only the Raspberry Pi:
+*
+*		gcc -o traceDecode traceDecode.c
+*		traceDecode [-a addr] [-t type] [-d tx|rx] [-s] [-q] file
+*
+*		-a addr	only frames sent to or from addr (hex or decimal)
+*		-t type	only frames of this message type
+*		-d dir	only sent (tx) or received (rx) frames
+*		-s		print per-device statistics
+*		-q		do not print the frames
+*
+*	FUNCTIONS:
+*		msgName()		- returns the name of a message type
+*		bySeq()			- qsort compare on record seq
+*		frameVal()		- decodes a 32 bit value from a frame
+*		expectsAck()	- tells if a sent frame type is ACKed
+*		printStats()	- prints per-device latency and loss
+*		main()
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+// messaging.h prototypes need wiringPi's thread macro
+#define PI_THREAD(X) void *X(void *dummy)
+#include "messaging.h"
+
+#define ackWindow		2000000		// us a sent frame may wait for its ACK
+
+/**************************************************************************
+*	msgName()
+*
+*	PARAMETERS:
+*		Input:	int message type
+*		Output: char pointer to the name, or NULL if unknown
+*
+**************************************************************************/
+char *msgName(int type)
+{
+	switch(type)
+	{
+		case SEND_BYTE:		return "SEND_BYTE";
+		case RETURN_BYTE:	return "RETURN_BYTE";
+		case ACK:			return "ACK";
+		case SET_TEMP:		return "SET_TEMP";
+		case GET_TEMPS:		return "GET_TEMPS";
+		case RETURN_TEMPS:	return "RETURN_TEMPS";
+		case GET_HUM:		return "GET_HUM";
+		case RETURN_HUM:	return "RETURN_HUM";
+		case GET_FLOW:		return "GET_FLOW";
+		case RETURN_FLOW:	return "RETURN_FLOW";
+		case SET_FLOW:		return "SET_FLOW";
+		case SET_GROUP:		return "SET_GROUP";
+		case GROUP_FLOW:	return "GROUP_FLOW";
+		case SUBSCRIBE:		return "SUBSCRIBE";
+		case SLEEP_UNTIL:	return "SLEEP_UNTIL";
+		case TIME_BEACON:	return "TIME_BEACON";
+		case GET_SYNC_STATS:	return "GET_SYNC_STATS";
+		case RETURN_SYNC_STATS:	return "RETURN_SYNC_STATS";
+		case RELAY:			return "RELAY";
+		case RELAY_RESULT:	return "RELAY_RESULT";
+		case GET_TELEMETRY:	return "GET_TELEMETRY";
+		case RETURN_TELEMETRY:	return "RETURN_TELEMETRY";
+		case GET_BATCH:		return "GET_BATCH";
+		case RETURN_BATCH:	return "RETURN_BATCH";
+		case CREATE_ADDR:	return "CREATE_ADDR";
+		case SET_ADDR:		return "SET_ADDR";
+		case REJECT_ADDR:	return "REJECT_ADDR";
+		case RECEIVED_ADDR:	return "RECEIVED_ADDR";
+		case ADDR_NOT_SET:	return "ADDR_NOT_SET";
+	}
+	return NULL;
+}
+
+/**************************************************************************
+*	bySeq()
+*
+*	qsort() compare function ordering trace records by seq.
+*
+**************************************************************************/
+int bySeq(const void *a, const void *b)
+{
+	uint32_t seqA = ((struct traceRecord *)a)->seq;
+	uint32_t seqB = ((struct traceRecord *)b)->seq;
+
+	return (seqA > seqB) - (seqA < seqB);
+}
+
+/**************************************************************************
+*	frameVal()
+*
+*	PARAMETERS:
+*		Input:	unsigned char pointer to the frame
+*				int index of the value's first byte (3 or 7)
+*		Output: int decoded value
+*
+**************************************************************************/
+int frameVal(unsigned char *frame, int first)
+{
+	return (frame[first] << 24)|(frame[first + 1] << 16)|(frame[first + 2] << 8)|(frame[first + 3]);
+}
+
+/**************************************************************************
+*	expectsAck()
+*
+*	Mirrors the frame types sendMessage() does not wait an ACK for.
+*
+*	PARAMETERS:
+*		Input:	int message type
+*		Output: integer (1) the receiver ACKs this type, (0) it does not
+*
+**************************************************************************/
+int expectsAck(int type)
+{
+	switch(type)
+	{
+		case ACK:
+		case CREATE_ADDR:
+		case SET_ADDR:
+		case REJECT_ADDR:
+		case RECEIVED_ADDR:
+		case ADDR_NOT_SET:
+		case GROUP_FLOW:
+		case SLEEP_UNTIL:
+		case TIME_BEACON:
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**************************************************************************
+*	printStats()
+*
+*	For every address frames were sent to, matches each sent frame with
+*	the ACK that came back from that address within ackWindow, then
+*	prints the count, loss and ACK latency.
+*
+*	PARAMETERS:
+*		Input:	struct traceRecord pointer to the records in seq order
+*				int number of records
+*				int address filter, (-1) for all
+*		Output: none
+*
+**************************************************************************/
+void printStats(struct traceRecord *rec, int count, int addrFilter)
+{
+	int sent[256];
+	int acked[256];
+	int maxRetry[256];
+	uint64_t latTotal[256];
+	uint64_t latMin[256];
+	uint64_t latMax[256];
+	uint64_t lat;
+	int i;
+	int j;
+	int dest;
+	int found;
+
+	memset(sent, 0, sizeof(sent));
+	memset(acked, 0, sizeof(acked));
+	memset(maxRetry, 0, sizeof(maxRetry));
+	memset(latTotal, 0, sizeof(latTotal));
+	memset(latMax, 0, sizeof(latMax));
+	for(i = 0; i < 256; i++)
+	{
+		latMin[i] = (uint64_t)-1;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		if((rec[i].dir != traceTX) || !expectsAck(rec[i].frame[2]))
+		{
+			continue;
+		}
+		dest = rec[i].frame[0];
+		sent[dest]++;
+		if(rec[i].retry > maxRetry[dest])
+		{
+			maxRetry[dest] = rec[i].retry;
+		}
+
+		found = 0;
+		for(j = i + 1; (j < count) && ((rec[j].usec - rec[i].usec) < ackWindow) && (rec[j].usec >= rec[i].usec); j++)
+		{
+			if((rec[j].dir == traceRX) && (rec[j].frame[1] == dest) && (rec[j].frame[2] == ACK) &&
+			(rec[j].frame[6] == rec[i].frame[2]) && (frameVal(rec[j].frame, 7) == frameVal(rec[i].frame, 3)))
+			{
+				found = 1;
+				break;
+			}
+			if((rec[j].dir == traceTX) && (rec[j].frame[0] == dest))
+			{
+				break;	// sent again before an ACK came back
+			}
+		}
+		if(found)
+		{
+			lat = rec[j].usec - rec[i].usec;
+			acked[dest]++;
+			latTotal[dest] += lat;
+			if(lat < latMin[dest])
+			{
+				latMin[dest] = lat;
+			}
+			if(lat > latMax[dest])
+			{
+				latMax[dest] = lat;
+			}
+		}
+	}
+
+	printf("\n addr    sent   acked   loss%%   ack min/avg/max ms    max retry\n");
+	for(i = 0; i < 256; i++)
+	{
+		if(!sent[i] || ((addrFilter >= 0) && (i != addrFilter)))
+		{
+			continue;
+		}
+		printf(" %#.2x  %6d  %6d  %6.1f", i, sent[i], acked[i], (100.0 * (sent[i] - acked[i])) / sent[i]);
+		if(acked[i])
+		{
+			printf("   %6.1f/%6.1f/%6.1f", latMin[i] / 1000.0, (latTotal[i] / (double)acked[i]) / 1000.0, latMax[i] / 1000.0);
+		}
+		else
+		{
+			printf("        -/     -/     -");
+		}
+		printf("   %6d\n", maxRetry[i]);
+	}
+	return;
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *fp;
+	struct traceHeader header;
+	struct traceRecord *rec;
+	char *path = NULL;
+	char *name;
+	int addrFilter = -1;
+	int typeFilter = -1;
+	int dirFilter = 0;
+	int stats = 0;
+	int quiet = 0;
+	int count = 0;
+	int i;
+
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "-a") && (i + 1 < argc))
+		{
+			addrFilter = strtol(argv[++i], NULL, 0);
+		}
+		else if(!strcmp(argv[i], "-t") && (i + 1 < argc))
+		{
+			typeFilter = strtol(argv[++i], NULL, 0);
+		}
+		else if(!strcmp(argv[i], "-d") && (i + 1 < argc))
+		{
+			i++;
+			dirFilter = (!strcmp(argv[i], "tx")) ? traceTX : traceRX;
+		}
+		else if(!strcmp(argv[i], "-s"))
+		{
+			stats = 1;
+		}
+		else if(!strcmp(argv[i], "-q"))
+		{
+			quiet = 1;
+		}
+		else
+		{
+			path = argv[i];
+		}
+	}
+	if(path == NULL)
+	{
+		printf("usage: %s [-a addr] [-t type] [-d tx|rx] [-s] [-q] file\n", argv[0]);
+		return 1;
+	}
+
+	fp = fopen(path, "rb");
+	if(fp == NULL)
+	{
+		printf("%s could not be opened\n", path);
+		return 1;
+	}
+	if((fread(&header, sizeof(header), 1, fp) != 1) || (header.magic != traceMagic) ||
+	(header.version != traceVersion) || (header.recordSize != sizeof(struct traceRecord)))
+	{
+		printf("%s is not a version %d frame trace\n", path, traceVersion);
+		fclose(fp);
+		return 1;
+	}
+	rec = malloc(header.capacity * sizeof(struct traceRecord));
+	if((rec == NULL) || (fread(rec, sizeof(struct traceRecord), header.capacity, fp) != header.capacity))
+	{
+		printf("%s is truncated\n", path);
+		fclose(fp);
+		return 1;
+	}
+	fclose(fp);
+
+	// Keep the written records, oldest first
+	for(i = 0; i < header.capacity; i++)
+	{
+		if(rec[i].seq != 0)
+		{
+			rec[count++] = rec[i];
+		}
+	}
+	qsort(rec, count, sizeof(struct traceRecord), bySeq);
+
+	if(!quiet)
+	{
+		printf("     seq        time ms  dir  dest  src   type             val1         val2  stat retry\n");
+		for(i = 0; i < count; i++)
+		{
+			if(((addrFilter >= 0) && (rec[i].frame[0] != addrFilter) && (rec[i].frame[1] != addrFilter)) ||
+			((typeFilter >= 0) && (rec[i].frame[2] != typeFilter)) ||
+			(dirFilter && (rec[i].dir != dirFilter)))
+			{
+				continue;
+			}
+			printf("%8u %14.3f  %s  %#.2x  %#.2x  ", rec[i].seq, (rec[i].usec - rec[0].usec) / 1000.0,
+			(rec[i].dir == traceTX) ? "TX" : "RX", rec[i].frame[0], rec[i].frame[1]);
+			name = msgName(rec[i].frame[2]);
+			if(name != NULL)
+			{
+				printf("%-13s", name);
+			}
+			else
+			{
+				printf("%#-13.2x", rec[i].frame[2]);
+			}
+			printf(" %12d %12d  %#.2x %5d\n", frameVal(rec[i].frame, 3), frameVal(rec[i].frame, 7), rec[i].stat, rec[i].retry);
+		}
+	}
+	printf("\n%d frames in %s\n", count, path);
+
+	if(stats)
+	{
+		printStats(rec, count, addrFilter);
+	}
+	free(rec);
+	return 0;
+}